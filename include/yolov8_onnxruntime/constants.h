@@ -14,6 +14,7 @@ inline const std::string VERSION = "version";
 inline const std::string TASK = "task";
 inline const std::string BATCH = "batch";
 inline const std::string NAMES = "names";
+inline const std::string END2END = "end2end";
 } // namespace MetadataConstants
 
 enum class OnnxProviders_t
@@ -57,6 +58,28 @@ inline const std::string DETECT = "detect";
 inline const std::string POSE = "pose";
 inline const std::string CLASSIFY = "classify";
 } // namespace YoloTasks
+
+enum class YoloTasks_t
+{
+  DETECT,
+  SEGMENT,
+  POSE,
+  CLASSIFY,
+  UNKNOWN
+};
+
+inline YoloTasks_t YoloTaskFromString(const std::string& task)
+{
+  if (task == YoloTasks::DETECT)
+    return YoloTasks_t::DETECT;
+  if (task == YoloTasks::SEGMENT)
+    return YoloTasks_t::SEGMENT;
+  if (task == YoloTasks::POSE)
+    return YoloTasks_t::POSE;
+  if (task == YoloTasks::CLASSIFY)
+    return YoloTasks_t::CLASSIFY;
+  return YoloTasks_t::UNKNOWN;
+}
 } // namespace yolov8_onnxruntime
 
 #endif // YOLOV8_ONNXRUNTIME_CONSTANTS_H
\ No newline at end of file
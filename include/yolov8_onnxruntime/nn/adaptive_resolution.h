@@ -0,0 +1,109 @@
+#ifndef YOLOV8_ONNXRUNTIME_ADAPTIVE_RESOLUTION_H
+#define YOLOV8_ONNXRUNTIME_ADAPTIVE_RESOLUTION_H
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <opencv2/core/mat.hpp>
+
+#include "yolov8_onnxruntime/nn/autobackend.h"
+#include "yolov8_onnxruntime/nn/workspace.h"
+#include "yolov8_onnxruntime/types.h"
+#include "yolov8_onnxruntime/utils/yuv.h"
+
+namespace yolov8_onnxruntime
+{
+
+/**
+ * @brief One resolution to run at: a model exported at its own imgsz (input_size left empty), or
+ * an input_size bucket of a model with dynamic height and width.
+ */
+struct ResolutionVariant
+{
+  std::shared_ptr<const AutoBackendOnnx> model;
+  cv::Size input_size;
+};
+
+struct AdaptiveResolutionOptions
+{
+  /// Latency one request should take, preprocessing to results.
+  double target_latency_ms = 50.0;
+  /// Step down a resolution once the smoothed latency exceeds target * downgrade_ratio.
+  double downgrade_ratio = 1.0;
+  /**
+   * Step back up once the latency predicted for the next larger resolution (the smoothed latency
+   * scaled by the pixel ratio) is below target * upgrade_ratio. The gap to downgrade_ratio is
+   * the hysteresis that keeps the resolution from flapping.
+   */
+  double upgrade_ratio = 0.7;
+  /// Step down as well while more requests than this run at once, 0 to ignore concurrency.
+  size_t max_in_flight = 0;
+  /// Requests to complete at a resolution before it may change again.
+  size_t min_dwell = 20;
+  /// Weight of the newest latency in the moving average.
+  double smoothing = 0.2;
+};
+
+/**
+ * @brief Results together with the resolution they were computed at.
+ */
+struct AdaptiveResults
+{
+  std::vector<YoloResults> results; ///< in the frame's coordinates, whatever the resolution
+  cv::Size input_size;              ///< network input size the request ran at
+  size_t variant = 0;               ///< index into the variants, largest first
+};
+
+/**
+ * @brief Picks the input resolution per request from the current load.
+ *
+ * Requests run at the largest variant while the smoothed latency meets the target. When it does
+ * not (or too many requests are in flight), later requests step down to the next smaller variant
+ * instead of queueing, and step back up once the larger one is predicted to fit again. Letterbox
+ * geometry is resolved per request from the size it actually ran at, so boxes, keypoints and
+ * masks stay in frame coordinates at every resolution.
+ *
+ * predict() may be called from any number of threads, each with its own workspace.
+ */
+class AdaptiveResolution
+{
+public:
+  /// variants are reordered from the largest input to the smallest, all must share one task.
+  AdaptiveResolution(std::vector<ResolutionVariant> variants,
+                     const AdaptiveResolutionOptions& options = {});
+
+  AdaptiveResults
+  predict(const cv::Mat& image, const PredictOptions& options, InferenceWorkspace& workspace);
+  AdaptiveResults
+  predict(const YuvImage& frame, const PredictOptions& options, InferenceWorkspace& workspace);
+
+  const std::vector<ResolutionVariant>& getVariants() const { return variants_; }
+  size_t currentVariant() const;
+  cv::Size currentInputSize() const { return variants_[currentVariant()].input_size; }
+  /// Smoothed latency at the current variant, 0 before its first sample.
+  double latencyMs() const;
+  size_t inFlight() const { return in_flight_.load(); }
+
+private:
+  template <typename Image>
+  AdaptiveResults
+  run(const Image& image, const PredictOptions& options, InferenceWorkspace& workspace);
+  /// Applies the switching rules and returns the variant for a new request.
+  size_t select(size_t in_flight);
+  void record(size_t variant, double latency_ms);
+
+  std::vector<ResolutionVariant> variants_;
+  AdaptiveResolutionOptions options_;
+  std::atomic<size_t> in_flight_{0};
+
+  mutable std::mutex mutex_;
+  size_t current_ = 0;
+  double latency_ms_ = 0.0;
+  size_t samples_ = 0; // completed at current_ since the last switch
+};
+
+} // namespace yolov8_onnxruntime
+
+#endif // YOLOV8_ONNXRUNTIME_ADAPTIVE_RESOLUTION_H
@@ -1,13 +1,19 @@
 #ifndef YOLOV8_ONNXRUNTIME_AUTOBACKEND_H
 #define YOLOV8_ONNXRUNTIME_AUTOBACKEND_H
+#include <atomic>
+#include <chrono>
 #include <filesystem>
 #include <opencv2/core/mat.hpp>
 #include <unordered_map>
 #include <vector>
 
 #include "yolov8_onnxruntime/constants.h"
+#include "yolov8_onnxruntime/nn/detection_sink.h"
 #include "yolov8_onnxruntime/nn/onnx_model_base.h"
+#include "yolov8_onnxruntime/nn/workspace.h"
 #include "yolov8_onnxruntime/utils/common.h"
+#include "yolov8_onnxruntime/utils/ops.h"
+#include "yolov8_onnxruntime/utils/yuv.h"
 
 #include "yolov8_onnxruntime/types.h"
 
@@ -16,6 +22,72 @@
 namespace yolov8_onnxruntime
 {
 
+struct WarmupOptions
+{
+  /// Batch sizes to warm up, empty means the model's static batch (or 1 if it is dynamic).
+  std::vector<int> batch_sizes;
+  /// Input tensor sizes to warm up (only differing from imgsz for dynamic H/W models), empty means
+  /// imgsz.
+  std::vector<cv::Size> input_sizes;
+  int min_iterations = 3;
+  /// Runs per shape at most, warmup() throws std::invalid_argument when it is below 1.
+  int max_iterations = 30;
+  /// A shape is steady once a run is within this relative distance of the median of the last 3.
+  double tolerance = 0.10;
+  bool verbose = true;
+};
+
+struct WarmupShapeReport
+{
+  int batch = 1;
+  cv::Size input_size;
+  int iterations = 0;
+  double first_ms = 0.0;  ///< latency of the very first run of this shape
+  double steady_ms = 0.0; ///< median of the last runs once latency settled
+  bool steady = false;
+};
+
+struct WarmupReport
+{
+  std::vector<WarmupShapeReport> shapes;
+  double pipeline_first_ms = 0.0;  ///< first full predict (preprocess + inference + postprocess)
+  double pipeline_steady_ms = 0.0; ///< the same call after the session warmup
+  bool ready = false;
+};
+
+/**
+ * @brief Wall time of the stages of one AutoBackendOnnx::predict call.
+ */
+struct PredictTimings
+{
+  double preprocess_ms = 0.0;
+  double inference_ms = 0.0;
+  double postprocess_ms = 0.0;
+};
+
+/**
+ * @brief Per-call settings of AutoBackendOnnx::predict.
+ */
+struct PredictOptions
+{
+  float conf = 0.25f;
+  float iou = 0.45f;
+  float mask_threshold = 0.5f;
+  /// Applied to a workspace copy of the image, e.g. cv::COLOR_BGR2RGB; -1 for none.
+  int conversionCode = -1;
+  /// Channel order YUV frames are converted to: RGB, what exported models expect, or BGR.
+  bool yuv_to_rgb = true;
+  /// Network input size for models with dynamic height and width, empty for the model's imgsz.
+  cv::Size input_size;
+  /// Filled with the stage timings when set.
+  PredictTimings* timings = nullptr;
+  /**
+   * @brief Past it predict() throws DeadlineExceeded instead of returning results: before
+   * preprocessing, by terminating the session run, or before postprocessing.
+   */
+  Deadline deadline = NO_DEADLINE;
+};
+
 class AutoBackendOnnx : public OnnxModelBase
 {
 public:
@@ -26,9 +98,13 @@ public:
                   const std::vector<int>& imgsz,
                   const int& stride,
                   const int& nc,
-                  std::unordered_map<int, std::string> names);
+                  std::unordered_map<int, std::string> names,
+                  const SessionConfig& config = {});
 
-  AutoBackendOnnx(const char* modelPath, const char* logid, const OnnxProviders_t provider);
+  AutoBackendOnnx(const char* modelPath,
+                  const char* logid,
+                  const OnnxProviders_t provider,
+                  const SessionConfig& config = {});
 
   // getters
   std::vector<int> getImgsz() const { return imgsz_; }
@@ -40,7 +116,18 @@ public:
   int getWidth() const { return imgsz_[1]; }
   int getHeight() const { return imgsz_[0]; }
   cv::Size getCvSize() const { return cvSize_; }
+  /**
+   * @brief The network input size a request for requested runs at: imgsz when empty, else
+   * requested. Throws std::invalid_argument unless the model's input height and width are dynamic
+   * and requested is a multiple of the stride.
+   */
+  cv::Size resolveInputSize(const cv::Size& requested) const;
   std::string getTask() const { return task_; }
+  YoloTasks_t getTaskType() const { return task_type_; }
+  /// True for models ending in NonMaxSuppression (see scripts/export_end2end.py).
+  bool isEndToEnd() const { return end2end_; }
+  /// Largest number of images one session call accepts, 0 if the batch dimension is dynamic.
+  int getMaxBatch() const;
 
   int getClassIdx(const std::string& className) const
   {
@@ -69,6 +156,10 @@ public:
    * here
    *
    * @return A vector of YoloResults representing the detected objects.
+   *
+   * Not thread-safe: all overloads reuse buffers owned by the model, so calls on one model must
+   * not overlap, and neither may predict_batch(). Threads sharing a model call predict() with a
+   * workspace each.
    */
   virtual std::vector<YoloResults> predict_once(cv::Mat& image,
                                                 float& conf,
@@ -89,6 +180,82 @@ public:
                                                 int conversionCode = -1,
                                                 bool verbose = true);
 
+  /**
+   * @brief Reentrant prediction that leaves image untouched.
+   *
+   * Unlike predict_once, all per-call state lives in workspace, so any number of threads may
+   * predict concurrently on one model (and share its weights), each with its own workspace.
+   * Reusing a workspace across calls keeps the steady state free of buffer allocations.
+   */
+  std::vector<YoloResults>
+  predict(const cv::Mat& image, PredictOptions options, InferenceWorkspace& workspace) const;
+  /// Same as above, with results reported in image_info's frame (see predict_image).
+  std::vector<YoloResults> predict(const cv::Mat& image,
+                                   const ImageInfo& image_info,
+                                   PredictOptions options,
+                                   InferenceWorkspace& workspace) const;
+  /// Same as above with a workspace of its own, convenient but allocating on every call.
+  std::vector<YoloResults> predict(const cv::Mat& image, PredictOptions options = {}) const;
+  /**
+   * @brief predict() of a YUV frame, e.g. NV12 straight from a capture device.
+   *
+   * Color conversion, letterbox and normalization run as one pass into the input tensor, without
+   * a BGR copy of the frame (classification models still convert for their center crop). Results
+   * are in frame coordinates, options.conversionCode is not used.
+   */
+  std::vector<YoloResults>
+  predict(const YuvImage& frame, PredictOptions options, InferenceWorkspace& workspace) const;
+  /**
+   * @brief predict() handing every detection to sink once its box is final instead of returning
+   * them all, with instance masks decoded only for the detections the sink calls mask() on.
+   *
+   * The sink runs on the calling thread. The detections do not refer to workspace, so the sink
+   * may keep them (see StreamedDetection) and predict with the same workspace.
+   *
+   * @return The number of detections handed to sink.
+   */
+  size_t predict_stream(const cv::Mat& image,
+                        const DetectionSink& sink,
+                        PredictOptions options,
+                        InferenceWorkspace& workspace) const;
+  /// predict_stream() handing all detections of the image to sink at once, e.g. to filter them
+  /// first and decode the remaining masks together with StreamedDetection::decodeMasks().
+  size_t predict_stream_batch(const cv::Mat& image,
+                              const DetectionBatchSink& sink,
+                              PredictOptions options,
+                              InferenceWorkspace& workspace) const;
+
+  /**
+   * @brief Runs prediction on several images with as few session calls as the model allows.
+   *
+   * Images are stacked into one [N, C, H, W] tensor. Models with a dynamic batch dimension get all
+   * images at once, models exported with a static batch get chunks of getMaxBatch() images (the
+   * last chunk is zero padded).
+   *
+   * @param images The input images, converted in place when conversionCode is set.
+   * @param image_infos Frame each image's results are reported in (see predict_image).
+   *
+   * @return One vector of YoloResults per input image, in input order.
+   *
+   * Not thread-safe, it shares the model's buffers with predict_once() (see there).
+   */
+  virtual std::vector<std::vector<YoloResults>> predict_batch(std::vector<cv::Mat>& images,
+                                                              float& conf,
+                                                              float& iou,
+                                                              float& mask_threshold,
+                                                              int conversionCode = -1,
+                                                              bool verbose = false);
+  /// @param deadline Throws DeadlineExceeded once it passed, see PredictOptions::deadline.
+  virtual std::vector<std::vector<YoloResults>>
+  predict_batch(std::vector<cv::Mat>& images,
+                const std::vector<ImageInfo>& image_infos,
+                float& conf,
+                float& iou,
+                float& mask_threshold,
+                int conversionCode = -1,
+                bool verbose = false,
+                Deadline deadline = NO_DEADLINE);
+
   std::pair<cv::Size, std::vector<float>> preprocess(cv::Mat& image,
                                                      float*& blob,
                                                      std::vector<int64_t>& inputTensorShape,
@@ -102,7 +269,10 @@ public:
                       Timer& timer);
 
   virtual void fill_blob(cv::Mat& image, float*& blob, std::vector<int64_t>& inputTensorShape);
-  virtual void postprocess_masks(cv::Mat& output0,
+  // output0 of the postprocess_* functions is one image's raw [features, preds] head output,
+  // their scratch vectors come from workspace
+  virtual void postprocess_masks(InferenceWorkspace& workspace,
+                                 cv::Mat& output0,
                                  cv::Mat& output1,
                                  ImageInfo para,
                                  std::vector<YoloResults>& output,
@@ -114,22 +284,59 @@ public:
                                  int& mw,
                                  int& mh,
                                  int& masks_features_num,
-                                 float mask_threshold = 0.50f);
+                                 float mask_threshold = 0.50f,
+                                 std::vector<MaskDecoder>* deferred_masks = nullptr) const;
 
-  virtual void postprocess_detects(cv::Mat& output0,
+  virtual void postprocess_detects(InferenceWorkspace& workspace,
+                                   cv::Mat& output0,
                                    ImageInfo image_info,
                                    std::vector<YoloResults>& output,
                                    int& class_names_num,
                                    float& conf_threshold,
-                                   float& iou_threshold);
-  virtual void postprocess_kpts(cv::Mat& output0,
-                                ImageInfo& image_info,
+                                   float& iou_threshold) const;
+  virtual void postprocess_kpts(InferenceWorkspace& workspace,
+                                cv::Mat& output0,
+                                const ImageInfo& image_info,
                                 std::vector<YoloResults>& output,
                                 int& class_names_num,
                                 float& conf_threshold,
-                                float& iou_threshold);
+                                float& iou_threshold) const;
+
+  void postprocess_classify(cv::Mat& outputTensor, std::vector<YoloResults>& results) const;
+
+  /**
+   * @brief Reads the final detections of an end-to-end model, there is no candidate decoding or
+   * NMS left to do on the host.
+   *
+   * output0 holds the [K, 7 + extra] rows (batch, class, score, cx, cy, w, h, extra...) of the
+   * whole batch, only the rows of batch_idx are reported. Segment models still decode the masks
+   * from output1's protos.
+   */
+  void postprocess_end2end(InferenceWorkspace& workspace,
+                           std::vector<Ort::Value>& outputTensors,
+                           size_t batch_idx,
+                           const ImageInfo& image_info,
+                           std::vector<YoloResults>& output,
+                           float conf_threshold,
+                           float mask_threshold,
+                           std::vector<MaskDecoder>* deferred_masks = nullptr) const;
 
-  void postprocess_classify(cv::Mat& outputTensor, std::vector<YoloResults>& results);
+  /**
+   * @brief Dispatches the outputs of image batch_idx to the postprocessing of the model's task.
+   *
+   * @param deferred_masks When set, segmentation masks are not decoded: it receives one decoder
+   * per result instead, valid while the tensors of outputTensors are (it copies what it needs of
+   * workspace).
+   */
+  void postprocess(InferenceWorkspace& workspace,
+                   std::vector<Ort::Value>& outputTensors,
+                   size_t batch_idx,
+                   const ImageInfo& image_info,
+                   std::vector<YoloResults>& results,
+                   float& conf,
+                   float& iou,
+                   float& mask_threshold,
+                   std::vector<MaskDecoder>* deferred_masks = nullptr) const;
 
   static void _get_mask2(const cv::Mat& mask_info,
                          const cv::Mat& mask_data,
@@ -143,11 +350,112 @@ public:
                          int& mh,
                          int& masks_features_num,
                          bool round_downsampled = false);
+  /**
+   * @brief Decodes one instance mask from its coefficients and the protos of its image, cut to
+   * bound (source coordinates) and thresholded.
+   *
+   * Allocates its temporaries and the mask on every call (see InferenceWorkspace), so it can
+   * run concurrently for several instances.
+   *
+   * @param transform Letterbox geometry of the source into the model input.
+   * @param proto_size Width and height of one proto plane.
+   */
+  static void _get_mask2(const cv::Mat& mask_info,
+                         const cv::Mat& mask_data,
+                         const LetterboxTransform& transform,
+                         const cv::Rect& bound,
+                         cv::Mat& mask_out,
+                         float mask_thresh,
+                         const cv::Size& proto_size);
+
+  /**
+   * @brief Runs synthetic inputs until every configured batch size and input shape reached
+   * steady-state latency.
+   *
+   * Covers arena growth, kernel selection and provider compilation (e.g. OpenVINO) so the first
+   * real request does not pay for them. isReady() reports true once every shape settled.
+   *
+   * Uses workspaces of its own, never the one of predict_once(), so it may run while other
+   * threads predict with the model.
+   */
+  WarmupReport warmup(const WarmupOptions& options = {});
+  bool isReady() const { return ready_.load(); }
 
   void loadMetaData();
+  /**
+   * @brief Picks the task and the decode_candidates specialization matching the model metadata,
+   * falling back to the generic decoder for uncommon class counts, and detects end-to-end models
+   * from their metadata or their [K, 7 + extra] detections output.
+   *
+   * This stands in for templated per-task predictor classes behind a factory. The only loop whose
+   * trip count a compile-time constant changes is the class-score reduction of decode_candidates
+   * (nc * preds values per image, 672k for COCO at 640), so that is what gets specialized, through
+   * a function pointer picked here. The task is resolved once too, and postprocess() branches on
+   * it once per image, which costs nothing next to that reduction. NMS, box mapping and mask
+   * decoding do not depend on the task or on nc. Predictor subclasses would specialize nothing
+   * more, but they would split the AutoBackendOnnx interface that ModelHandle, the cascade and the
+   * tools hold.
+   */
+  void selectPostprocess();
   void prettyPrintMetaData();
 
 protected:
+  /**
+   * @brief Runs prediction on an already decoded image and reports results in image_info's frame.
+   *
+   * image_info.raw_size may differ from image.size() when the image was decoded at reduced
+   * resolution, boxes, masks and keypoints are scaled to raw_size in that case.
+   */
+  std::vector<YoloResults> predict_image(cv::Mat& image,
+                                         const ImageInfo& image_info,
+                                         float& conf,
+                                         float& iou,
+                                         float& mask_threshold,
+                                         int conversionCode,
+                                         bool verbose);
+
+  /**
+   * @brief Letterboxes (or center crops for classification) image into workspace.input and sets
+   * workspace.input_shape, reusing the workspace's buffers. A conversionCode >= 0 converts into
+   * workspace.converted first, image itself is never modified.
+   *
+   * @param input_size Network input size, see PredictOptions::input_size.
+   * @return The size of the network input image.
+   */
+  cv::Size preprocess_into(const cv::Mat& image,
+                           InferenceWorkspace& workspace,
+                           int conversionCode,
+                           const cv::Size& input_size = cv::Size()) const;
+  /// Network input size of the tensor preprocessed into workspace, what outputs are relative to.
+  static cv::Size inputSize(const InferenceWorkspace& workspace)
+  {
+    return cv::Size(static_cast<int>(workspace.input_shape[3]),
+                    static_cast<int>(workspace.input_shape[2]));
+  }
+  /**
+   * @brief The session inputs of workspace, with the NMS threshold inputs of end-to-end models set
+   * to conf and iou.
+   */
+  std::vector<Ort::Value>& bindInputs(InferenceWorkspace& workspace, float conf, float iou) const;
+  /**
+   * @brief Inference and postprocessing of the input preprocessed into workspace, the part of
+   * predict() shared by all input types. start is when preprocessing began, for options.timings.
+   *
+   * @param outputs Receives the session outputs when set, to keep deferred_masks valid.
+   * @param deferred_masks See postprocess().
+   */
+  std::vector<YoloResults>
+  predict_prepared(InferenceWorkspace& workspace,
+                   const ImageInfo& image_info,
+                   const PredictOptions& options,
+                   std::chrono::steady_clock::time_point start,
+                   std::vector<Ort::Value>* outputs = nullptr,
+                   std::vector<MaskDecoder>* deferred_masks = nullptr) const;
+  /// Shape of output index, from the model's static output shape when it has one.
+  const std::vector<int64_t>& outputShape(InferenceWorkspace& workspace,
+                                          std::vector<Ort::Value>& outputTensors,
+                                          size_t index) const;
+
   std::vector<int> imgsz_;
   int stride_ = OnnxInitializers::UNINITIALIZED_STRIDE;
   int nc_ = OnnxInitializers::UNINITIALIZED_NC; //
@@ -156,6 +464,16 @@ protected:
   std::vector<int64_t> inputTensorShape_;
   cv::Size cvSize_;
   std::string task_;
+  /// Resolved once from task_ and names_ by selectPostprocess(), so predictions do not compare
+  /// strings or loop over a runtime class count.
+  YoloTasks_t task_type_ = YoloTasks_t::UNKNOWN;
+  DecodeCandidatesFn decode_candidates_ = nullptr;
+  bool end2end_ = false;
+  /// Atomic so isReady() can be polled during warmup(); this makes the class non-movable, hold
+  /// models by pointer (as ModelHandle does) to pass them around.
+  std::atomic<bool> ready_{false};
+  /// Buffers of predict_once and predict_batch, which is why those are not thread-safe.
+  InferenceWorkspace workspace_;
   // cv::MatSize cvMatSize_;
 };
 
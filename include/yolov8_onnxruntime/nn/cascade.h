@@ -0,0 +1,78 @@
+#ifndef YOLOV8_ONNXRUNTIME_CASCADE_H
+#define YOLOV8_ONNXRUNTIME_CASCADE_H
+#include <vector>
+
+#include <opencv2/core/mat.hpp>
+
+#include "yolov8_onnxruntime/nn/autobackend.h"
+#include "yolov8_onnxruntime/types.h"
+
+namespace yolov8_onnxruntime
+{
+
+/**
+ * @brief A detection together with the second-stage classification of its crop.
+ */
+struct CascadeResults
+{
+  YoloResults detection;
+  int cls_class_idx = -1; ///< top-1 classifier class, -1 if the detection was not classified.
+  float cls_conf = 0.0f;  ///< classifier score of cls_class_idx.
+};
+
+struct CascadeOptions
+{
+  float conf = 0.30f;
+  float iou = 0.45f;
+  float mask_threshold = 0.5f;
+  /// Applied once to the frame before detection, e.g. cv::COLOR_BGR2RGB; -1 for none.
+  int conversionCode = -1;
+  /// Detector classes whose crops are classified, empty means all of them.
+  std::vector<int> classes;
+  /// Crops are grown by this fraction of the box size on every side before classification.
+  float crop_padding = 0.0f;
+};
+
+/**
+ * @brief Two-stage detect -> classify pipeline.
+ *
+ * After detection, all crops are cut as views into the frame (no copy of the full frame), center
+ * cropped and resized in parallel straight into one batched classifier tensor, and classified with
+ * as few session calls as the classifier's batch dimension allows. A classifier exported with a
+ * static batch of 1 therefore takes one session call per crop, which the constructor warns about.
+ *
+ * The resized crops and the tensor are kept between calls and only grow, so predict() and
+ * classify() are not thread-safe (neither is the detector's predict_once()).
+ */
+class DetectClassifyCascade
+{
+public:
+  DetectClassifyCascade(AutoBackendOnnx& detector,
+                        AutoBackendOnnx& classifier,
+                        const CascadeOptions& options = {});
+
+  /**
+   * @brief Runs detection and classifies every selected detection.
+   *
+   * @param image Input frame, converted in place when conversionCode is set (like predict_once).
+   */
+  std::vector<CascadeResults> predict(cv::Mat& image);
+
+  /**
+   * @brief Classifies given detections of image, which must already be in the models' color order.
+   */
+  std::vector<CascadeResults> classify(const cv::Mat& image,
+                                       const std::vector<YoloResults>& detections);
+
+private:
+  AutoBackendOnnx& detector_;
+  AutoBackendOnnx& classifier_;
+  CascadeOptions options_;
+  /// One resized crop per tensor slot, reused by the next chunk and the next frame.
+  std::vector<cv::Mat> crops_;
+  std::vector<float> tensorValues_;
+};
+
+} // namespace yolov8_onnxruntime
+
+#endif // YOLOV8_ONNXRUNTIME_CASCADE_H
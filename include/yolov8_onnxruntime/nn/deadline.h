@@ -0,0 +1,104 @@
+#ifndef YOLOV8_ONNXRUNTIME_DEADLINE_H
+#define YOLOV8_ONNXRUNTIME_DEADLINE_H
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <onnxruntime/core/session/onnxruntime_cxx_api.h>
+
+namespace yolov8_onnxruntime
+{
+
+/// Point in time a request is useless after.
+using Deadline = std::chrono::steady_clock::time_point;
+inline constexpr Deadline NO_DEADLINE = Deadline::max();
+
+inline Deadline deadline_in(std::chrono::microseconds budget)
+{
+  return std::chrono::steady_clock::now() + budget;
+}
+
+/**
+ * @brief Raised instead of results when a request ran out of time: dropped before it started, or
+ * its session run was terminated. Postprocessing never runs for such a request.
+ */
+class DeadlineExceeded : public std::runtime_error
+{
+public:
+  using std::runtime_error::runtime_error;
+};
+
+/// Throws DeadlineExceeded naming stage when deadline has passed.
+inline void check_deadline(Deadline deadline, const char* stage)
+{
+  if (deadline != NO_DEADLINE && std::chrono::steady_clock::now() >= deadline)
+    throw DeadlineExceeded(std::string("Error: deadline passed before ") + stage);
+}
+
+/**
+ * @brief One process-wide thread terminating session runs whose deadline passed.
+ *
+ * A run is armed with its Ort::RunOptions and terminated through RunOptions::SetTerminate() once
+ * its deadline passes, so an expired request stops occupying the cores instead of delaying
+ * everything queued behind it. Use RunDeadline rather than arm()/disarm() directly.
+ */
+class RunWatchdog
+{
+public:
+  static RunWatchdog& instance();
+  ~RunWatchdog();
+  RunWatchdog(const RunWatchdog&) = delete;
+  RunWatchdog& operator=(const RunWatchdog&) = delete;
+
+  /// Terminates run_options at deadline unless disarmed before, returns the ticket to disarm.
+  uint64_t arm(Deadline deadline, Ort::RunOptions& run_options);
+  /// Forgets ticket, returns whether its run was terminated.
+  bool disarm(uint64_t ticket);
+  bool fired(uint64_t ticket) const;
+
+private:
+  RunWatchdog();
+  void run();
+
+  struct Entry
+  {
+    Deadline deadline;
+    Ort::RunOptions* run_options;
+    bool fired;
+  };
+
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  std::map<uint64_t, Entry> entries_;
+  uint64_t next_ticket_ = 0;
+  bool stopping_ = false;
+  std::thread thread_;
+};
+
+/// Arms the watchdog for run_options while in scope.
+class RunDeadline
+{
+public:
+  RunDeadline(Deadline deadline, Ort::RunOptions& run_options) :
+      ticket_(RunWatchdog::instance().arm(deadline, run_options))
+  {
+  }
+  ~RunDeadline() { RunWatchdog::instance().disarm(ticket_); }
+  RunDeadline(const RunDeadline&) = delete;
+  RunDeadline& operator=(const RunDeadline&) = delete;
+
+  /// True once the watchdog terminated the run.
+  bool fired() const { return RunWatchdog::instance().fired(ticket_); }
+
+private:
+  uint64_t ticket_;
+};
+
+} // namespace yolov8_onnxruntime
+
+#endif // YOLOV8_ONNXRUNTIME_DEADLINE_H
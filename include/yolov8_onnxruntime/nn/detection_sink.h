@@ -0,0 +1,72 @@
+#ifndef YOLOV8_ONNXRUNTIME_DETECTION_SINK_H
+#define YOLOV8_ONNXRUNTIME_DETECTION_SINK_H
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include <opencv2/core/mat.hpp>
+
+#include "yolov8_onnxruntime/types.h"
+
+namespace yolov8_onnxruntime
+{
+
+/// Decodes one instance mask into its argument, see StreamedDetection.
+using MaskDecoder = std::function<void(cv::Mat&)>;
+
+/**
+ * @brief One detection handed to a sink as soon as its box is final, before its mask exists.
+ *
+ * The mask of a segmentation model is only decoded when the sink asks for it through mask(), so
+ * detections the sink discards never pay for theirs. The decoder owns what it reads (a copy of
+ * the letterbox geometry and a share of the session outputs), so a detection may be kept and
+ * decoded after the sink returned and after later predictions on the same workspace, as long as
+ * the model lives; keeping undecoded detections keeps their image's outputs alive.
+ *
+ * Move-only: a copy would carry the decoder without knowing whether it already ran, and decode
+ * again.
+ */
+class StreamedDetection
+{
+public:
+  StreamedDetection() = default;
+  StreamedDetection(YoloResults result, MaskDecoder decoder) :
+      result_(std::move(result)),
+      decoder_(std::move(decoder))
+  {
+  }
+
+  StreamedDetection(StreamedDetection&&) = default;
+  StreamedDetection& operator=(StreamedDetection&&) = default;
+  StreamedDetection(const StreamedDetection&) = delete;
+  StreamedDetection& operator=(const StreamedDetection&) = delete;
+
+  /// Class, score, box and keypoints; the mask only once mask() decoded it.
+  const YoloResults& result() const { return result_; }
+  /// True if mask() produces a mask, i.e. for segmentation models.
+  bool hasMask() const { return static_cast<bool>(decoder_); }
+  /// Decodes the mask on the first call, empty for models without masks.
+  const cv::Mat& mask();
+  /// Moves the result out, with its mask if it was decoded.
+  YoloResults take() { return std::move(result_); }
+
+  /**
+   * @brief mask() of every detection in detections (each listed once), decoded in parallel with
+   * the largest boxes first.
+   */
+  static void decodeMasks(const std::vector<StreamedDetection*>& detections);
+
+private:
+  YoloResults result_;
+  MaskDecoder decoder_;
+  bool decoded_ = false;
+};
+
+/// Called once per detection, in the order predict() would return them.
+using DetectionSink = std::function<void(StreamedDetection&)>;
+/// Called once per image with all of its detections.
+using DetectionBatchSink = std::function<void(std::vector<StreamedDetection>&)>;
+
+} // namespace yolov8_onnxruntime
+
+#endif // YOLOV8_ONNXRUNTIME_DETECTION_SINK_H
@@ -0,0 +1,109 @@
+#ifndef YOLOV8_ONNXRUNTIME_DYNAMIC_BATCHER_H
+#define YOLOV8_ONNXRUNTIME_DYNAMIC_BATCHER_H
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <opencv2/core/mat.hpp>
+
+#include "yolov8_onnxruntime/nn/autobackend.h"
+#include "yolov8_onnxruntime/types.h"
+
+namespace yolov8_onnxruntime
+{
+
+struct DynamicBatcherOptions
+{
+  /// Largest batch per session call, 0 means the model's tuned batch size (ServingHints), else
+  /// its static batch (or 8 if it is dynamic).
+  size_t max_batch_size = 0;
+  /// How long the oldest queued request may wait for the batch to fill up.
+  std::chrono::microseconds max_wait{2000};
+  float conf = 0.30f;
+  float iou = 0.45f;
+  float mask_threshold = 0.5f;
+  /// Applied on the submitting thread, e.g. cv::COLOR_BGR2RGB; -1 for none.
+  int conversionCode = -1;
+};
+
+struct DynamicBatcherStats
+{
+  size_t requests = 0;
+  size_t batches = 0;
+  size_t full_batches = 0; ///< batches dispatched because max_batch_size was reached
+  size_t expired = 0;      ///< requests failed with DeadlineExceeded
+};
+
+/**
+ * @brief Collects single-image requests from many callers into batched inference calls.
+ *
+ * A background thread waits until max_batch_size requests are queued or the oldest one has waited
+ * max_wait, then runs one AutoBackendOnnx::predict_batch call and completes every caller's future
+ * with its own results. The batcher must be the only user of the model while it runs.
+ */
+class DynamicBatcher
+{
+public:
+  DynamicBatcher(AutoBackendOnnx& model, const DynamicBatcherOptions& options = {});
+  ~DynamicBatcher();
+
+  DynamicBatcher(const DynamicBatcher&) = delete;
+  DynamicBatcher& operator=(const DynamicBatcher&) = delete;
+
+  /**
+   * @brief Queues an image for prediction.
+   *
+   * The image data is not copied unless a conversionCode is set, so it must stay unchanged until
+   * the future is ready. Exceptions raised by inference are rethrown from the future.
+   */
+  std::future<std::vector<YoloResults>> submit(const cv::Mat& image);
+  /**
+   * @brief Same as submit(image), with results reported in image_info's frame.
+   *
+   * A request still queued at its deadline is dropped without being preprocessed, its future
+   * throws DeadlineExceeded. A batch runs until the latest deadline among its requests, so one
+   * impatient request does not cancel the others.
+   */
+  std::future<std::vector<YoloResults>> submit(const cv::Mat& image,
+                                               const ImageInfo& image_info,
+                                               Deadline deadline = NO_DEADLINE);
+
+  /// Processes everything still queued and stops the worker, later submits throw.
+  void stop();
+
+  size_t getMaxBatchSize() const { return max_batch_size_; }
+  DynamicBatcherStats getStats() const;
+
+private:
+  struct Request
+  {
+    cv::Mat image;
+    ImageInfo image_info;
+    std::promise<std::vector<YoloResults>> promise;
+    std::chrono::steady_clock::time_point enqueued;
+    Deadline deadline;
+  };
+
+  void run();
+  void process(std::vector<Request>& batch);
+
+  AutoBackendOnnx& model_;
+  DynamicBatcherOptions options_;
+  size_t max_batch_size_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable queue_cv_;
+  std::deque<Request> queue_;
+  bool stopping_ = false;
+  DynamicBatcherStats stats_;
+  std::thread worker_;
+};
+
+} // namespace yolov8_onnxruntime
+
+#endif // YOLOV8_ONNXRUNTIME_DYNAMIC_BATCHER_H
@@ -0,0 +1,112 @@
+#ifndef YOLOV8_ONNXRUNTIME_MODEL_HANDLE_H
+#define YOLOV8_ONNXRUNTIME_MODEL_HANDLE_H
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv2/core/mat.hpp>
+
+#include "yolov8_onnxruntime/nn/autobackend.h"
+#include "yolov8_onnxruntime/nn/session_config.h"
+#include "yolov8_onnxruntime/nn/workspace.h"
+#include "yolov8_onnxruntime/types.h"
+#include "yolov8_onnxruntime/utils/yuv.h"
+
+namespace yolov8_onnxruntime
+{
+
+/**
+ * @brief A model that can be replaced while it serves requests.
+ *
+ * Every request pins the model current when it starts and finishes on it; a reload loads and
+ * warms the new model in the background while the old one keeps serving, then swaps it in with
+ * one pointer assignment under a mutex that requests only hold to copy the pointer. Requests
+ * starting after the swap run on the new model, and the old session is released by whichever
+ * request drops the last reference to it, so nothing blocks on the load and no request is
+ * dropped.
+ *
+ * predict() may be called from any number of threads, each with its own workspace (the
+ * workspace does not depend on the model and survives a swap).
+ */
+class ModelHandle
+{
+public:
+  using Loader = std::function<std::shared_ptr<AutoBackendOnnx>()>;
+
+  explicit ModelHandle(std::shared_ptr<AutoBackendOnnx> model);
+  /// Waits for a reload still loading, the model it loads is discarded instead of swapped in.
+  /// Its future and those of the reloads queued behind it, which do not start, hold a
+  /// std::runtime_error.
+  ~ModelHandle();
+
+  ModelHandle(const ModelHandle&) = delete;
+  ModelHandle& operator=(const ModelHandle&) = delete;
+
+  /// The current model, holding the pointer keeps it alive across swaps.
+  std::shared_ptr<const AutoBackendOnnx> get() const;
+  /// Incremented by every swap.
+  uint64_t generation() const { return generation_.load(); }
+
+  std::vector<YoloResults>
+  predict(const cv::Mat& image, const PredictOptions& options, InferenceWorkspace& workspace) const;
+  std::vector<YoloResults> predict(const cv::Mat& image,
+                                   const ImageInfo& image_info,
+                                   const PredictOptions& options,
+                                   InferenceWorkspace& workspace) const;
+  std::vector<YoloResults> predict(const YuvImage& frame,
+                                   const PredictOptions& options,
+                                   InferenceWorkspace& workspace) const;
+
+  /**
+   * @brief Swaps model in right away and returns the previous one. Throws std::invalid_argument
+   * when model is null or runs a different task than the current one.
+   */
+  std::shared_ptr<const AutoBackendOnnx> swap(std::shared_ptr<AutoBackendOnnx> model);
+
+  /**
+   * @brief Loads a model with loader on a background thread, warms it up with warmup_options
+   * and swaps it in.
+   *
+   * Returns at once: the reload is queued for the handle's reload thread, which runs reloads one
+   * after another in call order. The future becomes ready after the swap, or holds the exception
+   * when loading or warmup failed, in which case the current model stays in place.
+   */
+  std::future<void> reload(Loader loader, const WarmupOptions& warmup_options = {});
+  /// reload() of an AutoBackendOnnx created from modelPath.
+  std::future<void> reload(const std::string& modelPath,
+                           OnnxProviders_t provider,
+                           const SessionConfig& config = {},
+                           const WarmupOptions& warmup_options = {});
+
+private:
+  struct Reload
+  {
+    Loader loader;
+    WarmupOptions warmup_options;
+    std::promise<void> promise;
+  };
+
+  void runReloads();
+
+  mutable std::mutex model_mutex_;
+  std::shared_ptr<const AutoBackendOnnx> model_; // guarded by model_mutex_
+  std::atomic<uint64_t> generation_{0};
+
+  std::mutex reload_mutex_;
+  std::condition_variable reload_cv_;
+  std::deque<Reload> reloads_;
+  bool stopping_ = false;
+  std::thread reload_worker_; // started by the first reload()
+};
+
+} // namespace yolov8_onnxruntime
+
+#endif // YOLOV8_ONNXRUNTIME_MODEL_HANDLE_H
@@ -1,11 +1,17 @@
 #ifndef YOLOV8_ONNXRUNTIME_ONNX_MODEL_BASE_H
 #define YOLOV8_ONNXRUNTIME_ONNX_MODEL_BASE_H
+#include <atomic>
+#include <mutex>
 #include <onnxruntime/core/session/onnxruntime_cxx_api.h>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 #include "yolov8_onnxruntime/constants.h"
+#include "yolov8_onnxruntime/nn/deadline.h"
+#include "yolov8_onnxruntime/nn/runtime_context.h"
+#include "yolov8_onnxruntime/nn/session_config.h"
+#include "yolov8_onnxruntime/utils/profiling.h"
 
 namespace yolov8_onnxruntime
 {
@@ -21,31 +27,91 @@ namespace yolov8_onnxruntime
 class OnnxModelBase
 {
 public:
-  OnnxModelBase(const char* modelPath, const char* logid, const OnnxProviders_t provider);
+  OnnxModelBase(const char* modelPath,
+                const char* logid,
+                const OnnxProviders_t provider,
+                const SessionConfig& config = {});
   // OnnxModelBase();  // no default constructor should be there
-  // virtual ~OnnxModelBase();
+  virtual ~OnnxModelBase();
   virtual const std::vector<std::string>& getInputNames(); // = 0
   virtual const std::vector<std::string>& getOutputNames();
+  virtual const std::vector<std::vector<int64_t>>& getInputShapes();
+  virtual const std::vector<std::vector<int64_t>>& getOutputShapes();
   virtual const std::vector<const char*> getOutputNamesCStr();
   virtual const std::vector<const char*> getInputNamesCStr();
   virtual const Ort::ModelMetadata& getModelMetadata();
   virtual const std::unordered_map<std::string, std::string>& getMetadata();
   virtual const char* getModelPath();
   virtual const Ort::Session& getSession();
+  /**
+   * @brief Provider the session was created for, CPU when the requested one was unavailable or
+   * failed to create it.
+   *
+   * This is what was asked of onnxruntime, not where nodes run: the provider may still leave
+   * nodes it cannot run to CPU unless SessionConfig::disable_cpu_fallback is set, and onnxruntime
+   * does not report the assignment.
+   */
+  OnnxProviders_t getRequestedProvider() const { return requestedProvider; }
+  /// Shared context the session was created in, null when the model owns its environment.
+  const std::shared_ptr<OnnxRuntimeContext>& getRuntimeContext() const { return runtimeContext; }
+  /// Settings the session was created with, including those of SessionConfig::tuned_config.
+  const SessionConfig& getSessionConfig() const { return sessionConfig; }
   // virtual std::vector<Ort::Value> forward(std::vector<Ort::Value> inputTensors);
   virtual std::vector<Ort::Value> forward(std::vector<Ort::Value>& inputTensors);
+  /**
+   * @brief Runs the session without touching any model state, safe to call from many threads at
+   * once on one model.
+   */
+  std::vector<Ort::Value> forward(std::vector<Ort::Value>& inputTensors) const;
+  /// forward() with the caller's run options, e.g. a run tag or a terminate flag.
+  std::vector<Ort::Value> forward(std::vector<Ort::Value>& inputTensors,
+                                  const Ort::RunOptions& runOptions) const;
+  /**
+   * @brief forward() bounded by deadline: throws DeadlineExceeded when it has already passed, and
+   * has RunWatchdog terminate the run when it passes during it. NO_DEADLINE runs unbounded.
+   */
+  std::vector<Ort::Value> forward(std::vector<Ort::Value>& inputTensors, Deadline deadline) const;
+
+  /// True while the session records a profile (see SessionConfig::profiling).
+  bool isProfiling() const { return profilingActive.load(); }
+  /**
+   * @brief Stops profiling and returns the path of the trace onnxruntime wrote, the same path on
+   * later calls, empty if profiling was not enabled.
+   *
+   * Runs never stop profiling themselves; call this once no other thread runs the model anymore.
+   * Otherwise the trace is written when the model is destroyed.
+   */
+  std::string endProfiling() const;
+  /**
+   * @brief Ends profiling and ranks the recorded nodes, op types and providers by time.
+   *
+   * @param skip_runs Leading session runs left out, by default the cold first one.
+   */
+  ProfileReport profileReport(int skip_runs = 1) const;
+
   Ort::Session session{nullptr};
 
 protected:
-  const char* modelPath_;
-  Ort::Env env{nullptr};
+  std::string modelPath_; // owned, the caller's path may be a temporary
+  SessionConfig sessionConfig;
+  std::shared_ptr<OnnxRuntimeContext> runtimeContext; // keeps a shared env alive
+  std::shared_ptr<void> standaloneEnv;                // registration of env, released after it
+  Ort::Env env{nullptr};                              // own env, only without runtimeContext
+  OnnxProviders_t requestedProvider = OnnxProviders_t::CPU;
 
   std::vector<std::string> inputNodeNames;
   std::vector<std::string> outputNodeNames;
+  std::vector<std::vector<int64_t>> inputNodeShapes;  // dynamic dims are negative
+  std::vector<std::vector<int64_t>> outputNodeShapes; // dynamic dims are negative
   Ort::ModelMetadata model_metadata{nullptr};
   std::unordered_map<std::string, std::string> metadata;
   std::vector<const char*> outputNamesCStr;
   std::vector<const char*> inputNamesCStr;
+
+private:
+  mutable std::atomic<bool> profilingActive{false};
+  mutable std::mutex profileMutex;
+  mutable std::string profilePath;
 };
 
 } // namespace yolov8_onnxruntime
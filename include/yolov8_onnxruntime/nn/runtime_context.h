@@ -0,0 +1,79 @@
+#ifndef YOLOV8_ONNXRUNTIME_RUNTIME_CONTEXT_H
+#define YOLOV8_ONNXRUNTIME_RUNTIME_CONTEXT_H
+#include <memory>
+#include <string>
+
+#include <onnxruntime/core/session/onnxruntime_cxx_api.h>
+
+namespace yolov8_onnxruntime
+{
+
+struct RuntimeContextOptions
+{
+  /// Threads of the shared intra-op pool, 0 for one per physical core.
+  int intra_op_threads = 0;
+  /// Threads of the shared inter-op pool (parallel execution mode only), 0 for the default.
+  int inter_op_threads = 0;
+  /// Let idle pool threads spin for new work, lower latency at the cost of CPU time that other
+  /// processes on the host could use.
+  bool allow_spinning = true;
+  /// Register one CPU arena allocator on the env that sessions opting in allocate from, instead
+  /// of an arena per session.
+  bool shared_allocator = true;
+  OrtLoggingLevel log_level = ORT_LOGGING_LEVEL_WARNING;
+  std::string log_id = "yolov8_onnxruntime";
+};
+
+/**
+ * @brief One Ort::Env with global thread pools, shared by every model of a process.
+ *
+ * Without a context every session creates its own intra-op pool, so a process hosting several
+ * models runs as many pools as models, all sized to the whole machine. Models constructed with
+ * SessionConfig::context run on this context's pools instead (unless they opt out with
+ * SessionConfig::use_global_thread_pools) and keep it alive while they exist.
+ *
+ * onnxruntime keeps a single environment per process: every Ort::Env refers to it, and it keeps
+ * the settings of the one that created it until the last is released. The context therefore has
+ * to exist before any model constructed without one, whose environment would have no global
+ * thread pools for the context's sessions to run on; the constructor throws std::runtime_error
+ * while such a model is alive. Models without a context created after it share its environment
+ * and keep their per-session pools, and a second context shares the first one's pools (its
+ * thread options are ignored).
+ *
+ * The context also holds what sessions of the same model can share (SessionConfig::share_weights):
+ * the prepacked weights, which onnxruntime keys by content so one container serves any number of
+ * sessions and models, and a CPU arena on the env. Several sessions of one model, e.g. one per
+ * NUMA node, then pay for the packed GEMM and convolution weights once.
+ */
+class OnnxRuntimeContext
+{
+public:
+  explicit OnnxRuntimeContext(const RuntimeContextOptions& options = {});
+  OnnxRuntimeContext(const OnnxRuntimeContext&) = delete;
+  OnnxRuntimeContext& operator=(const OnnxRuntimeContext&) = delete;
+
+  static std::shared_ptr<OnnxRuntimeContext> create(const RuntimeContextOptions& options = {})
+  {
+    return std::make_shared<OnnxRuntimeContext>(options);
+  }
+
+  Ort::Env& env() { return env_; }
+  const RuntimeContextOptions& options() const { return options_; }
+  Ort::PrepackedWeightsContainer& prepackedWeights() { return prepacked_weights_; }
+  bool hasSharedAllocator() const { return options_.shared_allocator; }
+
+  /**
+   * @brief Registers the environment of a model constructed without a context until the returned
+   * handle is released; no context can be created meanwhile.
+   */
+  static std::shared_ptr<void> registerStandaloneEnv();
+
+private:
+  RuntimeContextOptions options_;
+  Ort::Env env_{nullptr};
+  Ort::PrepackedWeightsContainer prepacked_weights_;
+};
+
+} // namespace yolov8_onnxruntime
+
+#endif // YOLOV8_ONNXRUNTIME_RUNTIME_CONTEXT_H
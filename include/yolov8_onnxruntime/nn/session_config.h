@@ -0,0 +1,144 @@
+#ifndef YOLOV8_ONNXRUNTIME_SESSION_CONFIG_H
+#define YOLOV8_ONNXRUNTIME_SESSION_CONFIG_H
+#include <memory>
+#include <onnxruntime/core/session/onnxruntime_c_api.h>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace yolov8_onnxruntime
+{
+
+class OnnxRuntimeContext;
+
+enum class OpenVinoPerformanceHint_t
+{
+  LATENCY,              ///< one inference request at a time as fast as possible
+  THROUGHPUT,           ///< several streams sharing the cores, for concurrent callers
+  CUMULATIVE_THROUGHPUT ///< THROUGHPUT spread over all devices of an AUTO/MULTI device
+};
+namespace OpenVinoPerformanceHints
+{
+inline const std::string LATENCY = "LATENCY";
+inline const std::string THROUGHPUT = "THROUGHPUT";
+inline const std::string CUMULATIVE_THROUGHPUT = "CUMULATIVE_THROUGHPUT";
+} // namespace OpenVinoPerformanceHints
+
+inline const std::string& OpenVinoPerformanceHintToString(const OpenVinoPerformanceHint_t hint)
+{
+  switch (hint)
+  {
+  case OpenVinoPerformanceHint_t::THROUGHPUT:
+    return OpenVinoPerformanceHints::THROUGHPUT;
+  case OpenVinoPerformanceHint_t::CUMULATIVE_THROUGHPUT:
+    return OpenVinoPerformanceHints::CUMULATIVE_THROUGHPUT;
+  default:
+    return OpenVinoPerformanceHints::LATENCY;
+  }
+}
+
+/**
+ * @brief Options of the OpenVINO execution provider.
+ *
+ * Empty strings and zero counts leave the choice to OpenVINO, which picks them from the
+ * performance hint and the device.
+ */
+struct OpenVinoOptions
+{
+  /// CPU, GPU, NPU or a virtual device such as AUTO:GPU,CPU.
+  std::string device_type = "CPU";
+  /// FP32, FP16 or ACCURACY (the model's own precision), empty for the device default.
+  std::string precision;
+  /// Passed in a load_config file written to cache_dir, so any hint but LATENCY (what the
+  /// devices default to) needs cache_dir set; without it no file is written anywhere.
+  OpenVinoPerformanceHint_t performance_hint = OpenVinoPerformanceHint_t::LATENCY;
+  /// Parallel inference streams, 0 lets the performance hint decide.
+  int num_streams = 0;
+  /// Inference threads, 0 lets OpenVINO use all cores.
+  int num_threads = 0;
+  /// Compiled model cache and the home of the load_config file, empty disables caching. Mostly
+  /// pays off for GPU and NPU compilation.
+  std::string cache_dir;
+  /// Keep dynamic input dimensions dynamic. false compiles the model once per concrete input
+  /// shape instead, which is faster when only a few shapes occur.
+  bool dynamic_shapes = true;
+};
+
+/**
+ * @brief onnxruntime session profiling, see OnnxModelBase::profileReport().
+ *
+ * The trace grows with every session run until OnnxModelBase::endProfiling() or the model's
+ * destruction writes it, so profile a bounded number of runs.
+ */
+struct ProfilingOptions
+{
+  bool enabled = false;
+  /// Trace file prefix, onnxruntime appends a timestamp and .json.
+  std::string file_prefix = "yolov8_onnxruntime_profile";
+};
+
+/**
+ * @brief How a deployment should drive the model, e.g. as found by the autotune tool.
+ *
+ * The model does not act on these itself, they size what runs in front of it.
+ */
+struct ServingHints
+{
+  /// Images per session call, 0 for no preference (see DynamicBatcherOptions::max_batch_size).
+  int batch_size = 0;
+};
+
+/**
+ * @brief Session settings that do not belong to the model itself.
+ */
+struct SessionConfig
+{
+  /// Unset keeps the provider's default: ORT_DISABLE_ALL for OpenVINO, which compiles the graph
+  /// itself, ORT_ENABLE_ALL for the others.
+  std::optional<GraphOptimizationLevel> graph_optimization_level;
+  /// Fail the session creation instead of running nodes on the CPU provider when the requested
+  /// provider cannot take the whole graph.
+  bool disable_cpu_fallback = false;
+  OpenVinoOptions openvino;
+  ProfilingOptions profiling;
+  /// Environment and thread pools shared with other models, null for per-session pools. Has to
+  /// be created before any model without one, see OnnxRuntimeContext.
+  std::shared_ptr<OnnxRuntimeContext> context;
+  /// Run on the context's global thread pools, false keeps a pool of the session's own (e.g. for
+  /// a latency critical model next to batch workloads). Ignored without a context.
+  bool use_global_thread_pools = true;
+  /// Threads of the session's own intra-op pool, 0 for one per physical core. Ignored on the
+  /// global pools, which are sized by the context.
+  int intra_op_threads = 0;
+  /// Share prepacked weights and the CPU arena with the context's other sessions. Ignored
+  /// without a context.
+  bool share_weights = true;
+  ServingHints serving;
+  /// Tuned config file (see load_session_config()) applied over these settings when the model is
+  /// constructed, empty for none.
+  std::string tuned_config;
+};
+
+/**
+ * @brief Reads a config file written by save_session_config() over base.
+ *
+ * Settings missing from the file keep base's value, so a file may hold only what was tuned.
+ * Throws std::runtime_error when the file cannot be read or parsed.
+ */
+SessionConfig load_session_config(const std::string& path, const SessionConfig& base = {});
+
+/**
+ * @brief Writes the settings of config that can be stored as a JSON config file: everything but
+ * the context, profiling and tuned_config.
+ *
+ * @param notes Informational numbers written under "tuning" (e.g. the measured throughput),
+ * ignored when loading.
+ */
+void save_session_config(const std::string& path,
+                         const SessionConfig& config,
+                         const std::vector<std::pair<std::string, double>>& notes = {});
+
+} // namespace yolov8_onnxruntime
+
+#endif // YOLOV8_ONNXRUNTIME_SESSION_CONFIG_H
@@ -0,0 +1,92 @@
+#ifndef YOLOV8_ONNXRUNTIME_WORKSPACE_H
+#define YOLOV8_ONNXRUNTIME_WORKSPACE_H
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <onnxruntime/core/session/onnxruntime_cxx_api.h>
+#include <opencv2/core/mat.hpp>
+
+#include "yolov8_onnxruntime/utils/letterbox.h"
+#include "yolov8_onnxruntime/utils/ops.h"
+
+namespace yolov8_onnxruntime
+{
+
+/**
+ * @brief Scratch buffers the preprocess and postprocess stages of one prediction draw from.
+ *
+ * Buffers only ever grow: reset() drops the previous frame's contents but keeps every allocation,
+ * and the cv::Mat members are written through create()-style calls that reuse their memory while
+ * size and type repeat. Once a stream has seen its largest frame and detection count, preprocess
+ * and postprocess do not touch the heap anymore; what is left per call is the session run itself
+ * and the returned results.
+ *
+ * That steady state covers detection, pose and classification. It is not an arena: the buffers
+ * are ordinary vectors and Mats that are kept rather than one block handed out. Instance masks are
+ * outside it: every mask decode (AutoBackendOnnx::_get_mask2) allocates its temporaries as well as
+ * the returned mask, and may run on several threads at once, which one set of buffers here could
+ * not serve. End-to-end models also allocate for the output shape query of every prediction.
+ *
+ * A workspace serves one prediction at a time.
+ */
+class InferenceWorkspace
+{
+public:
+  InferenceWorkspace();
+
+  /// Forgets the contents of the previous prediction, keeping all capacity.
+  void reset();
+
+  /// Heap memory currently held by the workspace's own buffers.
+  size_t capacityBytes() const;
+
+  /**
+   * @brief The session inputs: one tensor viewing input with shape input_shape, followed by one [1]
+   * tensor per entry of nms_thresholds.
+   *
+   * The Ort::Values are only recreated when a buffer or shape changed since the last call.
+   */
+  std::vector<Ort::Value>& inputTensors();
+
+  /**
+   * @brief The letterbox geometry of source into target, computed the first time the pair shows
+   * up and kept across predictions (reset() does not drop it), so a fixed-resolution stream does
+   * not redo any resize setup per frame.
+   *
+   * The returned reference stays valid until a pair not among the last few is requested.
+   */
+  const LetterboxTransform& letterboxTransform(const cv::Size& source, const cv::Size& target);
+
+  // preprocess
+  cv::Mat converted;   ///< color converted frame, channel swaps are folded into the resampling
+  cv::Mat letterboxed; ///< network-sized image, only for inputs the fused preprocess does not take
+  std::vector<float> input;
+  std::vector<int64_t> input_shape;
+  /// iou and score threshold inputs of end-to-end models, empty for models without them
+  std::vector<float> nms_thresholds;
+
+  // postprocess
+  std::vector<std::vector<int64_t>> output_shapes;
+  DetectionCandidates candidates;
+  std::vector<cv::Rect> boxes;
+  std::vector<int> nms_order;
+  std::vector<int> nms_keep;
+
+private:
+  Ort::MemoryInfo memory_info_;
+  std::vector<Ort::Value> input_tensors_;
+  const float* bound_data_ = nullptr;
+  size_t bound_size_ = 0;
+  const float* bound_thresholds_ = nullptr;
+  size_t bound_thresholds_size_ = 0;
+  std::vector<int64_t> bound_shape_;
+  // a stream sees one pair, predict(path) two (decoded and raw size), batches a few more
+  std::array<LetterboxTransform, 4> transforms_;
+  size_t next_transform_ = 0;
+};
+
+} // namespace yolov8_onnxruntime
+
+#endif // YOLOV8_ONNXRUNTIME_WORKSPACE_H
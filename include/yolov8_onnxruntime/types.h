@@ -15,7 +15,7 @@ struct YoloResults
   int class_idx{};                ///< The class index of the detected object.
   float conf{};                   ///< The confidence score of the detection.
   cv::Rect_<float> bbox;          ///< The bounding box of the detected object.
-  cv::Mat mask;                   ///< The semantic segmentation mask (if available).
+  cv::Mat mask{};                 ///< The semantic segmentation mask (if available).
   std::vector<float> keypoints{}; ///< Keypoints representing the object's pose (if available).
 };
 
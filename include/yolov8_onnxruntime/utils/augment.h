@@ -14,7 +14,33 @@ void letterbox(const cv::Mat& image,
                bool scaleUp = true,
                int stride = 32);
 
+/**
+ * @brief letterbox() resizing into the caller's scratch instead of a temporary, so repeated calls
+ * with the same sizes reuse both scratch and outImage.
+ */
+void letterbox(const cv::Mat& image,
+               cv::Mat& outImage,
+               cv::Mat& scratch,
+               const cv::Size& newShape,
+               cv::Scalar_<double> color,
+               bool auto_,
+               bool scaleFill,
+               bool scaleUp,
+               int stride);
+
 cv::Mat centercrop(const cv::Mat& img, const cv::Size& targetSize);
+/// centercrop() writing into out, which is reused when it already has the target size.
+void centercrop(const cv::Mat& img, cv::Mat& out, const cv::Size& targetSize);
+
+/**
+ * @brief Scales an HWC image and writes it as planar CHW floats.
+ *
+ * @param image Input image, usually 8-bit with 1 or 3 channels.
+ * @param blob Destination with room for image.total() * image.channels() floats, e.g. one slot of a
+ * batched input tensor.
+ * @param scale Factor applied to every value, 1/255 normalizes 8-bit images to [0, 1].
+ */
+void fill_chw(const cv::Mat& image, float* blob, double scale = 1.0 / 255.0);
 
 cv::Mat scale_image(const cv::Mat& resized_mask,
                     const cv::Size& im0_shape,
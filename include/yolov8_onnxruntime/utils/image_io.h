@@ -0,0 +1,52 @@
+#ifndef YOLOV8_ONNXRUNTIME_IMAGE_IO_H
+#define YOLOV8_ONNXRUNTIME_IMAGE_IO_H
+#include <string>
+#include <vector>
+
+#include <opencv2/core/mat.hpp>
+#include <opencv2/core/types.hpp>
+
+namespace yolov8_onnxruntime
+{
+
+/**
+ * @brief Reads the frame size from a JPEG header without decoding any pixel data.
+ *
+ * @param buffer Encoded file contents.
+ * @param size Output size (width, height) taken from the first SOFn marker.
+ *
+ * @return true if the buffer is a JPEG and a SOFn marker was found, false otherwise.
+ */
+bool read_jpeg_size(const std::vector<uchar>& buffer, cv::Size& size);
+
+/**
+ * @brief Picks the largest DCT-domain reduction (1, 2, 4 or 8) that still covers target_size.
+ *
+ * The reduced image is only ever downscaled afterwards by letterbox, so the model input gets the
+ * same amount of detail as it would from a full decode.
+ *
+ * @param raw_size Size of the full resolution image.
+ * @param target_size Model input size (width, height).
+ *
+ * @return Reduction factor, 1 means a full decode is required.
+ */
+int reduced_decode_factor(const cv::Size& raw_size, const cv::Size& target_size);
+
+/**
+ * @brief Loads an image for inference, decoding JPEGs at reduced resolution when possible.
+ *
+ * Non-JPEG files (or JPEGs which are already close to target_size) are decoded with
+ * cv::IMREAD_UNCHANGED exactly as cv::imread would do. EXIF orientation is ignored in both cases so
+ * that the returned image and raw_size always share the same frame.
+ *
+ * @param path Path to the image file.
+ * @param target_size Model input size (width, height).
+ * @param raw_size Output size of the image at full resolution; results should be scaled to it.
+ *
+ * @return Decoded image, empty if the file could not be read or decoded.
+ */
+cv::Mat imread_reduced(const std::string& path, const cv::Size& target_size, cv::Size& raw_size);
+
+} // namespace yolov8_onnxruntime
+
+#endif // YOLOV8_ONNXRUNTIME_IMAGE_IO_H
@@ -0,0 +1,63 @@
+#ifndef YOLOV8_ONNXRUNTIME_JSON_H
+#define YOLOV8_ONNXRUNTIME_JSON_H
+#include <string>
+#include <vector>
+
+namespace yolov8_onnxruntime
+{
+
+/**
+ * @brief Minimal JSON document used to read back files this library and onnxruntime write.
+ *
+ * Objects keep their keys in document order. Accessors throw std::runtime_error on type mismatch.
+ */
+class JsonValue
+{
+public:
+  enum class Type
+  {
+    NUL,
+    BOOLEAN,
+    NUMBER,
+    STRING,
+    ARRAY,
+    OBJECT
+  };
+
+  /// Parses text, throws std::runtime_error with the offending offset on malformed input.
+  static JsonValue parse(const std::string& text);
+
+  Type type() const { return type_; }
+  bool isNull() const { return type_ == Type::NUL; }
+  bool isNumber() const { return type_ == Type::NUMBER; }
+  bool isString() const { return type_ == Type::STRING; }
+  bool isArray() const { return type_ == Type::ARRAY; }
+  bool isObject() const { return type_ == Type::OBJECT; }
+
+  bool asBool() const;
+  double asNumber() const;
+  const std::string& asString() const;
+  const std::vector<JsonValue>& asArray() const;
+
+  /// Object keys in document order, values are at the same index in asArray().
+  const std::vector<std::string>& keys() const;
+  /// Member lookup, nullptr if this is not an object or the key is missing.
+  const JsonValue* find(const std::string& key) const;
+
+  double numberOr(const std::string& key, double fallback) const;
+  std::string stringOr(const std::string& key, const std::string& fallback) const;
+
+private:
+  friend class JsonParser;
+
+  Type type_ = Type::NUL;
+  bool bool_ = false;
+  double number_ = 0.0;
+  std::string string_;
+  std::vector<std::string> keys_;
+  std::vector<JsonValue> values_; // array items or object values
+};
+
+} // namespace yolov8_onnxruntime
+
+#endif // YOLOV8_ONNXRUNTIME_JSON_H
@@ -0,0 +1,103 @@
+#ifndef YOLOV8_ONNXRUNTIME_LETTERBOX_H
+#define YOLOV8_ONNXRUNTIME_LETTERBOX_H
+#include <vector>
+
+#include <opencv2/core/mat.hpp>
+#include <opencv2/core/types.hpp>
+
+#include "yolov8_onnxruntime/utils/yuv.h"
+
+namespace yolov8_onnxruntime
+{
+
+/**
+ * @brief The letterbox geometry of one (source size, target size) pair, computed once.
+ *
+ * Holds where letterbox() places the resized source inside the target and the bilinear resize
+ * tables of that placement. Every mapping between the two frames goes through the same content
+ * rectangle, so boxes, keypoints and masks agree with the pixels the model actually saw, and a
+ * stream of equally sized frames reuses one transform instead of recomputing gain, padding and
+ * resize coefficients per frame (see InferenceWorkspace::letterboxTransform()).
+ */
+class LetterboxTransform
+{
+public:
+  LetterboxTransform() = default;
+  /**
+   * @param source Size of the images to letterbox.
+   * @param target Network input size.
+   * @param scaleUp Let the source grow beyond its size when it is smaller than the target.
+   */
+  LetterboxTransform(const cv::Size& source, const cv::Size& target, bool scaleUp = true);
+
+  bool matches(const cv::Size& source, const cv::Size& target) const
+  {
+    return source == source_ && target == target_;
+  }
+  const cv::Size& source() const { return source_; }
+  const cv::Size& target() const { return target_; }
+  /// Where the resized source lands in the target, everything around it is padding.
+  const cv::Rect& content() const { return content_; }
+  /// Resize ratio of the source, the same on both axes up to the rounding of content().
+  float gain() const { return gain_; }
+
+  /// Maps a target box back to the source, clipped to the source.
+  cv::Rect_<float> toSource(const cv::Rect_<float>& box) const;
+  /// Maps a source box into the target.
+  cv::Rect_<float> toTarget(const cv::Rect_<float>& box) const;
+  /// Maps [x, y, visibility] keypoint triplets back to the source in place, clipped to it.
+  void toSourceCoords(std::vector<float>& coords) const;
+
+  /**
+   * @brief letterbox() with this geometry: resizes into content() of out and only paints the
+   * padding around it. out is reused while it has the target size and image's type.
+   */
+  void apply(const cv::Mat& image, cv::Mat& out, const cv::Scalar& color = cv::Scalar()) const;
+
+  /**
+   * @brief Resize, padding and the HWC to planar CHW float conversion of fill_chw() in one pass.
+   *
+   * Samples the source through the precomputed tables straight into blob, which needs room for
+   * target().area() * image.channels() floats; no resized or padded image is materialized.
+   * Expects an 8-bit image of source() size, other depths go through apply() and fill_chw().
+   *
+   * @param swapRB Write the first and third channel to each other's plane, which is
+   * cv::COLOR_BGR2RGB (or BGRA2RGBA) folded into the same pass.
+   */
+  void applyChw(const cv::Mat& image,
+                float* blob,
+                bool swapRB = false,
+                double scale = 1.0 / 255.0) const;
+  /**
+   * @brief applyChw() of a YUV frame, with the color conversion folded into the same pass.
+   *
+   * Luma is sampled bilinearly through the same tables, chroma from its nearest sample, and every
+   * output pixel is converted once, so no full-size color image is produced at all.
+   *
+   * @param rgb Write the R, G, B planes in that order (what exported models expect), B, G, R
+   * otherwise.
+   */
+  void applyChw(const YuvImage& image,
+                float* blob,
+                bool rgb = true,
+                double scale = 1.0 / 255.0) const;
+
+private:
+  cv::Size source_;
+  cv::Size target_;
+  cv::Rect content_;
+  float gain_ = 1.0f;
+  cv::Point2f scale_{1.0f, 1.0f}; // content size / source size per axis
+
+  // bilinear taps of every content column and row, the same sampling as cv::resize INTER_LINEAR
+  std::vector<int> x0_;
+  std::vector<int> x1_;
+  std::vector<float> xweight_; // weight of x1_
+  std::vector<int> y0_;
+  std::vector<int> y1_;
+  std::vector<float> yweight_; // weight of y1_
+};
+
+} // namespace yolov8_onnxruntime
+
+#endif // YOLOV8_ONNXRUNTIME_LETTERBOX_H
@@ -1,5 +1,11 @@
 #ifndef YOLOV8_ONNXRUNTIME_OPS_H
 #define YOLOV8_ONNXRUNTIME_OPS_H
+#include <algorithm>
+#include <functional>
+#include <tuple>
+#include <utility>
+#include <vector>
+
 #include <opencv2/core/types.hpp>
 namespace yolov8_onnxruntime
 {
@@ -38,8 +44,14 @@ void clip_boxes(std::vector<cv::Rect_<float>>& boxes, const cv::Size& shape);
 // void clip_coords(cv::Mat& coords, const cv::Size& shape);
 // cv::Mat scale_coords(const cv::Size& img1_shape, cv::Mat& coords, const cv::Size& img0_shape);
 void clip_coords(std::vector<float>& coords, const cv::Size& shape);
+/// Maps [x, y, conf] triplets from the letterboxed img1_shape back to img0_shape, coords is not
+/// modified and the scaled copy is returned.
 std::vector<float>
 scale_coords(const cv::Size& img1_shape, std::vector<float>& coords, const cv::Size& img0_shape);
+/// scale_coords() without the copy.
+void scale_coords_inplace(const cv::Size& img1_shape,
+                          std::vector<float>& coords,
+                          const cv::Size& img0_shape);
 
 cv::Mat crop_mask(const cv::Mat& mask, const cv::Rect& box);
 
@@ -63,6 +75,132 @@ non_max_suppression(const cv::Mat& output0,
                     double conf_threshold,
                     float iou_threshold);
 
+/**
+ * @brief Predictions above the confidence threshold, decoded from one image's raw head output.
+ */
+struct DetectionCandidates
+{
+  std::vector<cv::Rect_<float>> boxes; ///< left, top, width, height in model input coordinates.
+  std::vector<float> confidences;
+  std::vector<int> class_ids;
+  /// Mask coefficients or keypoints, candidate i owns [i * num_extra, (i + 1) * num_extra).
+  std::vector<float> extras;
+  int num_extra = 0;
+
+  size_t size() const { return boxes.size(); }
+  void clear()
+  {
+    boxes.clear();
+    confidences.clear();
+    class_ids.clear();
+    extras.clear();
+  }
+};
+
+using DecodeCandidatesFn = void (*)(const float* output,
+                                    int num_classes,
+                                    int num_extra,
+                                    int num_preds,
+                                    float conf_threshold,
+                                    DetectionCandidates& candidates);
+
+/**
+ * @brief Decodes a channel-major [4 + num_classes + num_extra, num_preds] head output.
+ *
+ * Works on the tensor as the model returns it, so no transposed copy is needed: the class-score
+ * reduction runs over blocks of predictions, one contiguous row per class, which vectorizes as
+ * element-wise compare/select. With NC > 0 the class count is a compile-time constant (num_classes
+ * is ignored) and the class loop is fully unrolled, NC = 0 is the generic runtime version.
+ */
+template <int NC>
+void decode_candidates(const float* output,
+                       int num_classes,
+                       int num_extra,
+                       int num_preds,
+                       float conf_threshold,
+                       DetectionCandidates& candidates)
+{
+  constexpr int BLOCK = 256;
+  const int nc = NC > 0 ? NC : num_classes;
+  const float* scores = output + 4 * static_cast<size_t>(num_preds);
+  const float* extras = scores + static_cast<size_t>(nc) * num_preds;
+  float best_conf[BLOCK];
+  int best_class[BLOCK];
+
+  candidates.clear();
+  candidates.num_extra = num_extra;
+  for (int begin = 0; begin < num_preds; begin += BLOCK)
+  {
+    const int count = std::min(BLOCK, num_preds - begin);
+    const float* first = scores + begin;
+    for (int p = 0; p < count; ++p)
+    {
+      best_conf[p] = first[p];
+      best_class[p] = 0;
+    }
+    for (int c = 1; c < nc; ++c)
+    {
+      const float* row = scores + static_cast<size_t>(c) * num_preds + begin;
+      for (int p = 0; p < count; ++p)
+      {
+        const bool better = row[p] > best_conf[p];
+        best_conf[p] = better ? row[p] : best_conf[p];
+        best_class[p] = better ? c : best_class[p];
+      }
+    }
+
+    for (int p = 0; p < count; ++p)
+    {
+      if (best_conf[p] <= conf_threshold)
+        continue;
+      const int i = begin + p;
+      const float out_w = output[2 * static_cast<size_t>(num_preds) + i];
+      const float out_h = output[3 * static_cast<size_t>(num_preds) + i];
+      const float out_left = std::max(output[i] - 0.5f * out_w + 0.5f, 0.0f);
+      const float out_top = std::max(output[num_preds + i] - 0.5f * out_h + 0.5f, 0.0f);
+      candidates.boxes.emplace_back(out_left, out_top, out_w + 0.5f, out_h + 0.5f);
+      candidates.confidences.push_back(best_conf[p]);
+      candidates.class_ids.push_back(best_class[p]);
+      for (int e = 0; e < num_extra; ++e)
+        candidates.extras.push_back(extras[static_cast<size_t>(e) * num_preds + i]);
+    }
+  }
+}
+
+/**
+ * @brief Returns the decode_candidates specialization for num_classes, or the generic one.
+ */
+DecodeCandidatesFn select_decoder(int num_classes);
+
+/**
+ * @brief Greedy non-maximum suppression with the semantics of cv::dnn::NMSBoxes.
+ *
+ * Boxes scoring above score_threshold are visited by descending score (ties by index) and kept if
+ * their IoU with every kept box is at most iou_threshold. order is caller-owned scratch and both
+ * vectors keep their capacity, so repeated calls do not allocate.
+ *
+ * @param indices Receives the kept box indices, highest score first.
+ */
+void nms_boxes(const std::vector<cv::Rect>& boxes,
+               const std::vector<float>& scores,
+               float score_threshold,
+               float iou_threshold,
+               std::vector<int>& order,
+               std::vector<int>& indices);
+
+/**
+ * @brief Runs decode(i) for every i below count, concurrently once there are several; the schedule
+ * of instance mask decoding.
+ *
+ * Each index is a stripe of its own so OpenCV's workers pull the next one as soon as they finish,
+ * and the indices of the largest area(i) are handed out first (ties in index order) so a big mask
+ * does not end up running alone after the small ones. decode(i) must only write what belongs to
+ * i, the results then do not depend on the schedule.
+ */
+void parallel_for_largest_first(int count,
+                                const std::function<float(int)>& area,
+                                const std::function<void(int)>& decode);
+
 } // namespace yolov8_onnxruntime
 
 #endif // YOLOV8_ONNXRUNTIME_OPS_H
\ No newline at end of file
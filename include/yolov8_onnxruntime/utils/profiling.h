@@ -0,0 +1,56 @@
+#ifndef YOLOV8_ONNXRUNTIME_PROFILING_H
+#define YOLOV8_ONNXRUNTIME_PROFILING_H
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace yolov8_onnxruntime
+{
+
+/**
+ * @brief Time spent in one node, op type or provider over the profiled runs.
+ */
+struct ProfileEntry
+{
+  std::string name;     ///< node name, op type or provider name
+  std::string op_type;  ///< for nodes
+  std::string provider; ///< for nodes and op types, comma separated if an op type ran on several
+  int64_t calls = 0;
+  double total_us = 0.0;
+  double share = 0.0; ///< of the summed kernel time of all nodes
+};
+
+/**
+ * @brief Ranked breakdown of an onnxruntime profile, every list sorted by descending time.
+ */
+struct ProfileReport
+{
+  int runs = 0;             ///< model_run events counted
+  int skipped_runs = 0;     ///< leading runs left out, e.g. the cold first run
+  double run_total_us = 0.0;  ///< wall time of the counted session runs
+  double node_total_us = 0.0; ///< kernel time of their nodes
+  std::vector<ProfileEntry> nodes;
+  std::vector<ProfileEntry> op_types;
+  std::vector<ProfileEntry> providers;
+
+  double runMeanMs() const { return runs > 0 ? run_total_us / runs / 1000.0 : 0.0; }
+};
+
+/**
+ * @brief Parses the JSON trace onnxruntime writes with session profiling enabled.
+ *
+ * Node kernel times ("Node" events ending in _kernel_time) are attributed to the session run
+ * ("model_run" event) they fall into; nodes of the first skip_runs runs are left out. Throws
+ * std::runtime_error if the file cannot be read or is not a trace.
+ */
+ProfileReport parse_ort_profile(const std::string& path, int skip_runs = 0);
+ProfileReport parse_ort_profile_text(const std::string& text, int skip_runs = 0);
+
+/// Human readable tables of report, with at most top rows of nodes.
+void print_profile_report(std::ostream& os, const ProfileReport& report, size_t top = 20);
+
+} // namespace yolov8_onnxruntime
+
+#endif // YOLOV8_ONNXRUNTIME_PROFILING_H
@@ -0,0 +1,68 @@
+#ifndef YOLOV8_ONNXRUNTIME_RENDER_H
+#define YOLOV8_ONNXRUNTIME_RENDER_H
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <opencv2/core/mat.hpp>
+#include <opencv2/core/types.hpp>
+
+#include "yolov8_onnxruntime/types.h"
+
+namespace yolov8_onnxruntime
+{
+
+struct RenderOptions
+{
+  double mask_alpha = 0.4; ///< weight of the class color in masked pixels, like plot_results.
+  int box_thickness = 2;
+  bool draw_labels = true;
+  double font_scale = 0.6;
+  int kpt_radius = 5;
+  float kpt_conf = 0.5f; ///< keypoints and limbs below this confidence are skipped.
+  int band_rows = 64;    ///< rows per parallel band of the mask compositing pass.
+};
+
+/**
+ * @brief Draws YoloResults onto BGR frames, meant for annotated video output.
+ *
+ * Unlike plot_results, which blends a full-frame copy per call, all masks are composited in one
+ * pass restricted to the union of the instance boxes: every row band first paints a per-pixel class
+ * label map and then blends the labeled pixels through per-class lookup tables built once in the
+ * constructor. Boxes, labels and keypoints are drawn unblended on top afterwards.
+ *
+ * A Renderer keeps its label map between calls, so use one instance per output stream.
+ */
+class Renderer
+{
+public:
+  /**
+   * @param colors Color per class index, as from generateRandomColors(). Classes beyond the list
+   * wrap around.
+   * @param names Class names for the labels, missing ones are printed as their index.
+   */
+  Renderer(const std::vector<cv::Scalar>& colors,
+           const std::unordered_map<int, std::string>& names,
+           const RenderOptions& options = {});
+
+  /// Renders results onto an 8-bit 3 channel image in place.
+  void render(cv::Mat& image, const std::vector<YoloResults>& results);
+
+private:
+  void compositeMasks(cv::Mat& image, const std::vector<YoloResults>& results);
+  void drawBox(cv::Mat& image, const YoloResults& result) const;
+  void drawKeypoints(cv::Mat& image, const YoloResults& result) const;
+
+  const cv::Scalar& colorOf(int class_idx) const;
+
+  std::vector<cv::Scalar> colors_;
+  std::unordered_map<int, std::string> names_;
+  RenderOptions options_;
+  /// (colors_.size() + 1) x 3 x 256 blend tables, label 0 is the identity for unmasked pixels.
+  std::vector<uchar> blend_lut_;
+  cv::Mat labels_; ///< CV_16UC1, class index + 1 of the topmost mask, 0 for none
+};
+
+} // namespace yolov8_onnxruntime
+
+#endif // YOLOV8_ONNXRUNTIME_RENDER_H
@@ -0,0 +1,167 @@
+#ifndef YOLOV8_ONNXRUNTIME_SERIALIZATION_H
+#define YOLOV8_ONNXRUNTIME_SERIALIZATION_H
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <opencv2/core/mat.hpp>
+
+#include "yolov8_onnxruntime/types.h"
+
+namespace yolov8_onnxruntime
+{
+
+/**
+ * @brief Run-length encodes a binary mask in row-major order.
+ *
+ * Runs alternate between background and foreground and always start with a (possibly empty)
+ * background run, so {0, 5, 3} means five set pixels followed by three unset ones.
+ *
+ * @param mask CV_8U mask, any non-zero pixel counts as foreground. Throws std::invalid_argument
+ * when it has more pixels than a uint32 run can count.
+ */
+std::vector<uint32_t> mask_to_rle(const cv::Mat& mask);
+/// mask_to_rle() appending to counts, so a reused vector encodes without allocating.
+void mask_to_rle(const cv::Mat& mask, std::vector<uint32_t>& counts);
+
+/**
+ * @brief Decodes run lengths produced by mask_to_rle into a CV_8U mask with values 0/255.
+ */
+cv::Mat rle_to_mask(const uint32_t* counts, size_t counts_num, const cv::Size& size);
+
+std::string json_escape(const std::string& input);
+
+/**
+ * @brief Writes one result as a JSON object.
+ *
+ * Keys: "class", "name" (only if names is given), "conf", "bbox" as [x, y, w, h], "keypoints"
+ * (only if present) and "mask" as {"size": [h, w], "counts": [...]} relative to bbox (only if
+ * present and with_mask is set).
+ */
+void write_json(std::ostream& os,
+                const YoloResults& result,
+                const std::unordered_map<int, std::string>* names = nullptr,
+                bool with_mask = true);
+
+/**
+ * @brief Writes all results of one image as a JSON array.
+ */
+void write_json(std::ostream& os,
+                const std::vector<YoloResults>& results,
+                const std::unordered_map<int, std::string>* names = nullptr,
+                bool with_mask = true);
+
+namespace BinaryResultFormat
+{
+inline constexpr uint32_t MAGIC = 0x52385659; // "YV8R" read as little-endian uint32
+inline constexpr uint16_t VERSION = 1;
+inline constexpr uint16_t FLAG_KEYPOINTS = 1u << 0;
+inline constexpr uint16_t FLAG_MASKS = 1u << 1;
+} // namespace BinaryResultFormat
+
+/**
+ * @brief Header of one binary result frame (the results of one image).
+ *
+ * All fields and arrays are little-endian and 4-byte aligned. The header is followed by
+ *  - boxes      float[count * 4]  (x, y, w, h)
+ *  - scores     float[count]
+ *  - classes    int32[count]
+ *  - keypoints  float[count * keypoint_values]              (FLAG_KEYPOINTS)
+ *  - mask_dims  uint32[count * 2]  (rows, cols), 0x0 if none (FLAG_MASKS)
+ *  - mask_offs  uint32[count + 1]  into mask_counts          (FLAG_MASKS)
+ *  - mask_counts uint32[mask_counts_num], see mask_to_rle     (FLAG_MASKS)
+ */
+struct BinaryFrameHeader
+{
+  uint32_t magic;
+  uint16_t version;
+  uint16_t flags;
+  uint32_t count;
+  uint32_t keypoint_values;
+  uint32_t mask_counts_num;
+  uint32_t payload_bytes; ///< bytes following the header
+  uint32_t reserved[2];
+};
+static_assert(sizeof(BinaryFrameHeader) == 32, "BinaryFrameHeader must stay 32 bytes");
+
+/**
+ * @brief Streams result frames in the binary format.
+ *
+ * Each write() encodes one frame straight from the postprocess output into a scratch buffer that
+ * is reused across frames and emits it with a single stream write.
+ */
+class BinaryResultWriter
+{
+public:
+  explicit BinaryResultWriter(std::ostream& os, bool with_masks = true);
+  /// Writer that is only used through encode().
+  explicit BinaryResultWriter(bool with_masks = true);
+
+  /// Writes one frame, throws std::invalid_argument if keypoint counts differ between results.
+  void write(const std::vector<YoloResults>& results);
+
+  /**
+   * @brief Encodes one frame into buffer (cleared first), returns the frame size in bytes.
+   *
+   * Throws std::invalid_argument when a count or size of the frame does not fit its uint32 field.
+   */
+  size_t encode(const std::vector<YoloResults>& results, std::vector<char>& buffer);
+
+private:
+  std::ostream* os_;
+  bool with_masks_;
+  std::vector<char> buffer_;
+  std::vector<uint32_t> mask_offsets_;
+  std::vector<uint32_t> mask_counts_;
+};
+
+/**
+ * @brief Zero-copy view of one binary result frame.
+ *
+ * The view only points into the given buffer (e.g. a memory-mapped file), which has to be 4-byte
+ * aligned and outlive the view. The constructor validates the header and all array bounds and
+ * throws std::runtime_error on malformed input.
+ */
+class BinaryResultView
+{
+public:
+  BinaryResultView(const void* data, size_t size);
+
+  uint32_t count() const { return header_->count; }
+  uint32_t keypointValues() const { return header_->keypoint_values; }
+  bool hasKeypoints() const { return keypoints_ != nullptr; }
+  bool hasMasks() const { return mask_dims_ != nullptr; }
+  /// Bytes occupied by this frame; the next frame of a stream starts right after it.
+  size_t frameBytes() const { return sizeof(BinaryFrameHeader) + header_->payload_bytes; }
+
+  const float* boxes() const { return boxes_; }
+  const float* scores() const { return scores_; }
+  const int32_t* classes() const { return classes_; }
+  const float* keypoints() const { return keypoints_; }
+
+  cv::Rect_<float> bbox(size_t i) const
+  {
+    return {boxes_[4 * i], boxes_[4 * i + 1], boxes_[4 * i + 2], boxes_[4 * i + 3]};
+  }
+  cv::Size maskSize(size_t i) const;
+  const uint32_t* maskCounts(size_t i, size_t& counts_num) const;
+
+  /// Materializes the frame as YoloResults, decoding masks when present.
+  std::vector<YoloResults> toResults() const;
+
+private:
+  const BinaryFrameHeader* header_ = nullptr;
+  const float* boxes_ = nullptr;
+  const float* scores_ = nullptr;
+  const int32_t* classes_ = nullptr;
+  const float* keypoints_ = nullptr;
+  const uint32_t* mask_dims_ = nullptr;
+  const uint32_t* mask_offsets_ = nullptr;
+  const uint32_t* mask_counts_ = nullptr;
+};
+
+} // namespace yolov8_onnxruntime
+
+#endif // YOLOV8_ONNXRUNTIME_SERIALIZATION_H
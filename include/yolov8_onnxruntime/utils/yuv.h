@@ -0,0 +1,111 @@
+#ifndef YOLOV8_ONNXRUNTIME_YUV_H
+#define YOLOV8_ONNXRUNTIME_YUV_H
+#include <algorithm>
+
+#include <opencv2/core/mat.hpp>
+#include <opencv2/core/types.hpp>
+
+namespace yolov8_onnxruntime
+{
+
+enum class YuvFormat_t
+{
+  NV12, ///< Y plane, then one plane of interleaved U, V at half resolution
+  NV21, ///< NV12 with V before U
+  I420, ///< Y, U and V planes, U and V at half resolution
+  YUYV  ///< packed 4:2:2, Y0 U Y1 V per pixel pair
+};
+
+/**
+ * @brief Non-owning view of an 8-bit YUV frame as capture devices and decoders deliver it.
+ *
+ * Planes may carry row padding, strides are in bytes. Colors are BT.601, limited (video) range
+ * unless full_range is set.
+ */
+struct YuvImage
+{
+  YuvFormat_t format = YuvFormat_t::NV12;
+  cv::Size size;
+  const uchar* planes[3] = {nullptr, nullptr, nullptr};
+  int strides[3] = {0, 0, 0};
+  bool full_range = false;
+
+  static YuvImage nv12(const uchar* y, int y_stride, const uchar* uv, int uv_stride, cv::Size size)
+  {
+    return {YuvFormat_t::NV12, size, {y, uv, nullptr}, {y_stride, uv_stride, 0}};
+  }
+  static YuvImage nv21(const uchar* y, int y_stride, const uchar* vu, int vu_stride, cv::Size size)
+  {
+    return {YuvFormat_t::NV21, size, {y, vu, nullptr}, {y_stride, vu_stride, 0}};
+  }
+  static YuvImage i420(const uchar* y,
+                       int y_stride,
+                       const uchar* u,
+                       int u_stride,
+                       const uchar* v,
+                       int v_stride,
+                       cv::Size size)
+  {
+    return {YuvFormat_t::I420, size, {y, u, v}, {y_stride, u_stride, v_stride}};
+  }
+  static YuvImage yuyv(const uchar* data, int stride, cv::Size size)
+  {
+    return {YuvFormat_t::YUYV, size, {data, nullptr, nullptr}, {stride, 0, 0}};
+  }
+
+  /// True when every plane the format needs is set and the size is even where chroma is shared.
+  bool valid() const;
+};
+
+/**
+ * @brief BT.601 YUV to RGB of one pixel, limited or full range, with the output scale folded in.
+ *
+ * The color conversion of the fused preprocess, and of convert_yuv() for full range frames.
+ */
+struct YuvToRgb
+{
+  float y_offset;
+  float y_gain;
+  float rv;
+  float gu;
+  float gv;
+  float bu;
+  float scale;
+
+  explicit YuvToRgb(bool full_range, float scale) :
+      y_offset(full_range ? 0.0f : 16.0f),
+      y_gain(full_range ? 1.0f : 1.164383f),
+      rv(full_range ? 1.402f : 1.596027f),
+      gu(full_range ? -0.344136f : -0.391762f),
+      gv(full_range ? -0.714136f : -0.812968f),
+      bu(full_range ? 1.772f : 2.017232f),
+      scale(scale)
+  {
+  }
+
+  static float clamp(float value) { return std::min(std::max(value, 0.0f), 255.0f); }
+
+  void operator()(float y, float u, float v, float& r, float& g, float& b) const
+  {
+    const float luma = (y - y_offset) * y_gain;
+    u -= 128.0f;
+    v -= 128.0f;
+    r = clamp(luma + rv * v) * scale;
+    g = clamp(luma + gu * u + gv * v) * scale;
+    b = clamp(luma + bu * u) * scale;
+  }
+};
+
+/**
+ * @brief Converts a YUV frame to an interleaved 8-bit BGR (or RGB) image.
+ *
+ * For what still needs a color image, such as the classify center crop or drawing results; the
+ * detection models take YUV frames directly (see LetterboxTransform::applyChw). Limited range
+ * frames go through cv::cvtColor, which only knows that range; full range frames are converted
+ * with YuvToRgb, like the fused preprocess does.
+ */
+void convert_yuv(const YuvImage& image, cv::Mat& out, bool rgb = false);
+
+} // namespace yolov8_onnxruntime
+
+#endif // YOLOV8_ONNXRUNTIME_YUV_H
@@ -0,0 +1,202 @@
+#!/usr/bin/env python3
+"""Appends top-k and NonMaxSuppression to an exported YOLOv8 ONNX model.
+
+The converted model returns final detections instead of the raw [B, 4 + nc + extra, N] head:
+
+    detections  [K, 7 + extra]  rows of (batch, class, score, cx, cy, w, h, extra...)
+
+where extra are the mask coefficients of segment models and the keypoints of pose models. The
+protos output of segment models is kept as it is. Score and IoU thresholds become two additional
+[1] float inputs, "iou_threshold" and "score_threshold", so AutoBackendOnnx still applies the
+per-call conf/iou. NMS is class agnostic on the best class of every prediction, the same as the
+C++ postprocessing of the raw head.
+
+usage: export_end2end.py yolov8n.onnx yolov8n-end2end.onnx [--max-det 300] [--topk 1000]
+"""
+
+import argparse
+import ast
+
+import onnx
+from onnx import TensorProto, helper
+
+PREFIX = "end2end/"
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("model", help="YOLOv8 ONNX model exported by ultralytics")
+    parser.add_argument("output", help="path of the converted model")
+    parser.add_argument("--max-det", type=int, default=300, help="detections kept per image")
+    parser.add_argument(
+        "--topk", type=int, default=1000, help="best scoring predictions NMS looks at per image"
+    )
+    parser.add_argument("--nc", type=int, default=0, help="class count, default from metadata")
+    return parser.parse_args()
+
+
+def metadata_of(model):
+    return {prop.key: prop.value for prop in model.metadata_props}
+
+
+def static_dim(value_info, axis):
+    dim = value_info.type.tensor_type.shape.dim[axis]
+    if not dim.HasField("dim_value"):
+        raise SystemExit(f"error: dimension {axis} of {value_info.name} must be static")
+    return dim.dim_value
+
+
+class GraphBuilder:
+    def __init__(self, graph, opset):
+        self.graph = graph
+        self.opset = opset
+
+    def const(self, name, values, dtype=TensorProto.INT64):
+        name = PREFIX + name
+        self.graph.initializer.append(helper.make_tensor(name, dtype, [len(values)], values))
+        return name
+
+    def node(self, op, inputs, name, **attrs):
+        output = PREFIX + name
+        self.graph.node.append(helper.make_node(op, inputs, [output], name=output, **attrs))
+        return output
+
+    def slice(self, data, start, end, axis, name):
+        return self.node(
+            "Slice",
+            [
+                data,
+                self.const(name + "_starts", [start]),
+                self.const(name + "_ends", [end]),
+                self.const(name + "_axes", [axis]),
+            ],
+            name,
+        )
+
+    def reduce_max(self, data, axis, name):
+        # axes moved from attribute to input with opset 18
+        if self.opset >= 18:
+            return self.node(
+                "ReduceMax", [data, self.const(name + "_axes", [axis])], name, keepdims=0
+            )
+        return self.node("ReduceMax", [data], name, axes=[axis], keepdims=0)
+
+    def unsqueeze(self, data, axis, name):
+        return self.node("Unsqueeze", [data, self.const(name + "_axes", [axis])], name)
+
+
+def convert(model, max_det, topk, nc):
+    graph = model.graph
+    opset = next(op.version for op in model.opset_import if op.domain in ("", "ai.onnx"))
+    if opset < 13:
+        raise SystemExit(f"error: opset {opset} is too old, export with opset >= 13")
+
+    head = graph.output[0]
+    features = static_dim(head, 1)
+    num_preds = static_dim(head, 2)
+    num_extra = features - 4 - nc
+    if num_extra < 0:
+        raise SystemExit(f"error: {head.name} has {features} features, fewer than 4 + {nc} classes")
+    k = min(topk, num_preds)
+
+    b = GraphBuilder(graph, opset)
+    preds = b.node("Transpose", [head.name], "preds", perm=[0, 2, 1])  # [B, N, F]
+    scores = b.reduce_max(b.slice(preds, 4, 4 + nc, 2, "class_scores"), 2, "scores")  # [B, N]
+
+    # top-k before NMS keeps its quadratic part small, on low confidence heads most of the 8400
+    # predictions would otherwise reach it
+    topk_node = helper.make_node(
+        "TopK",
+        [scores, b.const("k", [k])],
+        [PREFIX + "topk_scores", PREFIX + "topk_indices"],
+        name=PREFIX + "topk",
+        axis=1,
+    )
+    graph.node.append(topk_node)
+    topk_scores, topk_indices = topk_node.output  # [B, k]
+    gather_shape = b.node(
+        "Concat",
+        [b.node("Shape", [topk_indices], "topk_shape"), b.const("features", [features])],
+        "gather_shape",
+        axis=0,
+    )
+    gather_indices = b.node(
+        "Expand", [b.unsqueeze(topk_indices, 2, "topk_indices_3d"), gather_shape], "gather_indices"
+    )
+    top_preds = b.node("GatherElements", [preds, gather_indices], "top_preds", axis=1)  # [B, k, F]
+    top_class_scores = b.slice(top_preds, 4, 4 + nc, 2, "top_class_scores")
+    classes = b.node("ArgMax", [top_class_scores], "classes", axis=2, keepdims=0)  # [B, k]
+
+    selected = b.node(
+        "NonMaxSuppression",
+        [
+            b.slice(top_preds, 0, 4, 2, "top_boxes"),
+            b.unsqueeze(topk_scores, 1, "nms_scores"),
+            b.const("max_det", [max_det]),
+            "iou_threshold",
+            "score_threshold",
+        ],
+        "selected",
+        center_point_box=1,
+    )  # [K, 3] of (batch, class, box)
+    batch_box = b.node("Gather", [selected, b.const("batch_box", [0, 2])], "batch_box", axis=1)
+
+    def column(data, name, cast):
+        values = b.node("GatherND", [data, batch_box], name)  # [K]
+        if cast:
+            values = b.node("Cast", [values], name + "_float", to=TensorProto.FLOAT)
+        return b.unsqueeze(values, 1, name + "_column")
+
+    rows = b.node("GatherND", [top_preds, batch_box], "rows")  # [K, F]
+    columns = [
+        b.node(
+            "Cast", [b.slice(selected, 0, 1, 1, "batch")], "batch_float", to=TensorProto.FLOAT
+        ),
+        column(classes, "class", True),
+        column(topk_scores, "score", False),
+        b.slice(rows, 0, 4, 1, "box"),
+    ]
+    if num_extra > 0:
+        columns.append(b.slice(rows, 4 + nc, features, 1, "extra"))
+    concat = helper.make_node("Concat", columns, ["detections"], name="detections", axis=1)
+    graph.node.append(concat)
+
+    for name in ("iou_threshold", "score_threshold"):
+        graph.input.append(helper.make_tensor_value_info(name, TensorProto.FLOAT, [1]))
+    detections = helper.make_tensor_value_info(
+        "detections", TensorProto.FLOAT, ["num_detections", 7 + num_extra]
+    )
+    outputs = [detections] + list(graph.output[1:])
+    del graph.output[:]
+    graph.output.extend(outputs)
+
+    props = {prop.key: prop for prop in model.metadata_props}
+    for key, value in (("end2end", "True"), ("max_det", str(max_det)), ("topk", str(k))):
+        if key in props:
+            props[key].value = value
+        else:
+            model.metadata_props.append(onnx.StringStringEntryProto(key=key, value=value))
+    return model
+
+
+def main():
+    args = parse_args()
+    model = onnx.load(args.model)
+    metadata = metadata_of(model)
+    if metadata.get("end2end") == "True":
+        raise SystemExit(f"error: {args.model} already is an end-to-end model")
+    if metadata.get("task") == "classify":
+        raise SystemExit("error: classification models have no NMS to append")
+    nc = args.nc or len(ast.literal_eval(metadata.get("names", "{}")))
+    if nc <= 0:
+        raise SystemExit("error: no class names in the metadata, pass --nc")
+
+    model = convert(model, args.max_det, args.topk, nc)
+    onnx.checker.check_model(model)
+    onnx.save(model, args.output)
+    columns = model.graph.output[0].type.tensor_type.shape.dim[1].dim_value
+    print(f"saved {args.output}: detections [K, {columns}], max_det {args.max_det}")
+
+
+if __name__ == "__main__":
+    main()
@@ -35,10 +35,9 @@ int main()
   }
 
   yolov8_onnxruntime::AutoBackendOnnx model(modelPath.c_str(), onnx_logid.c_str(), onnx_provider);
+  model.warmup();
   std::vector<yolov8_onnxruntime::YoloResults> objs =
       model.predict_once(img, conf_threshold, iou_threshold, mask_threshold, conversion_code);
-  objs.clear();
-  objs = model.predict_once(img, conf_threshold, iou_threshold, mask_threshold, conversion_code);
 
   std::vector<cv::Scalar> colors =
       yolov8_onnxruntime::generateRandomColors(model.getNc(), model.getCh());
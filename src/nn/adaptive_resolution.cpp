@@ -0,0 +1,131 @@
+#include "yolov8_onnxruntime/nn/adaptive_resolution.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+namespace yolov8_onnxruntime
+{
+
+namespace
+{
+
+// Releases a request's in-flight slot however it ends.
+struct InFlightGuard
+{
+  std::atomic<size_t>& count;
+  ~InFlightGuard() { --count; }
+};
+
+} // namespace
+
+AdaptiveResolution::AdaptiveResolution(std::vector<ResolutionVariant> variants,
+                                       const AdaptiveResolutionOptions& options) :
+    variants_(std::move(variants)),
+    options_(options)
+{
+  if (variants_.empty())
+    throw std::invalid_argument("Error: adaptive resolution needs at least one variant");
+  for (ResolutionVariant& variant : variants_)
+  {
+    if (!variant.model)
+      throw std::invalid_argument("Error: adaptive resolution variant without a model");
+    if (variant.model->getTaskType() != variants_[0].model->getTaskType())
+      throw std::invalid_argument("Error: adaptive resolution variants of different tasks");
+    variant.input_size = variant.model->resolveInputSize(variant.input_size);
+  }
+  std::stable_sort(variants_.begin(),
+                   variants_.end(),
+                   [](const ResolutionVariant& a, const ResolutionVariant& b)
+                   { return a.input_size.area() > b.input_size.area(); });
+}
+
+AdaptiveResults AdaptiveResolution::predict(const cv::Mat& image,
+                                            const PredictOptions& options,
+                                            InferenceWorkspace& workspace)
+{
+  return run(image, options, workspace);
+}
+
+AdaptiveResults AdaptiveResolution::predict(const YuvImage& frame,
+                                            const PredictOptions& options,
+                                            InferenceWorkspace& workspace)
+{
+  return run(frame, options, workspace);
+}
+
+size_t AdaptiveResolution::currentVariant() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return current_;
+}
+
+double AdaptiveResolution::latencyMs() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return samples_ == 0 ? 0.0 : latency_ms_;
+}
+
+template <typename Image>
+AdaptiveResults AdaptiveResolution::run(const Image& image,
+                                        const PredictOptions& options,
+                                        InferenceWorkspace& workspace)
+{
+  InFlightGuard guard{in_flight_};
+  const size_t variant = select(++in_flight_);
+  const ResolutionVariant& chosen = variants_[variant];
+
+  PredictOptions variant_options = options;
+  variant_options.input_size = chosen.input_size;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  AdaptiveResults out;
+  out.results = chosen.model->predict(image, variant_options, workspace);
+  out.input_size = chosen.input_size;
+  out.variant = variant;
+  record(variant,
+         std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+             .count());
+  return out;
+}
+
+size_t AdaptiveResolution::select(size_t in_flight)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (samples_ < std::max<size_t>(options_.min_dwell, 1))
+    return current_;
+
+  const bool crowded = options_.max_in_flight > 0 && in_flight > options_.max_in_flight;
+  const bool slow = latency_ms_ > options_.target_latency_ms * options_.downgrade_ratio;
+  if ((crowded || slow) && current_ + 1 < variants_.size())
+  {
+    ++current_;
+    samples_ = 0;
+    return current_;
+  }
+  if (!crowded && current_ > 0)
+  {
+    // latency grows about with the pixel count, predict it for the next larger variant
+    const double ratio = static_cast<double>(variants_[current_ - 1].input_size.area()) /
+                         static_cast<double>(variants_[current_].input_size.area());
+    if (latency_ms_ * ratio < options_.target_latency_ms * options_.upgrade_ratio)
+    {
+      --current_;
+      samples_ = 0;
+    }
+  }
+  return current_;
+}
+
+void AdaptiveResolution::record(size_t variant, double latency_ms)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  // requests started before the last switch say nothing about the current variant
+  if (variant != current_)
+    return;
+  latency_ms_ = samples_ == 0
+                    ? latency_ms
+                    : latency_ms_ + options_.smoothing * (latency_ms - latency_ms_);
+  ++samples_;
+}
+
+} // namespace yolov8_onnxruntime
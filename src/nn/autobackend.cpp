@@ -1,8 +1,13 @@
 #include "yolov8_onnxruntime/nn/autobackend.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <filesystem>
 #include <iostream>
+#include <memory>
 #include <ostream>
+#include <stdexcept>
 
 #include <opencv2/core/mat.hpp>
 #include <opencv2/imgcodecs.hpp>
@@ -12,32 +17,86 @@
 #include "yolov8_onnxruntime/constants.h"
 #include "yolov8_onnxruntime/utils/augment.h"
 #include "yolov8_onnxruntime/utils/common.h"
+#include "yolov8_onnxruntime/utils/image_io.h"
 #include "yolov8_onnxruntime/utils/ops.h"
+#include "yolov8_onnxruntime/utils/yuv.h"
 
 namespace yolov8_onnxruntime
 {
 namespace fs = std::filesystem;
 
+namespace
+{
+
+// BGR <-> RGB (and BGRA <-> RGBA) only reorder channels, so they commute with resizing and never
+// need a converted copy of the full frame
+bool is_channel_swap(int conversionCode, const cv::Mat& image)
+{
+  return image.depth() == CV_8U &&
+         ((conversionCode == cv::COLOR_BGR2RGB && image.channels() == 3) ||
+          (conversionCode == cv::COLOR_BGRA2RGBA && image.channels() == 4));
+}
+
+// predict_once and predict_batch convert the caller's image in place. A channel swap is done in
+// one pass over the frame; cvtColor would clone an in-place source, so other conversions go
+// through scratch and are copied back, which reuses both buffers.
+void convert_in_place(cv::Mat& image, cv::Mat& scratch, int conversionCode)
+{
+  if (conversionCode < 0)
+    return;
+  if (is_channel_swap(conversionCode, image))
+  {
+    const int channels = image.channels();
+    cv::parallel_for_(cv::Range(0, image.rows),
+                      [&](const cv::Range& range)
+                      {
+                        for (int r = range.start; r < range.end; ++r)
+                        {
+                          uchar* pixel = image.ptr<uchar>(r);
+                          for (int c = 0; c < image.cols; ++c, pixel += channels)
+                            std::swap(pixel[0], pixel[2]);
+                        }
+                      });
+    return;
+  }
+  cv::cvtColor(image, scratch, conversionCode);
+  scratch.copyTo(image);
+}
+
+// Runs decode(i) for every result with the largest boxes first, see parallel_for_largest_first.
+// decode(i) only writes results[i].
+void decode_masks(const std::vector<YoloResults>& results, const std::function<void(int)>& decode)
+{
+  parallel_for_largest_first(static_cast<int>(results.size()),
+                             [&results](int i) { return results[i].bbox.area(); },
+                             decode);
+}
+
+} // namespace
+
 AutoBackendOnnx::AutoBackendOnnx(const char* modelPath,
                                  const char* logid,
                                  const OnnxProviders_t provider,
                                  const std::vector<int>& imgsz,
                                  const int& stride,
                                  const int& nc,
-                                 const std::unordered_map<int, std::string> names) :
-    OnnxModelBase(modelPath, logid, provider),
+                                 const std::unordered_map<int, std::string> names,
+                                 const SessionConfig& config) :
+    OnnxModelBase(modelPath, logid, provider, config),
     imgsz_(imgsz),
     stride_(stride),
     nc_(nc),
     names_(names),
     inputTensorShape_()
 {
+  selectPostprocess();
 }
 
 AutoBackendOnnx::AutoBackendOnnx(const char* modelPath,
                                  const char* logid,
-                                 const OnnxProviders_t provider) :
-    OnnxModelBase(modelPath, logid, provider)
+                                 const OnnxProviders_t provider,
+                                 const SessionConfig& config) :
+    OnnxModelBase(modelPath, logid, provider, config)
 {
 
   loadMetaData();
@@ -143,6 +202,42 @@ void AutoBackendOnnx::loadMetaData()
 
   // TODO: raise assert if imgsz_ and task_ were not initialized (since you don't know in that case
   // which postprocessing to use) }
+  selectPostprocess();
+}
+
+void AutoBackendOnnx::selectPostprocess()
+{
+  task_type_ = YoloTaskFromString(task_);
+  decode_candidates_ = select_decoder(static_cast<int>(names_.size()));
+
+  // raw heads are [B, features, preds], end-to-end models return [K, 7 + extra] detections
+  auto end2end_item = getMetadata().find(MetadataConstants::END2END);
+  bool end2end_metadata = end2end_item != getMetadata().end() &&
+                          (end2end_item->second == "True" || end2end_item->second == "1");
+  bool end2end_shape = !outputNodeShapes.empty() && outputNodeShapes[0].size() == 2;
+  end2end_ = task_type_ != YoloTasks_t::CLASSIFY && (end2end_metadata || end2end_shape);
+  if (end2end_ && inputNodeNames.size() > 1 &&
+      (inputNodeNames.size() != 3 || inputNodeNames[1] != "iou_threshold" ||
+       inputNodeNames[2] != "score_threshold"))
+  {
+    throw std::runtime_error("Error: end-to-end model inputs must be images, iou_threshold and "
+                             "score_threshold");
+  }
+  if (end2end_ && task_type_ == YoloTasks_t::SEGMENT)
+  {
+    // every detection row has to carry one coefficient per prototype mask, otherwise there is
+    // nothing to decode masks from; dynamic dimensions are checked per call instead
+    if (outputNodeShapes.size() < 2 || outputNodeShapes[1].size() != 4)
+      throw std::runtime_error("Error: end-to-end segment model has no [B, nm, H, W] mask output");
+    int64_t cols = outputNodeShapes[0].size() == 2 ? outputNodeShapes[0][1] : -1;
+    int64_t mask_features_num = outputNodeShapes[1][1];
+    if (cols > 0 && mask_features_num > 0 && cols - 7 != mask_features_num)
+    {
+      throw std::runtime_error("Error: end-to-end segment model has " + std::to_string(cols - 7) +
+                               " mask coefficients per detection for " +
+                               std::to_string(mask_features_num) + " prototype masks");
+    }
+  }
 }
 
 void AutoBackendOnnx::prettyPrintMetaData()
@@ -152,7 +247,7 @@ void AutoBackendOnnx::prettyPrintMetaData()
   std::cout << "  stride: " << stride_ << std::endl;
   std::cout << "  nc: " << nc_ << std::endl;
   std::cout << "  ch: " << ch_ << std::endl;
-  std::cout << "  task: " << task_ << std::endl;
+  std::cout << "  task: " << task_ << (end2end_ ? " (end-to-end)" : "") << std::endl;
   std::cout << "  names: " << std::endl;
   for (const auto& pair : names_)
   {
@@ -188,8 +283,10 @@ std::vector<YoloResults> AutoBackendOnnx::predict_once(const fs::path& imagePath
     return {};
   }
 
-  // Load the image into a cv::Mat
-  cv::Mat image = cv::imread(imagePath.string(), cv::IMREAD_UNCHANGED);
+  // Load the image into a cv::Mat; large JPEGs are decoded at reduced resolution since letterbox
+  // would downscale them to the model input size anyway
+  cv::Size raw_size;
+  cv::Mat image = imread_reduced(imagePath.string(), getCvSize(), raw_size);
 
   // Check if loading the image was successful
   if (image.empty())
@@ -213,8 +310,9 @@ std::vector<YoloResults> AutoBackendOnnx::predict_once(const fs::path& imagePath
     throw std::runtime_error(errorMessage);
   }
 
-  // Call overloaded one
-  return predict_once(image, conf, iou, mask_threshold, conversionCode, verbose);
+  // results are scaled back to the full resolution frame
+  ImageInfo image_info = {raw_size};
+  return predict_image(image, image_info, conf, iou, mask_threshold, conversionCode, verbose);
 }
 
 std::vector<YoloResults> AutoBackendOnnx::predict_once(cv::Mat& image,
@@ -224,34 +322,173 @@ std::vector<YoloResults> AutoBackendOnnx::predict_once(cv::Mat& image,
                                                        int conversionCode,
                                                        bool verbose)
 {
-  double preprocess_time = 0.0;
-  double inference_time = 0.0;
-  double postprocess_time = 0.0;
-  Timer preprocess_timer = Timer(preprocess_time, verbose);
-  float* blob = nullptr;
+  ImageInfo image_info = {image.size()};
+  return predict_image(image, image_info, conf, iou, mask_threshold, conversionCode, verbose);
+}
+
+std::vector<YoloResults> AutoBackendOnnx::predict(const cv::Mat& image,
+                                                  PredictOptions options) const
+{
+  InferenceWorkspace workspace;
+  return predict(image, ImageInfo{image.size()}, options, workspace);
+}
+
+std::vector<YoloResults> AutoBackendOnnx::predict(const cv::Mat& image,
+                                                  PredictOptions options,
+                                                  InferenceWorkspace& workspace) const
+{
+  return predict(image, ImageInfo{image.size()}, options, workspace);
+}
 
-  std::vector<int64_t> inputTensorShape;
-  std::pair<cv::Size, std::vector<float>> preprocess_data;
+std::vector<YoloResults> AutoBackendOnnx::predict(const cv::Mat& image,
+                                                  const ImageInfo& image_info,
+                                                  PredictOptions options,
+                                                  InferenceWorkspace& workspace) const
+{
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  check_deadline(options.deadline, "preprocessing");
+  workspace.reset();
+  preprocess_into(image, workspace, options.conversionCode, options.input_size);
+  return predict_prepared(workspace, image_info, options, start);
+}
 
-  cv::Size pp_sz;
-  std::vector<float> inputTensorValues;
-  if (task_ != YoloTasks::CLASSIFY)
-    std::tie(pp_sz, inputTensorValues) =
-        preprocess(image, blob, inputTensorShape, conversionCode, preprocess_timer);
+std::vector<YoloResults> AutoBackendOnnx::predict(const YuvImage& frame,
+                                                  PredictOptions options,
+                                                  InferenceWorkspace& workspace) const
+{
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  check_deadline(options.deadline, "preprocessing");
+  if (!frame.valid())
+    throw std::invalid_argument("Error: invalid YUV frame");
+  if (getCh() != 3)
+  {
+    throw std::runtime_error("Error: YUV frames need a 3 channel model, this one takes " +
+                             std::to_string(getCh()));
+  }
+  workspace.reset();
+
+  cv::Size new_shape = resolveInputSize(options.input_size);
+  if (task_type_ == YoloTasks_t::CLASSIFY)
+  {
+    convert_yuv(frame, workspace.converted, options.yuv_to_rgb);
+    preprocess_into(workspace.converted, workspace, -1, options.input_size);
+  }
   else
-    std::tie(pp_sz, inputTensorValues) =
-        preprocess_classify(image, blob, inputTensorShape, conversionCode, preprocess_timer);
+  {
+    workspace.input_shape = {1, 3, new_shape.height, new_shape.width};
+    workspace.input.resize(static_cast<size_t>(new_shape.area()) * 3);
+    workspace.letterboxTransform(frame.size, new_shape)
+        .applyChw(frame, workspace.input.data(), options.yuv_to_rgb);
+  }
+  return predict_prepared(workspace, ImageInfo{frame.size}, options, start);
+}
+
+size_t AutoBackendOnnx::predict_stream(const cv::Mat& image,
+                                       const DetectionSink& sink,
+                                       PredictOptions options,
+                                       InferenceWorkspace& workspace) const
+{
+  return predict_stream_batch(
+      image,
+      [&sink](std::vector<StreamedDetection>& detections)
+      {
+        for (StreamedDetection& detection : detections)
+          sink(detection);
+      },
+      std::move(options),
+      workspace);
+}
+
+size_t AutoBackendOnnx::predict_stream_batch(const cv::Mat& image,
+                                             const DetectionBatchSink& sink,
+                                             PredictOptions options,
+                                             InferenceWorkspace& workspace) const
+{
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  check_deadline(options.deadline, "preprocessing");
+  workspace.reset();
+  preprocess_into(image, workspace, options.conversionCode, options.input_size);
+
+  // the mask decoders read the protos in place, every decoder shares the outputs so they live
+  // as long as a detection that may still decode its mask
+  std::vector<Ort::Value> outputs;
+  std::vector<MaskDecoder> decoders;
+  std::vector<YoloResults> results = predict_prepared(
+      workspace, ImageInfo{image.size()}, options, start, &outputs, &decoders);
+  auto kept_outputs = std::make_shared<std::vector<Ort::Value>>(std::move(outputs));
+  std::vector<StreamedDetection> detections;
+  detections.reserve(results.size());
+  for (size_t i = 0; i < results.size(); ++i)
+  {
+    MaskDecoder decoder;
+    if (i < decoders.size())
+    {
+      decoder = [kept_outputs, decode = std::move(decoders[i])](cv::Mat& mask) { decode(mask); };
+    }
+    detections.emplace_back(std::move(results[i]), std::move(decoder));
+  }
+  sink(detections);
+  return detections.size();
+}
+
+std::vector<YoloResults>
+AutoBackendOnnx::predict_prepared(InferenceWorkspace& workspace,
+                                  const ImageInfo& image_info,
+                                  const PredictOptions& options,
+                                  std::chrono::steady_clock::time_point start,
+                                  std::vector<Ort::Value>* outputs,
+                                  std::vector<MaskDecoder>* deferred_masks) const
+{
+  using clock = std::chrono::steady_clock;
+  auto ms_since = [](clock::time_point start)
+  { return std::chrono::duration<double, std::milli>(clock::now() - start).count(); };
+
+  std::vector<Ort::Value>& inputTensors = bindInputs(workspace, options.conf, options.iou);
+  if (options.timings)
+  {
+    options.timings->preprocess_ms = ms_since(start);
+    start = clock::now();
+  }
+
+  std::vector<Ort::Value> outputTensors = forward(inputTensors, options.deadline);
+  if (options.timings)
+  {
+    options.timings->inference_ms = ms_since(start);
+    start = clock::now();
+  }
+  check_deadline(options.deadline, "postprocessing");
+
+  std::vector<YoloResults> results;
+  float conf = options.conf;
+  float iou = options.iou;
+  float mask_threshold = options.mask_threshold;
+  postprocess(
+      workspace, outputTensors, 0, image_info, results, conf, iou, mask_threshold, deferred_masks);
+  if (options.timings)
+    options.timings->postprocess_ms = ms_since(start);
+  if (outputs)
+    *outputs = std::move(outputTensors);
+  return results;
+}
 
-  delete blob;
+std::vector<YoloResults> AutoBackendOnnx::predict_image(cv::Mat& image,
+                                                        const ImageInfo& image_info,
+                                                        float& conf,
+                                                        float& iou,
+                                                        float& mask_threshold,
+                                                        int conversionCode,
+                                                        bool verbose)
+{
+  double preprocess_time = 0.0;
+  double inference_time = 0.0;
+  double postprocess_time = 0.0;
+  Timer preprocess_timer = Timer(preprocess_time, verbose);
+  InferenceWorkspace& workspace = workspace_;
+  workspace.reset();
 
-  Ort::MemoryInfo memoryInfo = Ort::MemoryInfo::CreateCpu(OrtAllocatorType::OrtArenaAllocator,
-                                                          OrtMemType::OrtMemTypeDefault);
-  std::vector<Ort::Value> inputTensors;
-  inputTensors.push_back(Ort::Value::CreateTensor<float>(memoryInfo,
-                                                         inputTensorValues.data(),
-                                                         vector_product(inputTensorShape),
-                                                         inputTensorShape.data(),
-                                                         inputTensorShape.size()));
+  convert_in_place(image, workspace.converted, conversionCode);
+  cv::Size pp_sz = preprocess_into(image, workspace, -1);
+  std::vector<Ort::Value>& inputTensors = bindInputs(workspace, conf, iou);
 
   preprocess_timer.Stop();
   Timer inference_timer = Timer(inference_time, verbose);
@@ -262,36 +499,232 @@ std::vector<YoloResults> AutoBackendOnnx::predict_once(cv::Mat& image,
   // create container for the results
   std::vector<YoloResults> results;
   // 3. postprocess based on task:
-  std::unordered_map<int, std::string> names = this->getNames();
-  int class_names_num = names.size();
-  if (task_ == YoloTasks::SEGMENT)
+  postprocess(workspace, outputTensors, 0, image_info, results, conf, iou, mask_threshold);
+
+  postprocess_timer.Stop();
+  if (verbose)
+  {
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "image: " << pp_sz.height << "x" << pp_sz.width << " " << results.size()
+              << " objs, ";
+    std::cout << (preprocess_time + inference_time + postprocess_time) * 1000.0 << "ms"
+              << std::endl;
+    std::cout << "Speed: " << (preprocess_time * 1000.0) << "ms preprocess, ";
+    std::cout << (inference_time * 1000.0) << "ms inference, ";
+    std::cout << (postprocess_time * 1000.0) << "ms postprocess per image ";
+    std::cout << "at shape (1, " << image.channels() << ", " << pp_sz.height << ", " << pp_sz.width
+              << ")" << std::endl;
+  }
+
+  return results;
+}
+
+std::vector<std::vector<YoloResults>> AutoBackendOnnx::predict_batch(std::vector<cv::Mat>& images,
+                                                                     float& conf,
+                                                                     float& iou,
+                                                                     float& mask_threshold,
+                                                                     int conversionCode,
+                                                                     bool verbose)
+{
+  std::vector<ImageInfo> image_infos;
+  image_infos.reserve(images.size());
+  for (const cv::Mat& image : images)
+  {
+    image_infos.push_back({image.size()});
+  }
+  return predict_batch(
+      images, image_infos, conf, iou, mask_threshold, conversionCode, verbose);
+}
+
+std::vector<std::vector<YoloResults>>
+AutoBackendOnnx::predict_batch(std::vector<cv::Mat>& images,
+                               const std::vector<ImageInfo>& image_infos,
+                               float& conf,
+                               float& iou,
+                               float& mask_threshold,
+                               int conversionCode,
+                               bool verbose,
+                               Deadline deadline)
+{
+  if (images.size() != image_infos.size())
+  {
+    throw std::invalid_argument("Error: predict_batch got " + std::to_string(images.size()) +
+                                " images but " + std::to_string(image_infos.size()) +
+                                " image infos");
+  }
+
+  std::vector<std::vector<YoloResults>> batch_results(images.size());
+  if (images.empty())
+    return batch_results;
+
+  // models exported with a static batch dimension have to be fed exactly that many images
+  const int max_batch = getMaxBatch();
+  const size_t chunk_size = max_batch > 0 ? static_cast<size_t>(max_batch) : images.size();
+
+  double preprocess_time = 0.0;
+  double inference_time = 0.0;
+  double postprocess_time = 0.0;
+  InferenceWorkspace& workspace = workspace_;
+  for (size_t begin = 0; begin < images.size(); begin += chunk_size)
+  {
+    const size_t count = std::min(chunk_size, images.size() - begin);
+    const int64_t tensor_batch = max_batch > 0 ? max_batch : static_cast<int64_t>(count);
+
+    // 1. preprocess every image into its slot of one [N, C, H, W] tensor
+    check_deadline(deadline, "preprocessing");
+    std::vector<float> batchTensorValues;
+    std::vector<int64_t> batchTensorShape;
+    int64_t slot_size = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+      Timer preprocess_timer = Timer(preprocess_time, verbose);
+      workspace.reset();
+      convert_in_place(images[begin + i], workspace.converted, conversionCode);
+      preprocess_into(images[begin + i], workspace, -1);
+      if (batchTensorShape.empty())
+      {
+        batchTensorShape = workspace.input_shape;
+        batchTensorShape[0] = tensor_batch;
+        slot_size = static_cast<int64_t>(workspace.input.size());
+        // unused slots of a static batch stay zero
+        batchTensorValues.assign(static_cast<size_t>(vector_product(batchTensorShape)), 0.0f);
+      }
+      std::copy(workspace.input.begin(),
+                workspace.input.end(),
+                batchTensorValues.begin() + static_cast<int64_t>(i) * slot_size);
+      preprocess_timer.Stop();
+    }
+    // the batch tensor takes the workspace input's place for this session call
+    workspace.input.swap(batchTensorValues);
+    workspace.input_shape.swap(batchTensorShape);
+    std::vector<Ort::Value>& inputTensors = bindInputs(workspace, conf, iou);
+
+    // 2. inference
+    Timer inference_timer = Timer(inference_time, verbose);
+    std::vector<Ort::Value> outputTensors = forward(inputTensors, deadline);
+    inference_timer.Stop();
+    check_deadline(deadline, "postprocessing");
+
+    // 3. postprocess every image from its slice of the outputs
+    Timer postprocess_timer = Timer(postprocess_time, verbose);
+    for (size_t i = 0; i < count; ++i)
+    {
+      postprocess(workspace,
+                  outputTensors,
+                  i,
+                  image_infos[begin + i],
+                  batch_results[begin + i],
+                  conf,
+                  iou,
+                  mask_threshold);
+    }
+    postprocess_timer.Stop();
+  }
+
+  if (verbose)
+  {
+    double n = static_cast<double>(images.size());
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "batch: " << images.size() << " images, "
+              << (preprocess_time + inference_time + postprocess_time) * 1000.0 << "ms"
+              << std::endl;
+    std::cout << "Speed: " << (preprocess_time * 1000.0 / n) << "ms preprocess, ";
+    std::cout << (inference_time * 1000.0 / n) << "ms inference, ";
+    std::cout << (postprocess_time * 1000.0 / n) << "ms postprocess per image" << std::endl;
+  }
+
+  return batch_results;
+}
+
+std::vector<Ort::Value>&
+AutoBackendOnnx::bindInputs(InferenceWorkspace& workspace, float conf, float iou) const
+{
+  if (end2end_ && inputNodeNames.size() == 3)
+    workspace.nms_thresholds.assign({iou, conf});
+  else
+    workspace.nms_thresholds.clear();
+  return workspace.inputTensors();
+}
+
+const std::vector<int64_t>& AutoBackendOnnx::outputShape(InferenceWorkspace& workspace,
+                                                         std::vector<Ort::Value>& outputTensors,
+                                                         size_t index) const
+{
+  if (workspace.output_shapes.size() < outputTensors.size())
+    workspace.output_shapes.resize(outputTensors.size());
+  std::vector<int64_t>& shape = workspace.output_shapes[index];
+
+  // querying a tensor's shape allocates, a static output shape only needs the current batch
+  // (the detections of end-to-end models lead with their count instead of the batch)
+  const std::vector<int64_t>& model_shape = outputNodeShapes[index];
+  bool fixed = !(end2end_ && index == 0) && !model_shape.empty() &&
+               !workspace.input_shape.empty() &&
+               std::all_of(model_shape.begin() + 1,
+                           model_shape.end(),
+                           [](int64_t dim) { return dim > 0; });
+  if (fixed)
+  {
+    shape.assign(model_shape.begin(), model_shape.end());
+    shape[0] = workspace.input_shape[0];
+  }
+  else
   {
+    shape = outputTensors[index].GetTensorTypeAndShapeInfo().GetShape();
+  }
+  return shape;
+}
 
+void AutoBackendOnnx::postprocess(InferenceWorkspace& workspace,
+                                  std::vector<Ort::Value>& outputTensors,
+                                  size_t batch_idx,
+                                  const ImageInfo& image_info,
+                                  std::vector<YoloResults>& results,
+                                  float& conf,
+                                  float& iou,
+                                  float& mask_threshold,
+                                  std::vector<MaskDecoder>* deferred_masks) const
+{
+  if (end2end_)
+  {
+    postprocess_end2end(workspace,
+                        outputTensors,
+                        batch_idx,
+                        image_info,
+                        results,
+                        conf,
+                        mask_threshold,
+                        deferred_masks);
+    return;
+  }
+
+  int class_names_num = static_cast<int>(getNames().size());
+  switch (task_type_)
+  {
+  case YoloTasks_t::SEGMENT:
+  {
     // get outputs info
-    std::vector<int64_t> outputTensor0Shape =
-        outputTensors[0].GetTensorTypeAndShapeInfo().GetShape();
-    std::vector<int64_t> outputTensor1Shape =
-        outputTensors[1].GetTensorTypeAndShapeInfo().GetShape();
-    // get outputs
-    float* all_data0 = outputTensors[0].GetTensorMutableData<float>();
-
-    cv::Mat output0 = cv::Mat(cv::Size((int)outputTensor0Shape[2], (int)outputTensor0Shape[1]),
-                              CV_32F,
-                              all_data0)
-                          .t(); // [bs, features, preds_num]=>[bs, preds_num, features]
+    const std::vector<int64_t>& outputTensor0Shape = outputShape(workspace, outputTensors, 0);
+    const std::vector<int64_t>& outputTensor1Shape = outputShape(workspace, outputTensors, 1);
+    // get outputs of the image at batch_idx, kept as [features, preds]
+    float* all_data0 = outputTensors[0].GetTensorMutableData<float>() +
+                       batch_idx * outputTensor0Shape[1] * outputTensor0Shape[2];
+    cv::Mat output0 =
+        cv::Mat((int)outputTensor0Shape[1], (int)outputTensor0Shape[2], CV_32F, all_data0);
     auto mask_shape = outputTensor1Shape;
     std::vector<int> mask_sz = {1, (int)mask_shape[1], (int)mask_shape[2], (int)mask_shape[3]};
-    cv::Mat output1 = cv::Mat(mask_sz, CV_32F, outputTensors[1].GetTensorMutableData<float>());
+    float* all_data1 = outputTensors[1].GetTensorMutableData<float>() +
+                       batch_idx * mask_shape[1] * mask_shape[2] * mask_shape[3];
+    cv::Mat output1 = cv::Mat(mask_sz, CV_32F, all_data1);
 
-    int iw = this->getWidth();
-    int ih = this->getHeight();
+    int iw = inputSize(workspace).width;
+    int ih = inputSize(workspace).height;
     int mask_features_num = outputTensor1Shape[1];
     int mh = outputTensor1Shape[2];
     int mw = outputTensor1Shape[3];
-    ImageInfo img_info = {image.size()};
-    postprocess_masks(output0,
+    postprocess_masks(workspace,
+                      output0,
                       output1,
-                      img_info,
+                      image_info,
                       results,
                       class_names_num,
                       conf,
@@ -301,66 +734,169 @@ std::vector<YoloResults> AutoBackendOnnx::predict_once(cv::Mat& image,
                       mw,
                       mh,
                       mask_features_num,
-                      mask_threshold);
-  }
-  else if (task_ == YoloTasks::DETECT)
-  {
-    ImageInfo img_info = {image.size()};
-    std::vector<int64_t> outputTensor0Shape =
-        outputTensors[0].GetTensorTypeAndShapeInfo().GetShape();
-    float* all_data0 = outputTensors[0].GetTensorMutableData<float>();
-    cv::Mat output0 = cv::Mat(cv::Size((int)outputTensor0Shape[2], (int)outputTensor0Shape[1]),
-                              CV_32F,
-                              all_data0)
-                          .t(); // [bs, features, preds_num]=>[bs, preds_num, features]
-    postprocess_detects(output0, img_info, results, class_names_num, conf, iou);
-  }
-  else if (task_ == YoloTasks::POSE)
-  {
-    ImageInfo image_info = {image.size()};
-    std::vector<int64_t> outputTensor0Shape =
-        outputTensors[0].GetTensorTypeAndShapeInfo().GetShape();
-    float* all_data0 = outputTensors[0].GetTensorMutableData<float>();
-    cv::Mat output0 = cv::Mat(cv::Size((int)outputTensor0Shape[2], (int)outputTensor0Shape[1]),
-                              CV_32F,
-                              all_data0)
-                          .t(); // [bs, features, preds_num]=>[bs, preds_num, features]
-    postprocess_kpts(output0, image_info, results, class_names_num, conf, iou);
-  }
-  else if (task_ == YoloTasks::CLASSIFY)
-  {
-    ImageInfo image_info = {image.size()};
-    std::vector<int64_t> outputTensor0Shape =
-        outputTensors[0].GetTensorTypeAndShapeInfo().GetShape();
-
-    float* all_data0 = outputTensors[0].GetTensorMutableData<float>();
-    // As outputTensor shape is [1, num_classes], create a Mat of this shape
+                      mask_threshold,
+                      deferred_masks);
+    break;
+  }
+  case YoloTasks_t::DETECT:
+  case YoloTasks_t::POSE:
+  {
+    const std::vector<int64_t>& outputTensor0Shape = outputShape(workspace, outputTensors, 0);
+    float* all_data0 = outputTensors[0].GetTensorMutableData<float>() +
+                       batch_idx * outputTensor0Shape[1] * outputTensor0Shape[2];
+    cv::Mat output0 =
+        cv::Mat((int)outputTensor0Shape[1], (int)outputTensor0Shape[2], CV_32F, all_data0);
+    if (task_type_ == YoloTasks_t::DETECT)
+      postprocess_detects(workspace, output0, image_info, results, class_names_num, conf, iou);
+    else
+      postprocess_kpts(workspace, output0, image_info, results, class_names_num, conf, iou);
+    break;
+  }
+  case YoloTasks_t::CLASSIFY:
+  {
+    const std::vector<int64_t>& outputTensor0Shape = outputShape(workspace, outputTensors, 0);
+
+    float* all_data0 =
+        outputTensors[0].GetTensorMutableData<float>() + batch_idx * outputTensor0Shape[1];
+    // As outputTensor shape is [bs, num_classes], create a Mat of one row
     cv::Mat output0 = cv::Mat(1, (int)outputTensor0Shape[1], CV_32F, all_data0);
 
     // Call to process classification results
     postprocess_classify(output0, results);
+    break;
   }
-  else
-  {
+  default:
     throw std::runtime_error("NotImplementedError: task: " + task_);
   }
+}
 
-  postprocess_timer.Stop();
-  if (verbose)
+int AutoBackendOnnx::getMaxBatch() const
+{
+  if (inputNodeShapes.empty() || inputNodeShapes[0].empty())
+    return 1;
+  // dynamic dimensions are reported as -1 (or 0 for symbolic ones)
+  int64_t batch = inputNodeShapes[0][0];
+  return batch > 0 ? static_cast<int>(batch) : 0;
+}
+
+WarmupReport AutoBackendOnnx::warmup(const WarmupOptions& options)
+{
+  // every shape needs at least one latency to report
+  if (options.max_iterations < 1)
+    throw std::invalid_argument("Error: warmup needs max_iterations of at least 1");
+  ready_ = false;
+  WarmupReport report;
+
+  const int max_batch = getMaxBatch();
+  std::vector<int> batch_sizes = options.batch_sizes;
+  if (batch_sizes.empty())
+    batch_sizes.push_back(max_batch > 0 ? max_batch : 1);
+  std::vector<cv::Size> input_sizes = options.input_sizes;
+  if (input_sizes.empty())
+    input_sizes.push_back(getCvSize());
+  std::vector<int64_t> model_shape =
+      inputNodeShapes.empty() ? std::vector<int64_t>{} : inputNodeShapes[0];
+
+  auto median_of_last = [](const std::vector<double>& values, size_t n)
   {
-    std::cout << std::fixed << std::setprecision(1);
-    std::cout << "image: " << pp_sz.height << "x" << pp_sz.width << " " << results.size()
-              << " objs, ";
-    std::cout << (preprocess_time + inference_time + postprocess_time) * 1000.0 << "ms"
-              << std::endl;
-    std::cout << "Speed: " << (preprocess_time * 1000.0) << "ms preprocess, ";
-    std::cout << (inference_time * 1000.0) << "ms inference, ";
-    std::cout << (postprocess_time * 1000.0) << "ms postprocess per image ";
-    std::cout << "at shape (1, " << image.channels() << ", " << pp_sz.height << ", " << pp_sz.width
-              << ")" << std::endl;
+    std::vector<double> tail(values.end() - std::min(n, values.size()), values.end());
+    std::sort(tail.begin(), tail.end());
+    return tail[tail.size() / 2];
+  };
+
+  // 1. session warmup for every (batch, input size) the deployment will use
+  bool all_steady = true;
+  for (int batch : batch_sizes)
+  {
+    if (max_batch > 0 && batch != max_batch)
+    {
+      std::cerr << "Warning: skipping warmup of batch " << batch << ", model has static batch "
+                << max_batch << std::endl;
+      continue;
+    }
+    for (const cv::Size& input_size : input_sizes)
+    {
+      bool static_hw = model_shape.size() == 4 && model_shape[2] > 0 && model_shape[3] > 0;
+      if (static_hw && (model_shape[2] != input_size.height || model_shape[3] != input_size.width))
+      {
+        std::cerr << "Warning: skipping warmup of input " << input_size.height << "x"
+                  << input_size.width << ", model input size is static" << std::endl;
+        continue;
+      }
+
+      InferenceWorkspace workspace;
+      workspace.input_shape = {batch, ch_, input_size.height, input_size.width};
+      // letterbox padding gray, keeps postprocessing-free runs representative
+      workspace.input.assign(vector_product(workspace.input_shape), 114.0f / 255.0f);
+      WarmupShapeReport shape_report;
+      shape_report.batch = batch;
+      shape_report.input_size = input_size;
+
+      std::vector<double> latencies;
+      for (int it = 0; it < options.max_iterations; ++it)
+      {
+        std::vector<Ort::Value>& inputTensors = bindInputs(workspace, 0.25f, 0.45f);
+        auto start = std::chrono::steady_clock::now();
+        forward(inputTensors);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() -
+                                                              start)
+                        .count();
+        latencies.push_back(ms);
+        if (it == 0)
+          shape_report.first_ms = ms;
+
+        if (it + 1 >= options.min_iterations && latencies.size() >= 3)
+        {
+          double reference = median_of_last(latencies, 3);
+          if (std::abs(ms - reference) <= options.tolerance * reference)
+          {
+            shape_report.steady = true;
+            break;
+          }
+        }
+      }
+      shape_report.iterations = static_cast<int>(latencies.size());
+      shape_report.steady_ms = median_of_last(latencies, 3);
+      all_steady &= shape_report.steady;
+      report.shapes.push_back(shape_report);
+    }
   }
 
-  return results;
+  // 2. one full pipeline run warms the host side (postprocess paths, OpenCV's thread pool), on a
+  // workspace of its own so that warming up a model which already serves does not race
+  // predict_once() on workspace_
+  cv::Mat synthetic(getCvSize(), CV_8UC(ch_), cv::Scalar::all(114));
+  InferenceWorkspace pipeline_workspace;
+  for (int it = 0; it < 2; ++it)
+  {
+    auto start = std::chrono::steady_clock::now();
+    predict(synthetic, PredictOptions(), pipeline_workspace);
+    double ms =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+            .count();
+    (it == 0 ? report.pipeline_first_ms : report.pipeline_steady_ms) = ms;
+  }
+
+  report.ready = all_steady && !report.shapes.empty();
+  ready_ = report.ready;
+
+  if (options.verbose)
+  {
+    std::cout << "*** Warmup ***" << std::endl;
+    std::cout << std::fixed << std::setprecision(1);
+    for (const WarmupShapeReport& shape_report : report.shapes)
+    {
+      std::cout << "  batch " << shape_report.batch << " at " << shape_report.input_size.height
+                << "x" << shape_report.input_size.width << ": first " << shape_report.first_ms
+                << "ms, steady " << shape_report.steady_ms << "ms after "
+                << shape_report.iterations << " runs"
+                << (shape_report.steady ? "" : " (not settled)") << std::endl;
+    }
+    std::cout << "  pipeline: first " << report.pipeline_first_ms << "ms, steady "
+              << report.pipeline_steady_ms << "ms" << std::endl;
+    std::cout << "  ready: " << (report.ready ? "yes" : "no") << std::endl;
+  }
+  return report;
 }
 
 std::pair<cv::Size, std::vector<float>>
@@ -415,136 +951,192 @@ AutoBackendOnnx::preprocess_classify(cv::Mat& image,
   return {preprocessed_img.size(), inputTensorValues};
 }
 
-void AutoBackendOnnx::postprocess_masks(cv::Mat& output0,
+cv::Size AutoBackendOnnx::resolveInputSize(const cv::Size& requested) const
+{
+  if (requested.empty() || requested == getCvSize())
+    return getCvSize();
+  const bool dynamic = !inputNodeShapes.empty() && inputNodeShapes[0].size() == 4 &&
+                       inputNodeShapes[0][2] <= 0 && inputNodeShapes[0][3] <= 0;
+  if (!dynamic)
+  {
+    throw std::invalid_argument("Error: input size " + std::to_string(requested.width) + "x" +
+                                std::to_string(requested.height) +
+                                " requested from a model with a static input size");
+  }
+  if (requested.width % getStride() != 0 || requested.height % getStride() != 0)
+  {
+    throw std::invalid_argument("Error: input size " + std::to_string(requested.width) + "x" +
+                                std::to_string(requested.height) +
+                                " is not a multiple of the stride " +
+                                std::to_string(getStride()));
+  }
+  return requested;
+}
+
+cv::Size AutoBackendOnnx::preprocess_into(const cv::Mat& image,
+                                          InferenceWorkspace& workspace,
+                                          int conversionCode,
+                                          const cv::Size& input_size) const
+{
+  // a channel swap is applied while sampling, only other conversions convert the full frame
+  const bool swap_rb = conversionCode >= 0 && is_channel_swap(conversionCode, image);
+  const cv::Mat* source = &image;
+  if (conversionCode >= 0 && !swap_rb)
+  {
+    cv::cvtColor(image, workspace.converted, conversionCode);
+    source = &workspace.converted;
+  }
+
+  cv::Size new_shape = resolveInputSize(input_size);
+  workspace.input_shape = {1, ch_, new_shape.height, new_shape.width};
+  if (task_type_ != YoloTasks_t::CLASSIFY)
+  {
+    const LetterboxTransform& transform =
+        workspace.letterboxTransform(source->size(), new_shape);
+    if (source->depth() == CV_8U)
+    {
+      // resize, pad and CHW conversion in one pass straight into the input tensor
+      workspace.input.resize(static_cast<size_t>(new_shape.area()) * source->channels());
+      transform.applyChw(*source, workspace.input.data(), swap_rb);
+      return new_shape;
+    }
+    transform.apply(*source, workspace.letterboxed);
+  }
+  else
+  {
+    centercrop(*source, workspace.letterboxed, new_shape);
+  }
+
+  const cv::Mat& preprocessed_img = workspace.letterboxed;
+  workspace.input.resize(preprocessed_img.total() * preprocessed_img.channels());
+  fill_chw(preprocessed_img, workspace.input.data());
+  if (swap_rb)
+  {
+    // the first and third planes trade places, at network size
+    const std::ptrdiff_t plane = static_cast<std::ptrdiff_t>(preprocessed_img.total());
+    std::swap_ranges(workspace.input.begin(),
+                     workspace.input.begin() + plane,
+                     workspace.input.begin() + 2 * plane);
+  }
+  return preprocessed_img.size();
+}
+
+void AutoBackendOnnx::postprocess_masks(InferenceWorkspace& workspace,
+                                        cv::Mat& output0,
                                         cv::Mat& output1,
                                         ImageInfo image_info,
                                         std::vector<YoloResults>& output,
                                         int& class_names_num,
                                         float& conf_threshold,
                                         float& iou_threshold,
-                                        int& iw,
-                                        int& ih,
+                                        int& /* iw */,
+                                        int& /* ih */,
                                         int& mw,
                                         int& mh,
                                         int& masks_features_num,
-                                        float mask_threshold /* = 0.5f */)
+                                        float mask_threshold /* = 0.5f */,
+                                        std::vector<MaskDecoder>* deferred_masks) const
 {
   output.clear();
-  std::vector<int> class_ids;
-  std::vector<float> confidences;
-  std::vector<cv::Rect> boxes;
-  std::vector<std::vector<float>> masks;
-  // 4 - your default number of rect parameters {x, y, w, h}
-  int data_width = class_names_num + 4 + masks_features_num;
-  int rows = output0.rows;
-  float* pdata = (float*)output0.data;
-  for (int r = 0; r < rows; ++r)
-  {
-    cv::Mat scores(1, class_names_num, CV_32FC1, pdata + 4);
-    cv::Point class_id;
-    double max_conf;
-    minMaxLoc(scores, 0, &max_conf, 0, &class_id);
-    if (max_conf > conf_threshold)
-    {
-      masks.push_back(std::vector<float>(pdata + 4 + class_names_num, pdata + data_width));
-      class_ids.push_back(class_id.x);
-      confidences.push_back(max_conf);
-
-      float out_w = pdata[2];
-      float out_h = pdata[3];
-      float out_left = MAX((pdata[0] - 0.5 * out_w + 0.5), 0);
-      float out_top = MAX((pdata[1] - 0.5 * out_h + 0.5), 0);
-      cv::Rect_<float> bbox = cv::Rect(out_left, out_top, (out_w + 0.5), (out_h + 0.5));
-      cv::Rect_<float> scaled_bbox = scale_boxes(getCvSize(), bbox, image_info.raw_size);
-      boxes.push_back(scaled_bbox);
-    }
-    pdata += data_width; // next pred
-  }
-
-  //
-  // float masks_threshold = 0.50;
-  // int top_k = 500;
-  // const float& nmsde_eta = 1.0f;
-  std::vector<int> nms_result;
-  cv::dnn::NMSBoxes(
-      boxes, confidences, conf_threshold, iou_threshold, nms_result); // , nms_eta, top_k);
-
-  // select all of the protos tensor
+  DetectionCandidates& candidates = workspace.candidates;
+  decode_candidates_(reinterpret_cast<const float*>(output0.data),
+                     class_names_num,
+                     masks_features_num,
+                     output0.cols,
+                     conf_threshold,
+                     candidates);
+  const LetterboxTransform& transform =
+      workspace.letterboxTransform(image_info.raw_size, inputSize(workspace));
+  std::vector<cv::Rect>& boxes = workspace.boxes;
+  boxes.clear();
+  for (const cv::Rect_<float>& bbox : candidates.boxes)
+    boxes.push_back(transform.toSource(bbox));
+  const std::vector<int>& class_ids = candidates.class_ids;
+  const std::vector<float>& confidences = candidates.confidences;
+
+  std::vector<int>& nms_result = workspace.nms_keep;
+  nms_boxes(boxes, confidences, conf_threshold, iou_threshold, workspace.nms_order, nms_result);
+
+  // the protos of this image are one continuous [masks_features_num, mh * mw] block of output1,
+  // viewed in place instead of cloned
   cv::Size downsampled_size = cv::Size(mw, mh);
-  std::vector<cv::Range> roi_rangs = {cv::Range(0, 1),
-                                      cv::Range::all(),
-                                      cv::Range(0, downsampled_size.height),
-                                      cv::Range(0, downsampled_size.width)};
-  cv::Mat temp_mask = output1(roi_rangs).clone();
-  cv::Mat proto =
-      temp_mask.reshape(0, {masks_features_num, downsampled_size.width * downsampled_size.height});
+  cv::Mat proto(masks_features_num,
+                downsampled_size.width * downsampled_size.height,
+                CV_32F,
+                output1.ptr<float>());
 
+  output.reserve(nms_result.size());
   for (int i = 0; i < nms_result.size(); ++i)
   {
     int idx = nms_result[i];
     boxes[idx] = boxes[idx] & cv::Rect(0, 0, image_info.raw_size.width, image_info.raw_size.height);
-    YoloResults result = {class_ids[idx], confidences[idx], boxes[idx]};
-    _get_mask2(cv::Mat(masks[idx]).t(),
-               proto,
-               image_info,
-               boxes[idx],
-               result.mask,
-               mask_threshold,
-               iw,
-               ih,
-               mw,
-               mh,
-               masks_features_num);
-    output.push_back(result);
+    output.push_back({class_ids[idx], confidences[idx], boxes[idx]});
+  }
+  if (deferred_masks)
+  {
+    deferred_masks->clear();
+    // decoders may run after the next prediction reused the workspace: the coefficients and the
+    // transform are copied out of it, the protos stay in the session output
+    auto geometry = std::make_shared<const LetterboxTransform>(transform);
+    for (int idx : nms_result)
+    {
+      cv::Mat mask_coeffs =
+          cv::Mat(1, masks_features_num, CV_32F, &candidates.extras[idx * masks_features_num])
+              .clone();
+      deferred_masks->push_back(
+          [mask_coeffs, proto, geometry, bound = boxes[idx], mask_threshold, downsampled_size](
+              cv::Mat& mask)
+          {
+            _get_mask2(
+                mask_coeffs, proto, *geometry, bound, mask, mask_threshold, downsampled_size);
+          });
+    }
+    return;
   }
+  decode_masks(output,
+               [&](int i)
+               {
+                 int idx = nms_result[i];
+                 cv::Mat mask_coeffs(
+                     1, masks_features_num, CV_32F, &candidates.extras[idx * masks_features_num]);
+                 _get_mask2(mask_coeffs,
+                            proto,
+                            transform,
+                            boxes[idx],
+                            output[i].mask,
+                            mask_threshold,
+                            downsampled_size);
+               });
 }
 
-void AutoBackendOnnx::postprocess_detects(cv::Mat& output0,
+void AutoBackendOnnx::postprocess_detects(InferenceWorkspace& workspace,
+                                          cv::Mat& output0,
                                           ImageInfo image_info,
                                           std::vector<YoloResults>& output,
                                           int& class_names_num,
                                           float& conf_threshold,
-                                          float& iou_threshold)
+                                          float& iou_threshold) const
 {
   output.clear();
-  std::vector<int> class_ids;
-  std::vector<float> confidences;
-  std::vector<cv::Rect> boxes;
-  std::vector<std::vector<float>> masks;
-  // 4 - your default number of rect parameters {x, y, w, h}
-  int data_width = class_names_num + 4;
-  int rows = output0.rows;
-  float* pdata = (float*)output0.data;
-
-  for (int r = 0; r < rows; ++r)
-  {
-    cv::Mat scores(1, class_names_num, CV_32FC1, pdata + 4);
-    cv::Point class_id;
-    double max_conf;
-    minMaxLoc(scores, nullptr, &max_conf, nullptr, &class_id);
-
-    if (max_conf > conf_threshold)
-    {
-      masks.emplace_back(pdata + 4 + class_names_num, pdata + data_width);
-      class_ids.push_back(class_id.x);
-      confidences.push_back((float)max_conf);
-
-      float out_w = pdata[2];
-      float out_h = pdata[3];
-      float out_left = MAX((pdata[0] - 0.5 * out_w + 0.5), 0);
-      float out_top = MAX((pdata[1] - 0.5 * out_h + 0.5), 0);
-
-      cv::Rect_<float> bbox = cv::Rect_<float>(out_left, out_top, (out_w + 0.5), (out_h + 0.5));
-      cv::Rect_<float> scaled_bbox = scale_boxes(getCvSize(), bbox, image_info.raw_size);
-
-      boxes.push_back(scaled_bbox);
-    }
-    pdata += data_width; // next pred
-  }
-
-  std::vector<int> nms_result;
-  cv::dnn::NMSBoxes(
-      boxes, confidences, conf_threshold, iou_threshold, nms_result); // , nms_eta, top_k);
+  DetectionCandidates& candidates = workspace.candidates;
+  decode_candidates_(reinterpret_cast<const float*>(output0.data),
+                     class_names_num,
+                     0,
+                     output0.cols,
+                     conf_threshold,
+                     candidates);
+  const LetterboxTransform& transform =
+      workspace.letterboxTransform(image_info.raw_size, inputSize(workspace));
+  std::vector<cv::Rect>& boxes = workspace.boxes;
+  boxes.clear();
+  for (const cv::Rect_<float>& bbox : candidates.boxes)
+    boxes.push_back(transform.toSource(bbox));
+  const std::vector<int>& class_ids = candidates.class_ids;
+  const std::vector<float>& confidences = candidates.confidences;
+
+  std::vector<int>& nms_result = workspace.nms_keep;
+  nms_boxes(boxes, confidences, conf_threshold, iou_threshold, workspace.nms_order, nms_result);
+  output.reserve(nms_result.size());
   for (int idx : nms_result)
   {
     boxes[idx] = boxes[idx] & cv::Rect(0, 0, image_info.raw_size.width, image_info.raw_size.height);
@@ -553,22 +1145,38 @@ void AutoBackendOnnx::postprocess_detects(cv::Mat& output0,
   }
 }
 
-void AutoBackendOnnx::postprocess_kpts(cv::Mat& output0,
-                                       ImageInfo& image_info,
+void AutoBackendOnnx::postprocess_kpts(InferenceWorkspace& workspace,
+                                       cv::Mat& output0,
+                                       const ImageInfo& image_info,
                                        std::vector<YoloResults>& output,
                                        int& class_names_num,
                                        float& conf_threshold,
-                                       float& iou_threshold)
-{
-  std::vector<cv::Rect> boxes;
-  std::vector<float> confidences;
-  std::vector<int> class_ids;
-  std::vector<std::vector<float>> rest;
-  std::tie(boxes, confidences, class_ids, rest) =
-      non_max_suppression(output0, class_names_num, output0.cols, conf_threshold, iou_threshold);
-  cv::Size img1_shape = getCvSize();
+                                       float& iou_threshold) const
+{
+  output.clear();
+  DetectionCandidates& candidates = workspace.candidates;
+  const int num_kpt_values = output0.rows - 4 - class_names_num;
+  decode_candidates_(reinterpret_cast<const float*>(output0.data),
+                     class_names_num,
+                     num_kpt_values,
+                     output0.cols,
+                     conf_threshold,
+                     candidates);
+  std::vector<cv::Rect>& boxes = workspace.boxes;
+  boxes.assign(candidates.boxes.begin(), candidates.boxes.end());
+  std::vector<int>& nms_result = workspace.nms_keep;
+  nms_boxes(boxes,
+            candidates.confidences,
+            conf_threshold,
+            iou_threshold,
+            workspace.nms_order,
+            nms_result);
+  output.reserve(nms_result.size());
+
+  const LetterboxTransform& transform =
+      workspace.letterboxTransform(image_info.raw_size, inputSize(workspace));
   auto bound_bbox = cv::Rect_<float>(0, 0, image_info.raw_size.width, image_info.raw_size.height);
-  for (int i = 0; i < boxes.size(); i++)
+  for (int idx : nms_result)
   {
     //             pred[:, :4] = ops.scale_boxes(img.shape[2:], pred[:, :4], shape).round()
     //            pred_kpts = pred[:, 6:].view(len(pred), *self.model.kpt_shape) if len(pred) else
@@ -580,20 +1188,127 @@ void AutoBackendOnnx::postprocess_kpts(cv::Mat& output0,
     //                        names=self.model.names,
     //                        boxes=pred[:, :6],
     //                        keypoints=pred_kpts))
-    cv::Rect_<float> bbox = boxes[i];
-    auto scaled_bbox = scale_boxes(img1_shape, bbox, image_info.raw_size);
+    cv::Rect_<float> bbox = boxes[idx];
+    auto scaled_bbox = transform.toSource(bbox);
     scaled_bbox = scaled_bbox & bound_bbox;
     //        cv::Mat kpt = cv::Mat(rest[i]).t();
     //        scale_coords(img1_shape, kpt, image_info.raw_size);
     // TODO: overload scale_coords so that will accept cv::Mat of shape [17, 3]
     //      so that it will be more similar to what we have in python
-    std::vector<float> kpt = scale_coords(img1_shape, rest[i], image_info.raw_size);
-    YoloResults tmp_res = {class_ids[i], confidences[i], scaled_bbox, {}, kpt};
-    output.push_back(tmp_res);
+    YoloResults tmp_res = {candidates.class_ids[idx], candidates.confidences[idx], scaled_bbox};
+    tmp_res.keypoints.assign(candidates.extras.begin() + idx * num_kpt_values,
+                             candidates.extras.begin() + (idx + 1) * num_kpt_values);
+    transform.toSourceCoords(tmp_res.keypoints);
+    output.push_back(std::move(tmp_res));
   }
 }
 
-void AutoBackendOnnx::postprocess_classify(cv::Mat& outputTensor, std::vector<YoloResults>& results)
+void AutoBackendOnnx::postprocess_end2end(InferenceWorkspace& workspace,
+                                          std::vector<Ort::Value>& outputTensors,
+                                          size_t batch_idx,
+                                          const ImageInfo& image_info,
+                                          std::vector<YoloResults>& output,
+                                          float conf_threshold,
+                                          float mask_threshold,
+                                          std::vector<MaskDecoder>* deferred_masks) const
+{
+  output.clear();
+  const std::vector<int64_t>& shape = outputShape(workspace, outputTensors, 0);
+  const int64_t rows = shape[0];
+  const int cols = static_cast<int>(shape[1]);
+  const int num_extra = cols - 7;
+  const float* data = outputTensors[0].GetTensorData<float>();
+
+  cv::Mat proto;
+  int mask_features_num = 0;
+  int mh = 0;
+  int mw = 0;
+  if (task_type_ == YoloTasks_t::SEGMENT)
+  {
+    const std::vector<int64_t>& mask_shape = outputShape(workspace, outputTensors, 1);
+    mask_features_num = static_cast<int>(mask_shape[1]);
+    mh = static_cast<int>(mask_shape[2]);
+    mw = static_cast<int>(mask_shape[3]);
+    float* all_data1 = outputTensors[1].GetTensorMutableData<float>() +
+                       batch_idx * mask_shape[1] * mask_shape[2] * mask_shape[3];
+    proto = cv::Mat(mask_features_num, mw * mh, CV_32F, all_data1);
+    if (num_extra != mask_features_num)
+    {
+      throw std::runtime_error("Error: end-to-end output has " + std::to_string(num_extra) +
+                               " mask coefficients per detection for " +
+                               std::to_string(mask_features_num) + " prototype masks");
+    }
+  }
+
+  const LetterboxTransform& transform =
+      workspace.letterboxTransform(image_info.raw_size, inputSize(workspace));
+  cv::Rect bound(0, 0, image_info.raw_size.width, image_info.raw_size.height);
+  std::vector<const float*> mask_rows; // coefficients of every kept row, masks are decoded last
+  for (int64_t r = 0; r < rows; ++r)
+  {
+    // rows come grouped by image, the score threshold input already dropped weak ones unless the
+    // model was converted without it
+    const float* row = data + r * cols;
+    if (static_cast<size_t>(row[0]) != batch_idx || row[2] <= conf_threshold)
+      continue;
+
+    // same box convention as decode_candidates
+    float out_w = row[5];
+    float out_h = row[6];
+    cv::Rect_<float> bbox(std::max(row[3] - 0.5f * out_w + 0.5f, 0.0f),
+                          std::max(row[4] - 0.5f * out_h + 0.5f, 0.0f),
+                          out_w + 0.5f,
+                          out_h + 0.5f);
+    cv::Rect box = cv::Rect(transform.toSource(bbox)) & bound;
+    YoloResults result = {static_cast<int>(row[1]), row[2], box};
+
+    if (task_type_ == YoloTasks_t::POSE)
+    {
+      result.keypoints.assign(row + 7, row + cols);
+      transform.toSourceCoords(result.keypoints);
+    }
+    output.push_back(std::move(result));
+    mask_rows.push_back(row + 7);
+  }
+
+  if (task_type_ == YoloTasks_t::SEGMENT && deferred_masks)
+  {
+    deferred_masks->clear();
+    const cv::Size proto_size(mw, mh);
+    // the coefficients and protos stay in the session output, the transform is copied out of the
+    // workspace, which the next prediction reuses
+    auto geometry = std::make_shared<const LetterboxTransform>(transform);
+    for (size_t i = 0; i < output.size(); ++i)
+    {
+      deferred_masks->push_back(
+          [coeffs = mask_rows[i], proto, geometry, bound = cv::Rect(output[i].bbox),
+           mask_features_num, mask_threshold, proto_size](cv::Mat& mask)
+          {
+            cv::Mat mask_coeffs(1, mask_features_num, CV_32F, const_cast<float*>(coeffs));
+            _get_mask2(mask_coeffs, proto, *geometry, bound, mask, mask_threshold, proto_size);
+          });
+    }
+  }
+  else if (task_type_ == YoloTasks_t::SEGMENT)
+  {
+    decode_masks(output,
+                 [&](int i)
+                 {
+                   cv::Mat mask_coeffs(
+                       1, mask_features_num, CV_32F, const_cast<float*>(mask_rows[i]));
+                   _get_mask2(mask_coeffs,
+                              proto,
+                              transform,
+                              cv::Rect(output[i].bbox),
+                              output[i].mask,
+                              mask_threshold,
+                              cv::Size(mw, mh));
+                 });
+  }
+}
+
+void AutoBackendOnnx::postprocess_classify(cv::Mat& outputTensor,
+                                           std::vector<YoloResults>& results) const
 {
   results.clear(); // Clear any existing results
 
@@ -629,59 +1344,47 @@ void AutoBackendOnnx::_get_mask2(const cv::Mat& masks_features,
                                  bool round_downsampled)
 
 {
-  cv::Size img0_shape = image_info.raw_size;
-  cv::Size img1_shape = cv::Size(iw, ih);
-  cv::Size downsampled_size = cv::Size(mw, mh);
-
-  cv::Rect_<float> bound_float(static_cast<float>(bound.x),
-                               static_cast<float>(bound.y),
-                               static_cast<float>(bound.width),
-                               static_cast<float>(bound.height));
-
-  cv::Rect_<float> downsampled_bbox = scale_boxes(img0_shape, bound_float, downsampled_size);
-  cv::Size bound_size = cv::Size(mw, mh);
-  clip_boxes(downsampled_bbox, bound_size);
+  _get_mask2(masks_features,
+             proto,
+             LetterboxTransform(image_info.raw_size, cv::Size(iw, ih)),
+             bound,
+             mask_out,
+             mask_thresh,
+             cv::Size(mw, mh));
+}
 
+void AutoBackendOnnx::_get_mask2(const cv::Mat& masks_features,
+                                 const cv::Mat& proto,
+                                 const LetterboxTransform& transform,
+                                 const cv::Rect& bound,
+                                 cv::Mat& mask_out,
+                                 float mask_thresh,
+                                 const cv::Size& proto_size)
+{
   cv::Mat matmul_res = (masks_features * proto).t();
-  matmul_res = matmul_res.reshape(1, {downsampled_size.height, downsampled_size.width});
+  matmul_res = matmul_res.reshape(1, {proto_size.height, proto_size.width});
   // apply sigmoid to the mask:
   cv::Mat sigmoid_mask;
   exp(-matmul_res, sigmoid_mask);
   sigmoid_mask = 1.0 / (1.0 + sigmoid_mask);
   cv::Mat resized_mask;
-  cv::Rect_<float> input_bbox = scale_boxes(img0_shape, bound_float, img1_shape);
-  cv::resize(sigmoid_mask, resized_mask, img1_shape, 0, 0, cv::INTER_LANCZOS4);
-  cv::Mat pre_out_mask = resized_mask(input_bbox);
+  cv::resize(sigmoid_mask, resized_mask, transform.target(), 0, 0, cv::INTER_LANCZOS4);
+  // drop the letterbox padding, then back to the source size
   cv::Mat scaled_mask;
-  scale_image2(scaled_mask, resized_mask, img0_shape);
-  cv::resize(scaled_mask, mask_out, img0_shape);
-  mask_out = mask_out(bound) > mask_thresh;
+  cv::resize(resized_mask(transform.content()), scaled_mask, transform.source());
+  mask_out = scaled_mask(bound) > mask_thresh;
 }
 
 void AutoBackendOnnx::fill_blob(cv::Mat& image,
                                 float*& blob,
                                 std::vector<int64_t>& inputTensorShape)
 {
-
-  cv::Mat floatImage;
   if (inputTensorShape.empty())
   {
     inputTensorShape = getInputTensorShape();
   }
-  int inputChannelsNum = inputTensorShape[1];
-  int rtype = CV_32FC3;
-  image.convertTo(floatImage, rtype, 1.0f / 255.0);
-  blob = new float[floatImage.cols * floatImage.rows * floatImage.channels()];
-  cv::Size floatImageSize{floatImage.cols, floatImage.rows};
-
-  // hwc -> chw
-  std::vector<cv::Mat> chw(floatImage.channels());
-  for (int i = 0; i < floatImage.channels(); ++i)
-  {
-    chw[i] =
-        cv::Mat(floatImageSize, CV_32FC1, blob + i * floatImageSize.width * floatImageSize.height);
-  }
-  cv::split(floatImage, chw);
+  blob = new float[image.cols * image.rows * image.channels()];
+  fill_chw(image, blob);
 }
 
 std::vector<std::vector<std::vector<cv::Point>>>
@@ -0,0 +1,131 @@
+#include "yolov8_onnxruntime/nn/cascade.h"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+#include <opencv2/core.hpp>
+#include <opencv2/core/utility.hpp>
+
+#include "yolov8_onnxruntime/constants.h"
+#include "yolov8_onnxruntime/utils/augment.h"
+
+namespace yolov8_onnxruntime
+{
+
+DetectClassifyCascade::DetectClassifyCascade(AutoBackendOnnx& detector,
+                                             AutoBackendOnnx& classifier,
+                                             const CascadeOptions& options) :
+    detector_(detector),
+    classifier_(classifier),
+    options_(options)
+{
+  if (classifier_.getTask() != YoloTasks::CLASSIFY)
+    throw std::invalid_argument("Error: cascade classifier has task " + classifier_.getTask());
+  if (classifier_.getMaxBatch() == 1)
+  {
+    std::cerr << "Warning: cascade classifier has a static batch of 1, every crop takes a session "
+                 "call of its own; export it with a dynamic or larger batch to batch the crops"
+              << std::endl;
+  }
+}
+
+std::vector<CascadeResults> DetectClassifyCascade::predict(cv::Mat& image)
+{
+  // predict_once converts the frame in place, so crops are cut from the converted frame below
+  std::vector<YoloResults> detections = detector_.predict_once(image,
+                                                               options_.conf,
+                                                               options_.iou,
+                                                               options_.mask_threshold,
+                                                               options_.conversionCode,
+                                                               false);
+  return classify(image, detections);
+}
+
+std::vector<CascadeResults> DetectClassifyCascade::classify(
+    const cv::Mat& image, const std::vector<YoloResults>& detections)
+{
+  std::vector<CascadeResults> results(detections.size());
+  std::vector<size_t> selected;
+  selected.reserve(detections.size());
+  const cv::Rect frame(0, 0, image.cols, image.rows);
+  for (size_t i = 0; i < detections.size(); ++i)
+  {
+    results[i].detection = detections[i];
+    bool wanted = options_.classes.empty() ||
+                  std::find(options_.classes.begin(),
+                            options_.classes.end(),
+                            detections[i].class_idx) != options_.classes.end();
+    cv::Rect roi = cv::Rect(detections[i].bbox) & frame;
+    if (wanted && roi.area() > 0)
+      selected.push_back(i);
+  }
+  if (selected.empty())
+    return results;
+
+  const cv::Size cls_size = classifier_.getCvSize();
+  const int cls_ch = classifier_.getCh();
+  const int64_t slot_size = static_cast<int64_t>(cls_ch) * cls_size.area();
+  const int max_batch = classifier_.getMaxBatch();
+  const size_t chunk_size = max_batch > 0 ? static_cast<size_t>(max_batch) : selected.size();
+
+  Ort::MemoryInfo memoryInfo = Ort::MemoryInfo::CreateCpu(OrtAllocatorType::OrtArenaAllocator,
+                                                          OrtMemType::OrtMemTypeDefault);
+  if (crops_.size() < chunk_size)
+    crops_.resize(chunk_size);
+  for (size_t begin = 0; begin < selected.size(); begin += chunk_size)
+  {
+    const size_t count = std::min(chunk_size, selected.size() - begin);
+    const int64_t tensor_batch = max_batch > 0 ? max_batch : static_cast<int64_t>(count);
+    // unused slots of a static batch stay zero
+    tensorValues_.assign(static_cast<size_t>(tensor_batch * slot_size), 0.0f);
+
+    // crop, center crop + resize into the slot's reused image and normalize every detection
+    // straight into its tensor slot
+    cv::parallel_for_(cv::Range(0, static_cast<int>(count)),
+                      [&](const cv::Range& range)
+                      {
+                        for (int j = range.start; j < range.end; ++j)
+                        {
+                          const YoloResults& det = results[selected[begin + j]].detection;
+                          cv::Rect_<float> box = det.bbox;
+                          float pad_w = box.width * options_.crop_padding;
+                          float pad_h = box.height * options_.crop_padding;
+                          box = cv::Rect_<float>(box.x - pad_w,
+                                                 box.y - pad_h,
+                                                 box.width + 2 * pad_w,
+                                                 box.height + 2 * pad_h);
+                          cv::Rect roi = cv::Rect(box) & frame;
+                          centercrop(image(roi), crops_[j], cls_size);
+                          fill_chw(crops_[j], tensorValues_.data() + j * slot_size);
+                        }
+                      });
+
+    std::vector<int64_t> tensorShape = {tensor_batch, cls_ch, cls_size.height, cls_size.width};
+    std::vector<Ort::Value> inputTensors;
+    inputTensors.push_back(Ort::Value::CreateTensor<float>(memoryInfo,
+                                                           tensorValues_.data(),
+                                                           tensorValues_.size(),
+                                                           tensorShape.data(),
+                                                           tensorShape.size()));
+    std::vector<Ort::Value> outputTensors = classifier_.forward(inputTensors);
+
+    // [bs, num_classes] -> top-1 per crop
+    std::vector<int64_t> outputShape = outputTensors[0].GetTensorTypeAndShapeInfo().GetShape();
+    const int num_classes = static_cast<int>(outputShape[1]);
+    float* scores = outputTensors[0].GetTensorMutableData<float>();
+    for (size_t j = 0; j < count; ++j)
+    {
+      cv::Mat row(1, num_classes, CV_32F, scores + j * num_classes);
+      cv::Point class_id;
+      double max_conf;
+      cv::minMaxLoc(row, nullptr, &max_conf, nullptr, &class_id);
+      CascadeResults& result = results[selected[begin + j]];
+      result.cls_class_idx = class_id.x;
+      result.cls_conf = static_cast<float>(max_conf);
+    }
+  }
+  return results;
+}
+
+} // namespace yolov8_onnxruntime
@@ -0,0 +1,87 @@
+#include "yolov8_onnxruntime/nn/deadline.h"
+
+#include <algorithm>
+
+namespace yolov8_onnxruntime
+{
+
+RunWatchdog& RunWatchdog::instance()
+{
+  static RunWatchdog watchdog;
+  return watchdog;
+}
+
+RunWatchdog::RunWatchdog() { thread_ = std::thread(&RunWatchdog::run, this); }
+
+RunWatchdog::~RunWatchdog()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  cv_.notify_one();
+  if (thread_.joinable())
+    thread_.join();
+}
+
+uint64_t RunWatchdog::arm(Deadline deadline, Ort::RunOptions& run_options)
+{
+  uint64_t ticket;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ticket = next_ticket_++;
+    entries_[ticket] = Entry{deadline, &run_options, false};
+  }
+  cv_.notify_one();
+  return ticket;
+}
+
+bool RunWatchdog::disarm(uint64_t ticket)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = entries_.find(ticket);
+  if (it == entries_.end())
+    return false;
+  bool fired = it->second.fired;
+  entries_.erase(it);
+  return fired;
+}
+
+bool RunWatchdog::fired(uint64_t ticket) const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = entries_.find(ticket);
+  return it != entries_.end() && it->second.fired;
+}
+
+void RunWatchdog::run()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stopping_)
+  {
+    // terminate what expired, then sleep until the next deadline or a new run
+    Deadline now = std::chrono::steady_clock::now();
+    Deadline next = NO_DEADLINE;
+    for (auto& [ticket, entry] : entries_)
+    {
+      if (entry.fired)
+        continue;
+      if (entry.deadline <= now)
+      {
+        // disarm() takes the same lock, so run_options is still alive here
+        entry.run_options->SetTerminate();
+        entry.fired = true;
+      }
+      else
+      {
+        next = std::min(next, entry.deadline);
+      }
+    }
+    if (next == NO_DEADLINE)
+      cv_.wait(lock);
+    else
+      cv_.wait_until(lock, next);
+  }
+}
+
+} // namespace yolov8_onnxruntime
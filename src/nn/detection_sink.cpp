@@ -0,0 +1,27 @@
+#include "yolov8_onnxruntime/nn/detection_sink.h"
+
+#include "yolov8_onnxruntime/utils/ops.h"
+
+namespace yolov8_onnxruntime
+{
+
+const cv::Mat& StreamedDetection::mask()
+{
+  if (!decoded_ && decoder_)
+  {
+    decoder_(result_.mask);
+    decoded_ = true;
+  }
+  return result_.mask;
+}
+
+void StreamedDetection::decodeMasks(const std::vector<StreamedDetection*>& detections)
+{
+  // the same schedule as the eager decode
+  parallel_for_largest_first(
+      static_cast<int>(detections.size()),
+      [&detections](int i) { return detections[i]->result_.bbox.area(); },
+      [&detections](int i) { detections[i]->mask(); });
+}
+
+} // namespace yolov8_onnxruntime
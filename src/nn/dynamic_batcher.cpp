@@ -0,0 +1,165 @@
+#include "yolov8_onnxruntime/nn/dynamic_batcher.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <opencv2/imgproc.hpp>
+
+namespace yolov8_onnxruntime
+{
+
+DynamicBatcher::DynamicBatcher(AutoBackendOnnx& model, const DynamicBatcherOptions& options) :
+    model_(model),
+    options_(options)
+{
+  // a static batch model is always run at its full batch, bigger batches only add session calls
+  size_t model_batch = model_.getMaxBatch() > 0 ? static_cast<size_t>(model_.getMaxBatch()) : 0;
+  int tuned_batch_size = model_.getSessionConfig().serving.batch_size;
+  size_t tuned_batch = tuned_batch_size > 0 ? static_cast<size_t>(tuned_batch_size) : 0;
+  max_batch_size_ = options_.max_batch_size > 0 ? options_.max_batch_size
+                    : tuned_batch > 0           ? tuned_batch
+                                                : (model_batch > 0 ? model_batch : 8);
+  if (model_batch > 0)
+    max_batch_size_ = std::min(max_batch_size_, model_batch);
+
+  worker_ = std::thread(&DynamicBatcher::run, this);
+}
+
+DynamicBatcher::~DynamicBatcher() { stop(); }
+
+std::future<std::vector<YoloResults>> DynamicBatcher::submit(const cv::Mat& image)
+{
+  return submit(image, ImageInfo{image.size()});
+}
+
+std::future<std::vector<YoloResults>> DynamicBatcher::submit(const cv::Mat& image,
+                                                              const ImageInfo& image_info,
+                                                              Deadline deadline)
+{
+  Request request;
+  // converting here spreads the color conversion over the callers and keeps their data intact
+  if (options_.conversionCode >= 0)
+    cv::cvtColor(image, request.image, options_.conversionCode);
+  else
+    request.image = image;
+  request.image_info = image_info;
+  request.deadline = deadline;
+  std::future<std::vector<YoloResults>> future = request.promise.get_future();
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopping_)
+      throw std::runtime_error("Error: DynamicBatcher is stopped");
+    request.enqueued = std::chrono::steady_clock::now();
+    queue_.push_back(std::move(request));
+    ++stats_.requests;
+  }
+  queue_cv_.notify_one();
+  return future;
+}
+
+void DynamicBatcher::stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  queue_cv_.notify_one();
+  if (worker_.joinable())
+    worker_.join();
+}
+
+DynamicBatcherStats DynamicBatcher::getStats() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void DynamicBatcher::run()
+{
+  std::vector<Request> batch;
+  batch.reserve(max_batch_size_);
+  while (true)
+  {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      queue_cv_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+      if (queue_.empty())
+        return; // stopping and drained
+
+      // wait for the batch to fill up, but never longer than max_wait after the oldest request
+      const auto deadline = queue_.front().enqueued + options_.max_wait;
+      queue_cv_.wait_until(
+          lock, deadline, [this] { return stopping_ || queue_.size() >= max_batch_size_; });
+
+      // requests that expired while queued are dropped here, before any preprocessing
+      const auto now = std::chrono::steady_clock::now();
+      while (!queue_.empty() && batch.size() < max_batch_size_)
+      {
+        Request request = std::move(queue_.front());
+        queue_.pop_front();
+        if (request.deadline != NO_DEADLINE && request.deadline <= now)
+        {
+          request.promise.set_exception(std::make_exception_ptr(
+              DeadlineExceeded("Error: deadline passed while queued for inference")));
+          ++stats_.expired;
+          continue;
+        }
+        batch.push_back(std::move(request));
+      }
+      if (batch.empty())
+        continue;
+      ++stats_.batches;
+      if (batch.size() == max_batch_size_)
+        ++stats_.full_batches;
+    }
+
+    process(batch);
+    batch.clear();
+  }
+}
+
+void DynamicBatcher::process(std::vector<Request>& batch)
+{
+  std::vector<cv::Mat> images;
+  std::vector<ImageInfo> image_infos;
+  images.reserve(batch.size());
+  image_infos.reserve(batch.size());
+  Deadline deadline = batch.front().deadline;
+  for (Request& request : batch)
+  {
+    images.push_back(request.image);
+    image_infos.push_back(request.image_info);
+    deadline = std::max(deadline, request.deadline);
+  }
+
+  try
+  {
+    std::vector<std::vector<YoloResults>> results = model_.predict_batch(images,
+                                                                         image_infos,
+                                                                         options_.conf,
+                                                                         options_.iou,
+                                                                         options_.mask_threshold,
+                                                                         -1,
+                                                                         false,
+                                                                         deadline);
+    for (size_t i = 0; i < batch.size(); ++i)
+      batch[i].promise.set_value(std::move(results[i]));
+  }
+  catch (const DeadlineExceeded&)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stats_.expired += batch.size();
+    }
+    for (Request& request : batch)
+      request.promise.set_exception(std::current_exception());
+  }
+  catch (...)
+  {
+    for (Request& request : batch)
+      request.promise.set_exception(std::current_exception());
+  }
+}
+
+} // namespace yolov8_onnxruntime
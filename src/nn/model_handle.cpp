@@ -0,0 +1,149 @@
+#include "yolov8_onnxruntime/nn/model_handle.h"
+
+#include <exception>
+#include <stdexcept>
+
+namespace yolov8_onnxruntime
+{
+
+ModelHandle::ModelHandle(std::shared_ptr<AutoBackendOnnx> model) : model_(std::move(model))
+{
+  if (!model_)
+    throw std::invalid_argument("Error: model handle needs a model");
+}
+
+ModelHandle::~ModelHandle()
+{
+  std::deque<Reload> abandoned;
+  {
+    std::lock_guard<std::mutex> lock(reload_mutex_);
+    stopping_ = true;
+    abandoned.swap(reloads_);
+  }
+  reload_cv_.notify_one();
+  for (Reload& reload : abandoned)
+  {
+    reload.promise.set_exception(std::make_exception_ptr(
+        std::runtime_error("Error: model handle destroyed before the reload started")));
+  }
+  if (reload_worker_.joinable())
+    reload_worker_.join();
+}
+
+std::shared_ptr<const AutoBackendOnnx> ModelHandle::get() const
+{
+  std::lock_guard<std::mutex> lock(model_mutex_);
+  return model_;
+}
+
+std::vector<YoloResults> ModelHandle::predict(const cv::Mat& image,
+                                              const PredictOptions& options,
+                                              InferenceWorkspace& workspace) const
+{
+  // the local reference keeps the model alive however many swaps happen meanwhile
+  std::shared_ptr<const AutoBackendOnnx> model = get();
+  return model->predict(image, options, workspace);
+}
+
+std::vector<YoloResults> ModelHandle::predict(const cv::Mat& image,
+                                              const ImageInfo& image_info,
+                                              const PredictOptions& options,
+                                              InferenceWorkspace& workspace) const
+{
+  std::shared_ptr<const AutoBackendOnnx> model = get();
+  return model->predict(image, image_info, options, workspace);
+}
+
+std::vector<YoloResults> ModelHandle::predict(const YuvImage& frame,
+                                              const PredictOptions& options,
+                                              InferenceWorkspace& workspace) const
+{
+  std::shared_ptr<const AutoBackendOnnx> model = get();
+  return model->predict(frame, options, workspace);
+}
+
+std::shared_ptr<const AutoBackendOnnx> ModelHandle::swap(std::shared_ptr<AutoBackendOnnx> model)
+{
+  if (!model)
+    throw std::invalid_argument("Error: cannot swap in a null model");
+  std::lock_guard<std::mutex> lock(model_mutex_);
+  if (model->getTaskType() != model_->getTaskType())
+  {
+    throw std::invalid_argument("Error: cannot swap a " + model_->getTask() + " model for a " +
+                                model->getTask() + " model");
+  }
+  std::shared_ptr<const AutoBackendOnnx> previous = std::move(model_);
+  model_ = std::move(model);
+  ++generation_;
+  return previous;
+}
+
+std::future<void> ModelHandle::reload(Loader loader, const WarmupOptions& warmup_options)
+{
+  Reload reload{std::move(loader), warmup_options, {}};
+  std::future<void> result = reload.promise.get_future();
+  {
+    std::lock_guard<std::mutex> lock(reload_mutex_);
+    reloads_.push_back(std::move(reload));
+    // one thread for the handle's lifetime, reloads are rare and run one at a time anyway
+    if (!reload_worker_.joinable())
+      reload_worker_ = std::thread(&ModelHandle::runReloads, this);
+  }
+  reload_cv_.notify_one();
+  return result;
+}
+
+void ModelHandle::runReloads()
+{
+  for (;;)
+  {
+    Reload reload;
+    {
+      std::unique_lock<std::mutex> lock(reload_mutex_);
+      reload_cv_.wait(lock, [this] { return stopping_ || !reloads_.empty(); });
+      if (stopping_)
+        return;
+      reload = std::move(reloads_.front());
+      reloads_.pop_front();
+    }
+    try
+    {
+      std::shared_ptr<AutoBackendOnnx> model = reload.loader();
+      if (!model)
+        throw std::runtime_error("Error: model loader returned no model");
+      model->warmup(reload.warmup_options);
+      // dropping the previous model at the end of this scope only releases it when no request
+      // holds it anymore
+      std::shared_ptr<const AutoBackendOnnx> previous;
+      {
+        // under the lock the destructor sets stopping_ with, so a handle being destroyed never
+        // swaps in what it is about to discard
+        std::lock_guard<std::mutex> lock(reload_mutex_);
+        if (stopping_)
+          throw std::runtime_error("Error: model handle destroyed during the reload");
+        previous = swap(std::move(model));
+      }
+      reload.promise.set_value();
+    }
+    catch (...)
+    {
+      reload.promise.set_exception(std::current_exception());
+    }
+  }
+}
+
+std::future<void> ModelHandle::reload(const std::string& modelPath,
+                                      OnnxProviders_t provider,
+                                      const SessionConfig& config,
+                                      const WarmupOptions& warmup_options)
+{
+  return reload(
+      [modelPath, provider, config]()
+      {
+        return std::make_shared<AutoBackendOnnx>(
+            modelPath.c_str(), "model_handle", provider, config);
+      },
+      warmup_options);
+}
+
+} // namespace yolov8_onnxruntime
@@ -8,12 +8,119 @@
 #include "yolov8_onnxruntime/utils/common.h"
 
 #include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
 #include <thread>
+#include <unordered_map>
 
 
 namespace yolov8_onnxruntime
 {
 
+namespace
+{
+
+/**
+ * @brief Writes the OpenVINO properties the provider options have no key for (the performance
+ * hint) to a JSON file in options.cache_dir for the provider's load_config option and returns its
+ * path.
+ *
+ * The file is named after its content, so there is one per distinct config; it is only written
+ * when missing or different, not on every model construction.
+ */
+std::string write_openvino_config(const OpenVinoOptions& options)
+{
+  // models of one process may be constructed concurrently
+  static std::mutex write_mutex;
+
+  // properties are keyed by the device, for AUTO:GPU,CPU that is AUTO
+  std::string device = options.device_type.substr(0, options.device_type.find(':'));
+  const std::string& hint = OpenVinoPerformanceHintToString(options.performance_hint);
+
+  std::filesystem::path dir(options.cache_dir);
+  std::filesystem::create_directories(dir);
+  std::filesystem::path path = dir / ("yolov8_onnxruntime_" + device + "_" + hint + ".json");
+  const std::string content = "{\"" + device + "\": {\"PERFORMANCE_HINT\": \"" + hint + "\"}}";
+
+  std::lock_guard<std::mutex> lock(write_mutex);
+  std::ifstream existing(path, std::ios::binary);
+  if (existing &&
+      std::string(std::istreambuf_iterator<char>(existing), std::istreambuf_iterator<char>()) ==
+          content)
+  {
+    return path.string();
+  }
+  existing.close();
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file << content;
+  if (!file)
+    throw std::runtime_error("Error: cannot write OpenVINO config " + path.string());
+  return path.string();
+}
+
+Ort::SessionOptions make_session_options(const OnnxProviders_t provider,
+                                         const SessionConfig& config)
+{
+  Ort::SessionOptions sessionOptions = Ort::SessionOptions();
+  // onnxruntime's fusions produce operators the OpenVINO provider cannot take, it gets the graph
+  // as exported and optimizes it itself
+  const GraphOptimizationLevel default_level =
+      provider == OnnxProviders_t::OPENVINO ? ORT_DISABLE_ALL : ORT_ENABLE_ALL;
+  sessionOptions.SetGraphOptimizationLevel(
+      config.graph_optimization_level.value_or(default_level));
+  if (provider != OnnxProviders_t::CPU && config.disable_cpu_fallback)
+    sessionOptions.AddConfigEntry("session.disable_cpu_ep_fallback", "1");
+  if (config.profiling.enabled)
+    sessionOptions.EnableProfiling(config.profiling.file_prefix.c_str());
+  // the thread count only applies to sessions that keep their own pool
+  if (config.context && config.use_global_thread_pools)
+    sessionOptions.DisablePerSessionThreads();
+  else if (config.intra_op_threads > 0)
+    sessionOptions.SetIntraOpNumThreads(config.intra_op_threads);
+  if (config.context && config.share_weights && config.context->hasSharedAllocator())
+    sessionOptions.AddConfigEntry("session.use_env_allocators", "1");
+
+  if (provider == OnnxProviders_t::CUDA)
+  {
+    OrtCUDAProviderOptions cudaOption;
+    sessionOptions.AppendExecutionProvider_CUDA(cudaOption);
+  }
+  else if (provider == OnnxProviders_t::OPENVINO)
+  {
+    const OpenVinoOptions& openvino = config.openvino;
+    std::unordered_map<std::string, std::string> openvinoOptions;
+    openvinoOptions["device_type"] = openvino.device_type;
+    if (!openvino.precision.empty())
+      openvinoOptions["precision"] = openvino.precision;
+    if (openvino.num_streams > 0)
+      openvinoOptions["num_streams"] = std::to_string(openvino.num_streams);
+    if (openvino.num_threads > 0)
+      openvinoOptions["num_of_threads"] = std::to_string(openvino.num_threads);
+    if (!openvino.dynamic_shapes)
+      openvinoOptions["disable_dynamic_shapes"] = "true";
+    if (!openvino.cache_dir.empty())
+    {
+      openvinoOptions["cache_dir"] = openvino.cache_dir;
+      openvinoOptions["load_config"] = write_openvino_config(openvino);
+    }
+    else if (openvino.performance_hint != OpenVinoPerformanceHint_t::LATENCY)
+    {
+      // the hint only reaches OpenVINO through a load_config file, which needs a directory the
+      // deployment owns
+      throw std::invalid_argument("Error: OpenVINO performance hint " +
+                                  OpenVinoPerformanceHintToString(openvino.performance_hint) +
+                                  " needs openvino.cache_dir to write its load_config file");
+    }
+    sessionOptions.AppendExecutionProvider_OpenVINO_V2(openvinoOptions);
+  }
+  return sessionOptions;
+}
+
+} // namespace
+
 /**
  * @brief Base class for any onnx model regarding the target.
  *
@@ -27,15 +134,22 @@ namespace yolov8_onnxruntime
  * @param[in] modelPath Path to the model file.
  * @param[in] logid Log identifier.
  * @param[in] provider Provider (e.g., "CPU" or "CUDA"). (NOTE: for now only CPU is supported)
+ * @param[in] requestedConfig Session and provider settings, see SessionConfig. Its tuned_config
+ * file, if any, is applied over it.
  */
 
 OnnxModelBase::OnnxModelBase(const char* modelPath,
                              const char* logid,
-                             const OnnxProviders_t provider)
+                             const OnnxProviders_t provider,
+                             const SessionConfig& requestedConfig)
     //: modelPath_(modelPath), env(std::move(env)), session(std::move(session))
     :
-    modelPath_(modelPath)
+    modelPath_(modelPath),
+    sessionConfig(requestedConfig.tuned_config.empty()
+                      ? requestedConfig
+                      : load_session_config(requestedConfig.tuned_config, requestedConfig))
 {
+  const SessionConfig& config = sessionConfig;
 
   // ov::Core core;
   // std::vector<std::string> available_devices = core.get_available_devices();
@@ -46,59 +160,35 @@ OnnxModelBase::OnnxModelBase(const char* modelPath,
 
   // TODO: too bad passing `ORT_LOGGING_LEVEL_WARNING` by default - for some cases
   //       info level would make sense too
-  env = Ort::Env(ORT_LOGGING_LEVEL_WARNING, logid);
-  Ort::SessionOptions sessionOptions = Ort::SessionOptions();
+  runtimeContext = config.context;
+  if (!runtimeContext)
+  {
+    standaloneEnv = OnnxRuntimeContext::registerStandaloneEnv();
+    env = Ort::Env(ORT_LOGGING_LEVEL_WARNING, logid);
+  }
+  Ort::Env& sessionEnv = runtimeContext ? runtimeContext->env() : env;
 
   std::vector<std::string> availableProviders = Ort::GetAvailableProviders();
   auto cudaAvailable = std::find(
       availableProviders.begin(), availableProviders.end(), std::string("CUDAExecutionProvider"));
-  OrtCUDAProviderOptions cudaOption;
-
   auto openvinoAvailable = std::find(availableProviders.begin(),
                                      availableProviders.end(),
                                      std::string("OpenVINOExecutionProvider"));
-  OrtOpenVINOProviderOptions openvinoOption;
-  openvinoOption.device_type = "GPU_FP16";
-  openvinoOption.num_of_threads = std::thread::hardware_concurrency() - 1;
-  openvinoOption.cache_dir = "/tmp/openvino_cache";
 
-  if (provider == OnnxProviders_t::CUDA)
-  { // strcmp(provider, OnnxProviders::CUDA.c_str()) == true strcmp(provider, "cuda") //
-    // (providerStr == "cuda")
-    if (cudaAvailable == availableProviders.end())
-    {
-      std::cout << "CUDA is not supported by your ONNXRuntime build. Fallback to CPU." << std::endl;
-      std::cout << "Inference device: CPU" << std::endl;
-    }
-    else
-    {
-      sessionOptions.SetGraphOptimizationLevel(ORT_ENABLE_ALL);
-      std::cout << "Inference device: Cuda GPU" << std::endl;
-      sessionOptions.AppendExecutionProvider_CUDA(cudaOption);
-    }
-  }
-
-  else if (provider == OnnxProviders_t::OPENVINO)
+  OnnxProviders_t requested = provider;
+  if (provider == OnnxProviders_t::CUDA && cudaAvailable == availableProviders.end())
   {
-    if (openvinoAvailable == availableProviders.end())
-    {
-      std::cout << "OpenVINO is not supported by your ONNXRuntime build. Fallback to CPU."
-                << std::endl;
-      std::cout << "Inference device: CPU" << std::endl;
-    }
-    else
-    {
-      sessionOptions.SetGraphOptimizationLevel(ORT_DISABLE_ALL);
-      // std::cout << "Inference device: OpenVINO" << std::endl;
-      sessionOptions.AppendExecutionProvider_OpenVINO(openvinoOption);
-    }
+    std::cout << "CUDA is not supported by your ONNXRuntime build. Fallback to CPU." << std::endl;
+    requested = OnnxProviders_t::CPU;
   }
-
-  else if (provider == OnnxProviders_t::CPU)
-  { // strcmp(provider, OnnxProviders::CPU.c_str()) == true) (providerStr == "cpu") {
-    // "cpu" by default
+  else if (provider == OnnxProviders_t::OPENVINO && openvinoAvailable == availableProviders.end())
+  {
+    std::cout << "OpenVINO is not supported by your ONNXRuntime build. Fallback to CPU."
+              << std::endl;
+    requested = OnnxProviders_t::CPU;
   }
-  else
+  else if (provider != OnnxProviders_t::CPU && provider != OnnxProviders_t::CUDA &&
+           provider != OnnxProviders_t::OPENVINO)
   {
     throw std::runtime_error("Provider not supported (you should never see this message)");
   }
@@ -106,10 +196,37 @@ OnnxModelBase::OnnxModelBase(const char* modelPath,
   //   std::cout << "Inference device: " << std::string(provider) << std::endl;
   auto modelPathW = get_win_path(modelPath);
   std::string modelPathStr(modelPathW.begin(), modelPathW.end());
+  auto createSession = [&](OnnxProviders_t sessionProvider)
+  {
+    Ort::SessionOptions sessionOptions = make_session_options(sessionProvider, config);
+    if (runtimeContext && config.share_weights)
+    {
+      return Ort::Session(sessionEnv,
+                          modelPathStr.c_str(),
+                          sessionOptions,
+                          runtimeContext->prepackedWeights());
+    }
+    return Ort::Session(sessionEnv, modelPathStr.c_str(), sessionOptions);
+  };
   try
   {
     auto start = std::chrono::high_resolution_clock::now();
-    session = Ort::Session(env, modelPathStr.c_str(), sessionOptions);
+    try
+    {
+      session = createSession(requested);
+    }
+    catch (const Ort::Exception& e)
+    {
+      // a device the provider cannot open (e.g. no GPU for OpenVINO's GPU plugin) only shows up
+      // here, fall back unless the caller asked for the provider or nothing
+      if (requested == OnnxProviders_t::CPU || config.disable_cpu_fallback)
+        throw;
+      std::cerr << "Warning: " << OnnxProviderToString(requested)
+                << " provider failed to create the session, fallback to CPU: " << e.what()
+                << std::endl;
+      requested = OnnxProviders_t::CPU;
+      session = createSession(requested);
+    }
     auto end = std::chrono::high_resolution_clock::now();
     auto dur_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
     std::cout << "Model loaded in " << dur_ms << "ms" << std::endl;
@@ -119,6 +236,19 @@ OnnxModelBase::OnnxModelBase(const char* modelPath,
     std::cerr << "Error Loading Model: " << e.what() << std::endl;
     throw;
   }
+  requestedProvider = requested;
+  profilingActive = config.profiling.enabled;
+  if (requestedProvider == OnnxProviders_t::OPENVINO)
+  {
+    std::cout << "Inference device: OpenVINO " << config.openvino.device_type << " ("
+              << OpenVinoPerformanceHintToString(config.openvino.performance_hint) << ")"
+              << std::endl;
+  }
+  else
+  {
+    std::cout << "Inference device: "
+              << (requestedProvider == OnnxProviders_t::CUDA ? "Cuda GPU" : "CPU") << std::endl;
+  }
   // session = Ort::Session(env)
   // https://github.com/microsoft/onnxruntime/issues/14157
   // std::vector<const char*> inputNodeNames; //
@@ -133,6 +263,7 @@ OnnxModelBase::OnnxModelBase(const char* modelPath,
     auto input_name = session.GetInputNameAllocated(i, allocator);
     inputNodeNameAllocatedStrings.push_back(std::move(input_name));
     inputNodeNames.push_back(inputNodeNameAllocatedStrings.back().get());
+    inputNodeShapes.push_back(session.GetInputTypeInfo(i).GetTensorTypeAndShapeInfo().GetShape());
   }
   // -----------------
   // init output names
@@ -145,6 +276,8 @@ OnnxModelBase::OnnxModelBase(const char* modelPath,
     auto output_name = session.GetOutputNameAllocated(i, output_names_allocator);
     outputNodeNameAllocatedStrings.push_back(std::move(output_name));
     outputNodeNames.push_back(outputNodeNameAllocatedStrings.back().get());
+    outputNodeShapes.push_back(
+        session.GetOutputTypeInfo(i).GetTensorTypeAndShapeInfo().GetShape());
   }
   // -------------------------
   // initialize model metadata
@@ -193,6 +326,16 @@ const std::vector<std::string>& OnnxModelBase::getInputNames() { return inputNod
 
 const std::vector<std::string>& OnnxModelBase::getOutputNames() { return outputNodeNames; }
 
+const std::vector<std::vector<int64_t>>& OnnxModelBase::getInputShapes()
+{
+  return inputNodeShapes;
+}
+
+const std::vector<std::vector<int64_t>>& OnnxModelBase::getOutputShapes()
+{
+  return outputNodeShapes;
+}
+
 const Ort::ModelMetadata& OnnxModelBase::getModelMetadata() { return model_metadata; }
 
 const std::unordered_map<std::string, std::string>& OnnxModelBase::getMetadata()
@@ -202,7 +345,7 @@ const std::unordered_map<std::string, std::string>& OnnxModelBase::getMetadata()
 
 const Ort::Session& OnnxModelBase::getSession() { return session; }
 
-const char* OnnxModelBase::getModelPath() { return modelPath_; }
+const char* OnnxModelBase::getModelPath() { return modelPath_.c_str(); }
 
 const std::vector<const char*> OnnxModelBase::getOutputNamesCStr() { return outputNamesCStr; }
 
@@ -210,18 +353,72 @@ const std::vector<const char*> OnnxModelBase::getInputNamesCStr() { return input
 
 std::vector<Ort::Value> OnnxModelBase::forward(std::vector<Ort::Value>& inputTensors)
 {
-  // todo: make runOptions parameter here
-
-  return session.Run(Ort::RunOptions{nullptr},
-                     inputNamesCStr.data(),
-                     inputTensors.data(),
-                     inputNamesCStr.size(),
-                     outputNamesCStr.data(),
-                     outputNamesCStr.size());
+  return static_cast<const OnnxModelBase&>(*this).forward(inputTensors);
 }
 
-// OnnxModelBase::~OnnxModelBase() {
-//    // empty body
-//}
+std::vector<Ort::Value> OnnxModelBase::forward(std::vector<Ort::Value>& inputTensors) const
+{
+  return forward(inputTensors, Ort::RunOptions{nullptr});
+}
+
+std::vector<Ort::Value> OnnxModelBase::forward(std::vector<Ort::Value>& inputTensors,
+                                               Deadline deadline) const
+{
+  if (deadline == NO_DEADLINE)
+    return forward(inputTensors);
+  check_deadline(deadline, "inference");
+
+  Ort::RunOptions runOptions;
+  RunDeadline guard(deadline, runOptions);
+  try
+  {
+    return forward(inputTensors, runOptions);
+  }
+  catch (const Ort::Exception&)
+  {
+    if (guard.fired())
+      throw DeadlineExceeded("Error: inference terminated at its deadline");
+    throw;
+  }
+}
+
+std::vector<Ort::Value> OnnxModelBase::forward(std::vector<Ort::Value>& inputTensors,
+                                               const Ort::RunOptions& runOptions) const
+{
+  // Run is only non-const in the C++ wrapper, OrtApi::Run may be called concurrently on a session
+  std::vector<Ort::Value> outputTensors =
+      const_cast<Ort::Session&>(session).Run(runOptions,
+                                             inputNamesCStr.data(),
+                                             inputTensors.data(),
+                                             inputNamesCStr.size(),
+                                             outputNamesCStr.data(),
+                                             outputNamesCStr.size());
+  return outputTensors;
+}
+
+std::string OnnxModelBase::endProfiling() const
+{
+  std::lock_guard<std::mutex> lock(profileMutex);
+  if (profilingActive.exchange(false))
+  {
+    Ort::AllocatorWithDefaultOptions allocator;
+    profilePath = const_cast<Ort::Session&>(session).EndProfilingAllocated(allocator).get();
+  }
+  return profilePath;
+}
+
+ProfileReport OnnxModelBase::profileReport(int skip_runs) const
+{
+  std::string path = endProfiling();
+  if (path.empty())
+    throw std::runtime_error("Error: profiling was not enabled for this session");
+  return parse_ort_profile(path, skip_runs);
+}
+
+OnnxModelBase::~OnnxModelBase()
+{
+  // the session has to go before the environment it was created in, members would release it last
+  session = Ort::Session{nullptr};
+}
 
 } // namespace yolov8_onnxruntime
\ No newline at end of file
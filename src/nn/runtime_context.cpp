@@ -0,0 +1,50 @@
+#include "yolov8_onnxruntime/nn/runtime_context.h"
+
+#include <atomic>
+#include <iostream>
+#include <stdexcept>
+
+namespace yolov8_onnxruntime
+{
+
+namespace
+{
+
+// environments of models constructed without a context that are still alive
+std::atomic<int> standalone_envs{0};
+
+} // namespace
+
+OnnxRuntimeContext::OnnxRuntimeContext(const RuntimeContextOptions& options) : options_(options)
+{
+  // the process environment would already exist, without the global thread pools
+  if (standalone_envs.load() > 0)
+  {
+    throw std::runtime_error("Error: the runtime context has to be created before any model "
+                             "without one, onnxruntime keeps one environment per process");
+  }
+  Ort::ThreadingOptions threading;
+  threading.SetGlobalIntraOpNumThreads(options_.intra_op_threads);
+  threading.SetGlobalInterOpNumThreads(options_.inter_op_threads);
+  threading.SetGlobalSpinControl(options_.allow_spinning ? 1 : 0);
+  env_ = Ort::Env(threading, options_.log_level, options_.log_id.c_str());
+  if (options_.shared_allocator)
+  {
+    Ort::MemoryInfo memoryInfo =
+        Ort::MemoryInfo::CreateCpu(OrtAllocatorType::OrtArenaAllocator, OrtMemTypeDefault);
+    Ort::ArenaCfg arenaCfg(0, -1, -1, -1); // onnxruntime's defaults
+    env_.CreateAndRegisterAllocator(memoryInfo, arenaCfg);
+  }
+  std::cout << "Runtime context: global thread pools with "
+            << (options_.intra_op_threads > 0 ? std::to_string(options_.intra_op_threads)
+                                              : std::string("default"))
+            << " intra-op threads" << std::endl;
+}
+
+std::shared_ptr<void> OnnxRuntimeContext::registerStandaloneEnv()
+{
+  ++standalone_envs;
+  return std::shared_ptr<void>(nullptr, [](void*) { --standalone_envs; });
+}
+
+} // namespace yolov8_onnxruntime
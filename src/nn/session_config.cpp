@@ -0,0 +1,120 @@
+#include "yolov8_onnxruntime/nn/session_config.h"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include "yolov8_onnxruntime/utils/json.h"
+#include "yolov8_onnxruntime/utils/serialization.h"
+
+namespace yolov8_onnxruntime
+{
+
+namespace
+{
+
+bool bool_or(const JsonValue& object, const std::string& key, bool fallback)
+{
+  const JsonValue* value = object.find(key);
+  return value ? value->asBool() : fallback;
+}
+
+int int_or(const JsonValue& object, const std::string& key, int fallback)
+{
+  return static_cast<int>(object.numberOr(key, fallback));
+}
+
+OpenVinoPerformanceHint_t hint_from_string(const std::string& hint)
+{
+  if (hint == OpenVinoPerformanceHints::LATENCY)
+    return OpenVinoPerformanceHint_t::LATENCY;
+  if (hint == OpenVinoPerformanceHints::THROUGHPUT)
+    return OpenVinoPerformanceHint_t::THROUGHPUT;
+  if (hint == OpenVinoPerformanceHints::CUMULATIVE_THROUGHPUT)
+    return OpenVinoPerformanceHint_t::CUMULATIVE_THROUGHPUT;
+  throw std::runtime_error("Error: unknown OpenVINO performance hint " + hint);
+}
+
+} // namespace
+
+SessionConfig load_session_config(const std::string& path, const SessionConfig& base)
+{
+  std::ifstream file(path);
+  if (!file)
+    throw std::runtime_error("Error: cannot read session config " + path);
+  std::stringstream text;
+  text << file.rdbuf();
+  JsonValue root = JsonValue::parse(text.str());
+  if (!root.isObject())
+    throw std::runtime_error("Error: session config " + path + " is not a JSON object");
+
+  SessionConfig config = base;
+  if (root.find("graph_optimization_level"))
+  {
+    config.graph_optimization_level =
+        static_cast<GraphOptimizationLevel>(int_or(root, "graph_optimization_level", 0));
+  }
+  config.disable_cpu_fallback =
+      bool_or(root, "disable_cpu_fallback", config.disable_cpu_fallback);
+  config.use_global_thread_pools =
+      bool_or(root, "use_global_thread_pools", config.use_global_thread_pools);
+  config.intra_op_threads = int_or(root, "intra_op_threads", config.intra_op_threads);
+  config.share_weights = bool_or(root, "share_weights", config.share_weights);
+
+  if (const JsonValue* openvino = root.find("openvino"))
+  {
+    OpenVinoOptions& ov = config.openvino;
+    ov.device_type = openvino->stringOr("device_type", ov.device_type);
+    ov.precision = openvino->stringOr("precision", ov.precision);
+    const std::string& hint = OpenVinoPerformanceHintToString(ov.performance_hint);
+    ov.performance_hint = hint_from_string(openvino->stringOr("performance_hint", hint));
+    ov.num_streams = int_or(*openvino, "num_streams", ov.num_streams);
+    ov.num_threads = int_or(*openvino, "num_threads", ov.num_threads);
+    ov.cache_dir = openvino->stringOr("cache_dir", ov.cache_dir);
+    ov.dynamic_shapes = bool_or(*openvino, "dynamic_shapes", ov.dynamic_shapes);
+  }
+  if (const JsonValue* serving = root.find("serving"))
+  {
+    config.serving.batch_size = int_or(*serving, "batch_size", config.serving.batch_size);
+  }
+  return config;
+}
+
+void save_session_config(const std::string& path,
+                         const SessionConfig& config,
+                         const std::vector<std::pair<std::string, double>>& notes)
+{
+  const OpenVinoOptions& ov = config.openvino;
+  auto flag = [](bool value) { return value ? "true" : "false"; };
+  std::ofstream file(path);
+  file << "{\n";
+  // left out while unset, so the provider's default keeps applying
+  if (config.graph_optimization_level)
+  {
+    file << "  \"graph_optimization_level\": "
+         << static_cast<int>(*config.graph_optimization_level) << ",\n";
+  }
+  file << "  \"disable_cpu_fallback\": " << flag(config.disable_cpu_fallback) << ",\n"
+       << "  \"use_global_thread_pools\": " << flag(config.use_global_thread_pools) << ",\n"
+       << "  \"intra_op_threads\": " << config.intra_op_threads << ",\n"
+       << "  \"share_weights\": " << flag(config.share_weights) << ",\n"
+       << "  \"openvino\": {\"device_type\": \"" << json_escape(ov.device_type)
+       << "\", \"precision\": \"" << json_escape(ov.precision) << "\", \"performance_hint\": \""
+       << OpenVinoPerformanceHintToString(ov.performance_hint)
+       << "\", \"num_streams\": " << ov.num_streams << ", \"num_threads\": " << ov.num_threads
+       << ", \"cache_dir\": \"" << json_escape(ov.cache_dir)
+       << "\", \"dynamic_shapes\": " << flag(ov.dynamic_shapes) << "},\n"
+       << "  \"serving\": {\"batch_size\": " << config.serving.batch_size << "}";
+  if (!notes.empty())
+  {
+    file << ",\n  \"tuning\": {";
+    for (size_t i = 0; i < notes.size(); ++i)
+      file << (i ? ", " : "") << '"' << json_escape(notes[i].first) << "\": " << notes[i].second;
+    file << "}";
+  }
+  file << "\n}\n";
+  if (!file)
+    throw std::runtime_error("Error: cannot write session config " + path);
+}
+
+} // namespace yolov8_onnxruntime
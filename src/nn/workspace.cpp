@@ -0,0 +1,77 @@
+#include "yolov8_onnxruntime/nn/workspace.h"
+
+namespace yolov8_onnxruntime
+{
+
+InferenceWorkspace::InferenceWorkspace() :
+    memory_info_(Ort::MemoryInfo::CreateCpu(OrtAllocatorType::OrtArenaAllocator,
+                                            OrtMemType::OrtMemTypeDefault))
+{
+  input_tensors_.reserve(3);
+}
+
+void InferenceWorkspace::reset()
+{
+  candidates.clear();
+  boxes.clear();
+  nms_order.clear();
+  nms_keep.clear();
+}
+
+size_t InferenceWorkspace::capacityBytes() const
+{
+  auto mat_bytes = [](const cv::Mat& mat)
+  { return mat.u ? mat.u->size : static_cast<size_t>(0); };
+  size_t shape_bytes = 0;
+  for (const std::vector<int64_t>& shape : output_shapes)
+    shape_bytes += shape.capacity() * sizeof(int64_t);
+  return mat_bytes(converted) + mat_bytes(letterboxed) +
+         (input.capacity() + nms_thresholds.capacity()) * sizeof(float) +
+         input_shape.capacity() * sizeof(int64_t) +
+         candidates.boxes.capacity() * sizeof(cv::Rect_<float>) +
+         candidates.confidences.capacity() * sizeof(float) +
+         candidates.class_ids.capacity() * sizeof(int) +
+         candidates.extras.capacity() * sizeof(float) + boxes.capacity() * sizeof(cv::Rect) +
+         (nms_order.capacity() + nms_keep.capacity()) * sizeof(int) + shape_bytes;
+}
+
+const LetterboxTransform& InferenceWorkspace::letterboxTransform(const cv::Size& source,
+                                                                const cv::Size& target)
+{
+  for (const LetterboxTransform& transform : transforms_)
+  {
+    if (transform.matches(source, target))
+      return transform;
+  }
+  LetterboxTransform& slot = transforms_[next_transform_];
+  next_transform_ = (next_transform_ + 1) % transforms_.size();
+  slot = LetterboxTransform(source, target);
+  return slot;
+}
+
+std::vector<Ort::Value>& InferenceWorkspace::inputTensors()
+{
+  if (input_tensors_.empty() || bound_data_ != input.data() || bound_size_ != input.size() ||
+      bound_shape_ != input_shape || bound_thresholds_ != nms_thresholds.data() ||
+      bound_thresholds_size_ != nms_thresholds.size())
+  {
+    input_tensors_.clear();
+    input_tensors_.push_back(Ort::Value::CreateTensor<float>(
+        memory_info_, input.data(), input.size(), input_shape.data(), input_shape.size()));
+    // the scalar tensors view nms_thresholds, new values are picked up without rebinding
+    const int64_t scalar_shape[] = {1};
+    for (float& threshold : nms_thresholds)
+    {
+      input_tensors_.push_back(
+          Ort::Value::CreateTensor<float>(memory_info_, &threshold, 1, scalar_shape, 1));
+    }
+    bound_data_ = input.data();
+    bound_size_ = input.size();
+    bound_shape_ = input_shape;
+    bound_thresholds_ = nms_thresholds.data();
+    bound_thresholds_size_ = nms_thresholds.size();
+  }
+  return input_tensors_;
+}
+
+} // namespace yolov8_onnxruntime
@@ -0,0 +1,152 @@
+// Counts heap allocations per predict_once call to check that the steady state of preprocess and
+// postprocess stays allocation free.
+//
+// Allocations are counted with tests/alloc_counter.h, for the whole process. The session run is
+// measured on its own so that what the library adds on top of it can be reported separately.
+// OpenCV's thread pool allocates a job per parallel_for_ call, which is the scheduler's cost and
+// not the pipeline's, so OpenCV runs on the calling thread here (onnxruntime keeps its threads).
+//
+// Exits with 1 when a checked pipeline allocates in steady state, and with 77 (what ctest reports
+// as skipped) when the model or image does not exist or allocations cannot be counted (no glibc).
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <opencv2/core/utility.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+#include <yolov8_onnxruntime/nn/autobackend.h>
+#include <yolov8_onnxruntime/utils/common.h>
+
+#include "alloc_counter.h"
+
+namespace yo = yolov8_onnxruntime;
+
+#if YO_COUNTS_ALLOCATIONS
+
+using yo::test::AllocationScope;
+
+int main(int argc, char** argv)
+{
+  std::string model_path;
+  std::string image_path;
+  std::string provider = yo::OnnxProviders::CPU;
+  int runs = 20;
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    auto next = [&]() -> std::string
+    {
+      if (i + 1 >= argc)
+        throw std::runtime_error("Error: missing value for " + arg);
+      return argv[++i];
+    };
+    if (arg == "--model")
+      model_path = next();
+    else if (arg == "--image")
+      image_path = next();
+    else if (arg == "--provider")
+      provider = next();
+    else if (arg == "--runs")
+      runs = std::stoi(next());
+    else
+    {
+      std::cerr << "usage: " << argv[0]
+                << " --model model.onnx --image image.jpg [--provider cpu|cuda|openvino]"
+                << " [--runs 20]" << std::endl;
+      return 2;
+    }
+  }
+  if (model_path.empty() || image_path.empty())
+  {
+    std::cerr << "Error: --model and --image are required" << std::endl;
+    return 2;
+  }
+  if (!std::filesystem::is_regular_file(model_path) ||
+      !std::filesystem::is_regular_file(image_path))
+  {
+    std::cerr << "Skipped: " << model_path << " or " << image_path << " does not exist"
+              << std::endl;
+    return 77;
+  }
+
+  yo::OnnxProviders_t onnx_provider = yo::OnnxProviders_t::CPU;
+  if (provider == yo::OnnxProviders::CUDA)
+    onnx_provider = yo::OnnxProviders_t::CUDA;
+  else if (provider == yo::OnnxProviders::OPENVINO)
+    onnx_provider = yo::OnnxProviders_t::OPENVINO;
+
+  cv::setNumThreads(1);
+  yo::AutoBackendOnnx model(model_path.c_str(), "alloc_probe", onnx_provider);
+  const cv::Mat source = cv::imread(image_path);
+  if (source.empty())
+  {
+    std::cerr << "Error: cannot read " << image_path << std::endl;
+    return 1;
+  }
+
+  float conf = 0.30f;
+  float iou = 0.45f;
+  float mask_threshold = 0.5f;
+  cv::Mat frame;
+
+  // session run alone, on tensors created outside the counted window
+  yo::InferenceWorkspace workspace;
+  workspace.input_shape = model.getInputTensorShape();
+  workspace.input.assign(yo::vector_product(workspace.input_shape), 0.5f);
+  if (model.isEndToEnd() && model.getInputNames().size() == 3)
+    workspace.nms_thresholds = {iou, conf};
+  std::vector<Ort::Value>& inputTensors = workspace.inputTensors();
+
+  size_t forward_allocs = 0;
+  size_t predict_allocs = 0;
+  size_t first_predict_allocs = 0;
+  size_t objects = 0;
+  for (int run = 0; run < runs; ++run)
+  {
+    {
+      AllocationScope scope;
+      std::vector<Ort::Value> outputs = model.forward(inputTensors);
+      forward_allocs = scope.count();
+    }
+
+    source.copyTo(frame);
+    AllocationScope scope;
+    std::vector<yo::YoloResults> results =
+        model.predict_once(frame, conf, iou, mask_threshold, -1, false);
+    predict_allocs = scope.count();
+    if (run == 0)
+      first_predict_allocs = predict_allocs;
+    objects = results.size();
+  }
+
+  // the returned vector and the per-object keypoints are result payload, not overhead. Mask
+  // decoding and the output shape query of end-to-end models are outside the allocation-free
+  // steady state (see InferenceWorkspace), so those models are reported but not checked
+  const std::string task = model.getTask();
+  size_t payload = objects > 0 ? 1 : 0;
+  if (task == yo::YoloTasks::POSE)
+    payload += objects;
+  long long pipeline_allocs = static_cast<long long>(predict_allocs) -
+                              static_cast<long long>(forward_allocs) -
+                              static_cast<long long>(payload);
+
+  std::cout << "{\"model\":\"" << model_path << "\",\"task\":\"" << task
+            << "\",\"objects\":" << objects << ",\"first_predict_allocs\":" << first_predict_allocs
+            << ",\"predict_allocs\":" << predict_allocs << ",\"forward_allocs\":" << forward_allocs
+            << ",\"payload_allocs\":" << payload << ",\"pipeline_allocs\":" << pipeline_allocs
+            << "}" << std::endl;
+  bool checked = task != yo::YoloTasks::SEGMENT && !model.isEndToEnd();
+  return checked && pipeline_allocs > 0 ? 1 : 0;
+}
+
+#else
+
+int main()
+{
+  std::cerr << "Skipped: counting allocations needs glibc" << std::endl;
+  return 77;
+}
+
+#endif
@@ -0,0 +1,410 @@
+// Offline search for the session settings that run a model best on this host.
+//
+// Every candidate runs for --seconds with its sessions predicting side by side, each from its own
+// thread, and the best one is written as a tuned config that AutoBackendOnnx applies through
+// SessionConfig::tuned_config (see yo::load_session_config). CPU candidates vary the intra-op
+// threads per session, the session count and the batch size; OpenVINO candidates the streams and
+// the performance hint instead of the threads. --objective throughput maximizes images/s, latency
+// minimizes the p99 of one predict_batch call (preprocessing, session run and postprocessing, what
+// a caller waits for); with --latency-cap, candidates whose p99 exceeds it are rejected either way.
+// The session count the best candidate ran with is written under "tuning" for the deployment to
+// start as many models; the tuned threads per session assume it.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv2/imgcodecs.hpp>
+
+#include <yolov8_onnxruntime/nn/autobackend.h>
+#include <yolov8_onnxruntime/nn/session_config.h>
+
+namespace yo = yolov8_onnxruntime;
+
+namespace
+{
+
+struct Options
+{
+  std::string model;
+  std::string image;
+  std::string output = "tuned_config.json";
+  yo::OnnxProviders_t provider = yo::OnnxProviders_t::CPU;
+  std::string ov_device = "CPU";
+  // holds the compiled models and the load_config files of the performance hints
+  std::string ov_cache_dir = "openvino_cache";
+  bool latency_objective = false;
+  double latency_cap_ms = 0.0; // 0: no cap
+  double seconds = 3.0;
+  int max_threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+  std::vector<int> batches = {1, 2, 4, 8};
+};
+
+struct Candidate
+{
+  yo::SessionConfig config;
+  int sessions = 1;
+  int batch = 1;
+};
+
+struct Measurement
+{
+  bool ok = false;
+  double images_per_s = 0.0;
+  // of one predict_batch call, pre- and postprocessing included
+  double median_ms = 0.0;
+  double p99_ms = 0.0;
+};
+
+void print_usage(const char* argv0)
+{
+  std::cerr
+      << "Usage: " << argv0 << " --model MODEL.onnx [--output tuned_config.json]\n"
+      << "  --provider cpu|cuda|openvino   execution provider (default cpu)\n"
+      << "  --ov-device DEVICE             OpenVINO device, e.g. CPU, GPU, AUTO (default CPU)\n"
+      << "  --ov-cache-dir DIR             OpenVINO model cache and hint configs, written to the\n"
+      << "                                 tuned config as well (default openvino_cache)\n"
+      << "  --image IMAGE                  image to run on (default a blank frame, which skips\n"
+      << "                                 most of the postprocessing)\n"
+      << "  --objective throughput|latency maximize images/s or minimize the p99 of predict_batch\n"
+      << "                                 (default throughput)\n"
+      << "  --latency-cap MS               reject candidates whose predict_batch p99 exceeds MS\n"
+      << "  --seconds S                    run time of every candidate (default 3)\n"
+      << "  --max-threads N                cores to spread over the sessions (default all)\n"
+      << "  --batches 1,2,4,8              batch sizes to try on dynamic batch models\n";
+}
+
+std::vector<int> parse_list(const std::string& text)
+{
+  std::vector<int> values;
+  std::stringstream stream(text);
+  std::string item;
+  while (std::getline(stream, item, ','))
+  {
+    if (!item.empty())
+      values.push_back(std::max(1, std::stoi(item)));
+  }
+  if (values.empty())
+    throw std::invalid_argument("empty list: " + text);
+  return values;
+}
+
+bool parse_args(int argc, char** argv, Options& opts)
+{
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    auto next = [&]() -> std::string
+    {
+      if (i + 1 >= argc)
+        throw std::invalid_argument("missing value for " + arg);
+      return argv[++i];
+    };
+
+    if (arg == "--model")
+      opts.model = next();
+    else if (arg == "--image")
+      opts.image = next();
+    else if (arg == "--output")
+      opts.output = next();
+    else if (arg == "--provider")
+    {
+      std::string provider = next();
+      if (provider == yo::OnnxProviders::CPU)
+        opts.provider = yo::OnnxProviders_t::CPU;
+      else if (provider == yo::OnnxProviders::CUDA)
+        opts.provider = yo::OnnxProviders_t::CUDA;
+      else if (provider == yo::OnnxProviders::OPENVINO)
+        opts.provider = yo::OnnxProviders_t::OPENVINO;
+      else
+        throw std::invalid_argument("unknown provider: " + provider);
+    }
+    else if (arg == "--ov-device")
+      opts.ov_device = next();
+    else if (arg == "--ov-cache-dir")
+      opts.ov_cache_dir = next();
+    else if (arg == "--objective")
+    {
+      std::string objective = next();
+      if (objective != "throughput" && objective != "latency")
+        throw std::invalid_argument("unknown objective: " + objective);
+      opts.latency_objective = objective == "latency";
+    }
+    else if (arg == "--latency-cap")
+      opts.latency_cap_ms = std::stod(next());
+    else if (arg == "--seconds")
+      opts.seconds = std::max(0.1, std::stod(next()));
+    else if (arg == "--max-threads")
+      opts.max_threads = std::max(1, std::stoi(next()));
+    else if (arg == "--batches")
+      opts.batches = parse_list(next());
+    else if (arg == "-h" || arg == "--help")
+      return false;
+    else
+      throw std::invalid_argument("unknown argument: " + arg);
+  }
+  return !opts.model.empty();
+}
+
+/// 1, 2, 4, ... up to limit, and limit itself.
+std::vector<int> powers_of_two(int limit)
+{
+  std::vector<int> values;
+  for (int value = 1; value < limit; value *= 2)
+    values.push_back(value);
+  values.push_back(limit);
+  return values;
+}
+
+std::vector<Candidate> make_candidates(const Options& opts, const std::vector<int>& batches)
+{
+  std::vector<Candidate> candidates;
+  auto add = [&](const yo::SessionConfig& config, int sessions)
+  {
+    for (int batch : batches)
+      candidates.push_back(Candidate{config, sessions, batch});
+  };
+
+  if (opts.provider == yo::OnnxProviders_t::CPU)
+  {
+    // every split of the cores into sessions x intra-op threads
+    for (int sessions : powers_of_two(opts.max_threads))
+    {
+      for (int threads : powers_of_two(opts.max_threads / sessions))
+      {
+        yo::SessionConfig config;
+        config.use_global_thread_pools = false;
+        config.intra_op_threads = threads;
+        add(config, sessions);
+      }
+    }
+  }
+  else if (opts.provider == yo::OnnxProviders_t::OPENVINO)
+  {
+    const yo::OpenVinoPerformanceHint_t hints[] = {yo::OpenVinoPerformanceHint_t::LATENCY,
+                                                   yo::OpenVinoPerformanceHint_t::THROUGHPUT};
+    for (yo::OpenVinoPerformanceHint_t hint : hints)
+    {
+      // 0 streams lets the hint pick
+      for (int streams : {0, 1, 2, 4})
+      {
+        for (int sessions : {1, 2, 4})
+        {
+          yo::SessionConfig config;
+          config.openvino.device_type = opts.ov_device;
+          config.openvino.performance_hint = hint;
+          config.openvino.cache_dir = opts.ov_cache_dir;
+          config.openvino.num_streams = streams;
+          add(config, sessions);
+        }
+      }
+    }
+  }
+  else
+  {
+    for (int sessions : {1, 2})
+      add(yo::SessionConfig(), sessions);
+  }
+  return candidates;
+}
+
+double percentile(std::vector<double> values, double q)
+{
+  if (values.empty())
+    return 0.0;
+  std::sort(values.begin(), values.end());
+  size_t index = static_cast<size_t>(std::ceil(q * static_cast<double>(values.size())));
+  return values[std::min(values.size() - 1, index > 0 ? index - 1 : 0)];
+}
+
+Measurement run_candidate(const Options& opts, const Candidate& candidate, const cv::Mat& image)
+{
+  Measurement measurement;
+  std::vector<std::unique_ptr<yo::AutoBackendOnnx>> models;
+  try
+  {
+    for (int s = 0; s < candidate.sessions; ++s)
+    {
+      models.push_back(std::make_unique<yo::AutoBackendOnnx>(
+          opts.model.c_str(), "autotune", opts.provider, candidate.config));
+    }
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << "Warning: candidate skipped, session creation failed: " << e.what() << std::endl;
+    return measurement;
+  }
+
+  using clock = std::chrono::steady_clock;
+  std::vector<std::vector<double>> latencies(models.size());
+  std::vector<size_t> calls(models.size(), 0);
+  std::atomic<bool> failed{false};
+  const clock::duration window =
+      std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(opts.seconds));
+  auto drive = [&](size_t s)
+  {
+    std::vector<cv::Mat> images(static_cast<size_t>(candidate.batch), image);
+    float conf = 0.30f;
+    float iou = 0.45f;
+    float mask_threshold = 0.5f;
+    try
+    {
+      // warm up outside the measured window, the first runs allocate and compile
+      for (int i = 0; i < 2; ++i)
+        models[s]->predict_batch(images, conf, iou, mask_threshold);
+      const clock::time_point end = clock::now() + window;
+      while (clock::now() < end)
+      {
+        clock::time_point start = clock::now();
+        models[s]->predict_batch(images, conf, iou, mask_threshold);
+        latencies[s].push_back(
+            std::chrono::duration<double, std::milli>(clock::now() - start).count());
+        ++calls[s];
+      }
+    }
+    catch (const std::exception& e)
+    {
+      std::cerr << "Warning: candidate failed: " << e.what() << std::endl;
+      failed = true;
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (size_t s = 0; s < models.size(); ++s)
+    threads.emplace_back(drive, s);
+  for (std::thread& thread : threads)
+    thread.join();
+  if (failed)
+    return measurement;
+
+  // every session reports its own rate over its measured calls, warmups may end at different times
+  std::vector<double> all;
+  double images_per_s = 0.0;
+  for (size_t s = 0; s < models.size(); ++s)
+  {
+    double busy_ms = 0.0;
+    for (double ms : latencies[s])
+      busy_ms += ms;
+    if (busy_ms > 0.0)
+      images_per_s += static_cast<double>(calls[s] * candidate.batch) * 1000.0 / busy_ms;
+    all.insert(all.end(), latencies[s].begin(), latencies[s].end());
+  }
+  measurement.ok = !all.empty();
+  measurement.images_per_s = images_per_s;
+  measurement.median_ms = percentile(all, 0.5);
+  measurement.p99_ms = percentile(all, 0.99);
+  return measurement;
+}
+
+std::string describe(const Options& opts, const Candidate& candidate)
+{
+  std::ostringstream text;
+  text << "sessions=" << candidate.sessions << " batch=" << candidate.batch;
+  if (opts.provider == yo::OnnxProviders_t::CPU)
+    text << " threads=" << candidate.config.intra_op_threads;
+  else if (opts.provider == yo::OnnxProviders_t::OPENVINO)
+  {
+    const yo::OpenVinoOptions& openvino = candidate.config.openvino;
+    text << " hint=" << yo::OpenVinoPerformanceHintToString(openvino.performance_hint)
+         << " streams=" << openvino.num_streams;
+  }
+  return text.str();
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  Options opts;
+  try
+  {
+    if (!parse_args(argc, argv, opts))
+    {
+      print_usage(argv[0]);
+      return 2;
+    }
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << "Error: " << e.what() << std::endl;
+    print_usage(argv[0]);
+    return 2;
+  }
+
+  // a probe session for the input size and batch dimension
+  std::vector<int> batches;
+  cv::Mat image;
+  {
+    yo::AutoBackendOnnx probe(opts.model.c_str(), "autotune", opts.provider);
+    const int model_batch = probe.getMaxBatch();
+    batches = model_batch > 0 ? std::vector<int>{model_batch} : opts.batches;
+    if (!opts.image.empty())
+    {
+      image = cv::imread(opts.image);
+      if (image.empty())
+      {
+        std::cerr << "Error: cannot read " << opts.image << std::endl;
+        return 1;
+      }
+    }
+    else
+    {
+      image = cv::Mat(probe.getCvSize(), CV_8UC(probe.getCh()), cv::Scalar::all(114));
+    }
+  }
+
+  std::vector<Candidate> candidates = make_candidates(opts, batches);
+  std::cout << "Trying " << candidates.size() << " candidates for " << opts.seconds << "s each"
+            << std::endl;
+  int best = -1;
+  Measurement best_measurement;
+  for (size_t c = 0; c < candidates.size(); ++c)
+  {
+    Measurement m = run_candidate(opts, candidates[c], image);
+    std::cout << std::fixed << std::setprecision(2) << describe(opts, candidates[c]) << ": ";
+    if (!m.ok)
+    {
+      std::cout << "failed" << std::endl;
+      continue;
+    }
+    const bool capped = opts.latency_cap_ms > 0.0 && m.p99_ms > opts.latency_cap_ms;
+    std::cout << m.images_per_s << " images/s, predict_batch median " << m.median_ms
+              << "ms, p99 " << m.p99_ms << "ms" << (capped ? " (over the latency cap)" : "")
+              << std::endl;
+    if (capped)
+      continue;
+    const bool better = best < 0 || (opts.latency_objective
+                                         ? m.p99_ms < best_measurement.p99_ms
+                                         : m.images_per_s > best_measurement.images_per_s);
+    if (better)
+    {
+      best = static_cast<int>(c);
+      best_measurement = m;
+    }
+  }
+  if (best < 0)
+  {
+    std::cerr << "Error: no candidate ran" << (opts.latency_cap_ms > 0.0 ? " within the cap" : "")
+              << std::endl;
+    return 1;
+  }
+
+  yo::SessionConfig tuned = candidates[best].config;
+  tuned.serving.batch_size = candidates[best].batch;
+  yo::save_session_config(opts.output,
+                          tuned,
+                          {{"sessions", static_cast<double>(candidates[best].sessions)},
+                           {"images_per_s", best_measurement.images_per_s},
+                           {"predict_median_ms", best_measurement.median_ms},
+                           {"predict_p99_ms", best_measurement.p99_ms}});
+  std::cout << "Best: " << describe(opts, candidates[best]) << ", written to " << opts.output
+            << std::endl;
+  return 0;
+}
@@ -0,0 +1,502 @@
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <yolov8_onnxruntime/nn/autobackend.h>
+#include <yolov8_onnxruntime/utils/image_io.h>
+#include <yolov8_onnxruntime/utils/serialization.h>
+
+namespace fs = std::filesystem;
+namespace yo = yolov8_onnxruntime;
+
+namespace
+{
+
+const std::vector<std::string> IMAGE_EXTENSIONS = {
+    ".jpg", ".jpeg", ".png", ".bmp", ".tif", ".tiff", ".webp"};
+
+struct Options
+{
+  std::string model;
+  std::string input_dir;
+  std::string input_list;
+  std::string output;
+  yo::OnnxProviders_t provider = yo::OnnxProviders_t::CPU;
+  yo::SessionConfig session;
+  int batch = 0; // 0: use the model's static batch, or 8 for dynamic batch models
+  int threads = std::max(1u, std::thread::hardware_concurrency() / 2);
+  int prefetch = 0; // 0: 4 batches
+  float conf = 0.30f;
+  float iou = 0.45f;
+  float mask_threshold = 0.5f;
+  bool with_masks = true;
+  bool resume = true;
+};
+
+void print_usage(const char* argv0)
+{
+  std::cerr
+      << "Usage: " << argv0 << " --model MODEL.onnx (--dir DIR | --list FILE) --output OUT.jsonl\n"
+      << "  --provider cpu|cuda|openvino   execution provider (default cpu)\n"
+      << "  --ov-device DEVICE             OpenVINO device, e.g. CPU, GPU, AUTO (default CPU)\n"
+      << "  --ov-hint latency|throughput   OpenVINO performance hint (default latency)\n"
+      << "  --ov-streams N                 OpenVINO inference streams (default from the hint)\n"
+      << "  --ov-cache DIR                 OpenVINO compiled model cache, needed by the\n"
+      << "                                 throughput hint\n"
+      << "  --batch N                      images per session call\n"
+      << "  --threads N                    decode threads\n"
+      << "  --prefetch N                   decoded images buffered ahead of inference\n"
+      << "  --conf F --iou F --mask-threshold F\n"
+      << "  --no-masks                     do not write segmentation masks\n"
+      << "  --no-resume                    overwrite OUT.jsonl instead of skipping done images\n"
+      << "Images that failed are listed in OUT.jsonl.failed and retried by the next run.\n";
+}
+
+bool parse_args(int argc, char** argv, Options& opts)
+{
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    auto next = [&]() -> std::string
+    {
+      if (i + 1 >= argc)
+        throw std::invalid_argument("missing value for " + arg);
+      return argv[++i];
+    };
+
+    if (arg == "--model")
+      opts.model = next();
+    else if (arg == "--dir")
+      opts.input_dir = next();
+    else if (arg == "--list")
+      opts.input_list = next();
+    else if (arg == "--output")
+      opts.output = next();
+    else if (arg == "--provider")
+    {
+      std::string provider = next();
+      if (provider == yo::OnnxProviders::CPU)
+        opts.provider = yo::OnnxProviders_t::CPU;
+      else if (provider == yo::OnnxProviders::CUDA)
+        opts.provider = yo::OnnxProviders_t::CUDA;
+      else if (provider == yo::OnnxProviders::OPENVINO)
+        opts.provider = yo::OnnxProviders_t::OPENVINO;
+      else
+        throw std::invalid_argument("unknown provider: " + provider);
+    }
+    else if (arg == "--ov-device")
+      opts.session.openvino.device_type = next();
+    else if (arg == "--ov-hint")
+    {
+      std::string hint = next();
+      std::transform(hint.begin(), hint.end(), hint.begin(), ::toupper);
+      if (hint == yo::OpenVinoPerformanceHints::LATENCY)
+        opts.session.openvino.performance_hint = yo::OpenVinoPerformanceHint_t::LATENCY;
+      else if (hint == yo::OpenVinoPerformanceHints::THROUGHPUT)
+        opts.session.openvino.performance_hint = yo::OpenVinoPerformanceHint_t::THROUGHPUT;
+      else
+        throw std::invalid_argument("unknown OpenVINO hint: " + hint);
+    }
+    else if (arg == "--ov-streams")
+      opts.session.openvino.num_streams = std::stoi(next());
+    else if (arg == "--ov-cache")
+      opts.session.openvino.cache_dir = next();
+    else if (arg == "--batch")
+      opts.batch = std::stoi(next());
+    else if (arg == "--threads")
+      opts.threads = std::max(1, std::stoi(next()));
+    else if (arg == "--prefetch")
+      opts.prefetch = std::stoi(next());
+    else if (arg == "--conf")
+      opts.conf = std::stof(next());
+    else if (arg == "--iou")
+      opts.iou = std::stof(next());
+    else if (arg == "--mask-threshold")
+      opts.mask_threshold = std::stof(next());
+    else if (arg == "--no-masks")
+      opts.with_masks = false;
+    else if (arg == "--no-resume")
+      opts.resume = false;
+    else if (arg == "-h" || arg == "--help")
+      return false;
+    else
+      throw std::invalid_argument("unknown argument: " + arg);
+  }
+  return !opts.model.empty() && !opts.output.empty() &&
+         (opts.input_dir.empty() != opts.input_list.empty());
+}
+
+std::vector<std::string> collect_inputs(const Options& opts)
+{
+  std::vector<std::string> paths;
+  if (!opts.input_dir.empty())
+  {
+    for (const auto& entry : fs::recursive_directory_iterator(
+             opts.input_dir, fs::directory_options::skip_permission_denied))
+    {
+      if (!entry.is_regular_file())
+        continue;
+      std::string ext = entry.path().extension().string();
+      std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+      if (std::find(IMAGE_EXTENSIONS.begin(), IMAGE_EXTENSIONS.end(), ext) !=
+          IMAGE_EXTENSIONS.end())
+        paths.push_back(entry.path().string());
+    }
+    // deterministic order so that interrupted runs resume the same way
+    std::sort(paths.begin(), paths.end());
+  }
+  else
+  {
+    std::ifstream list(opts.input_list);
+    if (!list)
+      throw std::runtime_error("Error: cannot open file list: " + opts.input_list);
+    std::string line;
+    while (std::getline(list, line))
+    {
+      if (!line.empty() && line.back() == '\r')
+        line.pop_back();
+      if (!line.empty())
+        paths.push_back(line);
+    }
+  }
+  return paths;
+}
+
+// every line starts with {"path":"...", see write_line. end receives the index past the path.
+bool extract_path(const std::string& line, std::string& path, size_t& end)
+{
+  const std::string prefix = "{\"path\":\"";
+  if (line.compare(0, prefix.size(), prefix) != 0)
+    return false;
+  path.clear();
+  for (size_t i = prefix.size(); i < line.size(); ++i)
+  {
+    char ch = line[i];
+    if (ch == '"')
+    {
+      end = i + 1;
+      return true;
+    }
+    if (ch == '\\' && i + 1 < line.size())
+    {
+      char escaped = line[++i];
+      switch (escaped)
+      {
+      case 'n':
+        path += '\n';
+        break;
+      case 'r':
+        path += '\r';
+        break;
+      case 't':
+        path += '\t';
+        break;
+      default:
+        path += escaped;
+      }
+      continue;
+    }
+    path += ch;
+  }
+  return false;
+}
+
+/**
+ * Collects the paths already written to output and drops a trailing partial line left behind by
+ * an interrupted run. Error lines (written by older versions) do not count as done, so those
+ * images are retried.
+ */
+std::unordered_set<std::string> load_done(const std::string& output)
+{
+  std::unordered_set<std::string> done;
+  std::ifstream in(output, std::ios::binary);
+  if (!in)
+    return done;
+
+  std::string line;
+  std::streamoff complete_bytes = 0;
+  std::streamoff offset = 0;
+  while (std::getline(in, line))
+  {
+    offset += static_cast<std::streamoff>(line.size());
+    if (in.eof())
+      break; // no newline: partial line
+    offset += 1;
+    std::string path;
+    size_t end = 0;
+    if (extract_path(line, path, end) && line.compare(end, 9, ",\"error\":") != 0)
+      done.insert(path);
+    complete_bytes = offset;
+  }
+  in.close();
+
+  if (static_cast<uintmax_t>(complete_bytes) != fs::file_size(output))
+    fs::resize_file(output, complete_bytes);
+  return done;
+}
+
+struct DecodedImage
+{
+  std::string path;
+  cv::Mat image;
+  yo::ImageInfo info;
+};
+
+/// Bounded FIFO between the decode threads and the inference loop.
+class DecodeQueue
+{
+public:
+  explicit DecodeQueue(size_t capacity) : capacity_(capacity) {}
+
+  void push(DecodedImage&& item)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_full_.wait(lock, [this] { return queue_.size() < capacity_; });
+    queue_.push(std::move(item));
+    not_empty_.notify_one();
+  }
+
+  /// Pops up to max_items, blocks until at least one is available or the producers finished.
+  size_t pop_batch(std::vector<DecodedImage>& batch, size_t max_items)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_empty_.wait(lock, [this] { return !queue_.empty() || closed_; });
+    while (!queue_.empty() && batch.size() < max_items)
+    {
+      batch.push_back(std::move(queue_.front()));
+      queue_.pop();
+    }
+    not_full_.notify_all();
+    return batch.size();
+  }
+
+  void close()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    not_empty_.notify_all();
+  }
+
+private:
+  size_t capacity_;
+  bool closed_ = false;
+  std::queue<DecodedImage> queue_;
+  std::mutex mutex_;
+  std::condition_variable not_full_;
+  std::condition_variable not_empty_;
+};
+
+void write_line(std::ostream& out,
+                const DecodedImage& item,
+                const std::vector<yo::YoloResults>* results,
+                const std::string& error,
+                const std::unordered_map<int, std::string>& names,
+                bool with_masks)
+{
+  out << "{\"path\":\"" << yo::json_escape(item.path) << '"';
+  if (results != nullptr)
+  {
+    out << ",\"width\":" << item.info.raw_size.width << ",\"height\":" << item.info.raw_size.height
+        << ",\"results\":";
+    yo::write_json(out, *results, &names, with_masks);
+  }
+  else
+  {
+    out << ",\"error\":\"" << yo::json_escape(error) << '"';
+  }
+  out << "}\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  Options opts;
+  try
+  {
+    if (!parse_args(argc, argv, opts))
+    {
+      print_usage(argv[0]);
+      return 1;
+    }
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << "Error: " << e.what() << std::endl;
+    print_usage(argv[0]);
+    return 1;
+  }
+
+  std::vector<std::string> inputs = collect_inputs(opts);
+  std::unordered_set<std::string> done;
+  if (opts.resume)
+    done = load_done(opts.output);
+
+  std::vector<std::string> pending;
+  pending.reserve(inputs.size());
+  for (const std::string& path : inputs)
+  {
+    if (done.count(path) == 0)
+      pending.push_back(path);
+  }
+  std::cerr << inputs.size() << " images, " << (inputs.size() - pending.size())
+            << " already done, " << pending.size() << " to process" << std::endl;
+  if (pending.empty())
+  {
+    std::error_code ignored;
+    fs::remove(opts.output + ".failed", ignored); // nothing failed, a stale list would mislead
+    return 0;
+  }
+
+  yo::AutoBackendOnnx model(opts.model.c_str(), "yolov8_batch", opts.provider, opts.session);
+  if (model.getRequestedProvider() != opts.provider)
+  {
+    std::cerr << "Warning: running on " << yo::OnnxProviderToString(model.getRequestedProvider())
+              << " instead of " << yo::OnnxProviderToString(opts.provider) << std::endl;
+  }
+  const std::unordered_map<int, std::string>& names = model.getNames();
+  const cv::Size target_size = model.getCvSize();
+  const int required_channels = model.getCh();
+  size_t batch_size = opts.batch > 0 ? opts.batch : model.getMaxBatch();
+  if (batch_size == 0)
+    batch_size = 8; // dynamic batch
+  size_t prefetch = opts.prefetch > 0 ? opts.prefetch : 4 * batch_size;
+
+  std::ofstream out(opts.output, opts.resume ? std::ios::app : std::ios::trunc);
+  if (!out)
+  {
+    std::cerr << "Error: cannot open output: " << opts.output << std::endl;
+    return 1;
+  }
+  // failures go to a file of their own, so OUT.jsonl only marks finished images and a resumed run
+  // retries the failed ones; it lists the failures of the latest run only
+  const std::string failed_path = opts.output + ".failed";
+  std::ofstream failures(failed_path, std::ios::trunc);
+  if (!failures)
+  {
+    std::cerr << "Error: cannot open output: " << failed_path << std::endl;
+    return 1;
+  }
+
+  // decode pool: reduced JPEG decode + color conversion run off the inference thread
+  DecodeQueue queue(prefetch);
+  std::atomic<size_t> next_input{0};
+  std::atomic<int> running_decoders{opts.threads};
+  std::vector<std::thread> decoders;
+  for (int t = 0; t < opts.threads; ++t)
+  {
+    decoders.emplace_back(
+        [&]()
+        {
+          for (size_t i = next_input++; i < pending.size(); i = next_input++)
+          {
+            DecodedImage item;
+            item.path = pending[i];
+            item.image = yo::imread_reduced(item.path, target_size, item.info.raw_size);
+            if (!item.image.empty() && required_channels == 3)
+            {
+              if (item.image.channels() == 1)
+                cv::cvtColor(item.image, item.image, cv::COLOR_GRAY2RGB);
+              else if (item.image.channels() == 4)
+                cv::cvtColor(item.image, item.image, cv::COLOR_BGRA2RGB);
+              else
+                cv::cvtColor(item.image, item.image, cv::COLOR_BGR2RGB);
+            }
+            queue.push(std::move(item));
+          }
+          if (--running_decoders == 0)
+            queue.close();
+        });
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  auto last_report = start;
+  size_t processed = 0;
+  size_t failed = 0;
+  std::vector<DecodedImage> batch;
+  while (queue.pop_batch(batch, batch_size) > 0)
+  {
+    std::vector<cv::Mat> images;
+    std::vector<yo::ImageInfo> image_infos;
+    std::vector<size_t> batch_idx;
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+      if (batch[i].image.empty())
+        continue;
+      images.push_back(batch[i].image);
+      image_infos.push_back(batch[i].info);
+      batch_idx.push_back(i);
+    }
+
+    std::vector<std::vector<yo::YoloResults>> results;
+    std::string batch_error;
+    try
+    {
+      results = model.predict_batch(
+          images, image_infos, opts.conf, opts.iou, opts.mask_threshold, -1, false);
+    }
+    catch (const std::exception& e)
+    {
+      batch_error = e.what();
+    }
+
+    size_t result_pos = 0;
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+      bool decoded = result_pos < batch_idx.size() && batch_idx[result_pos] == i;
+      if (decoded && batch_error.empty())
+      {
+        write_line(out, batch[i], &results[result_pos], "", names, opts.with_masks);
+      }
+      else
+      {
+        write_line(
+            failures, batch[i], nullptr, decoded ? batch_error : "decode failed", names, false);
+        ++failed;
+      }
+      if (decoded)
+        ++result_pos;
+    }
+    // one flush per batch keeps the file resumable at batch granularity
+    out.flush();
+    failures.flush();
+    processed += batch.size();
+    batch.clear();
+
+    auto now = std::chrono::steady_clock::now();
+    if (std::chrono::duration<double>(now - last_report).count() >= 1.0)
+    {
+      double elapsed = std::chrono::duration<double>(now - start).count();
+      std::cerr << std::fixed << std::setprecision(1) << "\r[" << processed << "/"
+                << pending.size() << "] " << (processed / elapsed) << " img/s, " << failed
+                << " failed" << std::flush;
+      last_report = now;
+    }
+  }
+
+  for (std::thread& decoder : decoders)
+    decoder.join();
+
+  double elapsed =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::cerr << std::fixed << std::setprecision(1) << "\r[" << processed << "/" << pending.size()
+            << "] " << (processed / elapsed) << " img/s, " << failed << " failed, " << elapsed
+            << "s total" << std::endl;
+  return failed == 0 ? 0 : 2;
+}
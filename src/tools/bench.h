@@ -0,0 +1,107 @@
+#ifndef YOLOV8_ONNXRUNTIME_TOOLS_BENCH_H
+#define YOLOV8_ONNXRUNTIME_TOOLS_BENCH_H
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace yolov8_onnxruntime
+{
+namespace bench
+{
+
+/// Per-call timings of one benchmark case, in microseconds.
+struct Stats
+{
+  std::string name;
+  size_t samples = 0;
+  double median_us = 0.0;
+  double mad_us = 0.0; ///< median absolute deviation, robust against scheduler outliers
+  double min_us = 0.0;
+  double mean_us = 0.0;
+};
+
+inline double median(std::vector<double> values)
+{
+  if (values.empty())
+    return 0.0;
+  std::sort(values.begin(), values.end());
+  size_t mid = values.size() / 2;
+  return values.size() % 2 ? values[mid] : 0.5 * (values[mid - 1] + values[mid]);
+}
+
+/**
+ * @brief Times fn after warmup calls.
+ *
+ * Each sample averages enough back-to-back calls to last at least min_sample_us so that fast
+ * functions are not dominated by clock resolution.
+ */
+template <typename Fn>
+Stats measure(const std::string& name,
+              Fn&& fn,
+              size_t samples = 30,
+              size_t warmup = 3,
+              double min_sample_us = 2000.0)
+{
+  using clock = std::chrono::steady_clock;
+  for (size_t i = 0; i < warmup; ++i)
+    fn();
+
+  // calibrate the number of calls per sample
+  size_t calls = 1;
+  while (true)
+  {
+    auto start = clock::now();
+    for (size_t i = 0; i < calls; ++i)
+      fn();
+    double us = std::chrono::duration<double, std::micro>(clock::now() - start).count();
+    if (us >= min_sample_us || calls >= (1u << 20))
+      break;
+    calls *= 2;
+  }
+
+  std::vector<double> per_call;
+  per_call.reserve(samples);
+  for (size_t s = 0; s < samples; ++s)
+  {
+    auto start = clock::now();
+    for (size_t i = 0; i < calls; ++i)
+      fn();
+    double us = std::chrono::duration<double, std::micro>(clock::now() - start).count();
+    per_call.push_back(us / static_cast<double>(calls));
+  }
+
+  Stats stats;
+  stats.name = name;
+  stats.samples = samples;
+  stats.median_us = median(per_call);
+  std::vector<double> deviations;
+  deviations.reserve(per_call.size());
+  double sum = 0.0;
+  for (double value : per_call)
+  {
+    deviations.push_back(std::abs(value - stats.median_us));
+    sum += value;
+  }
+  stats.mad_us = median(deviations);
+  stats.min_us = *std::min_element(per_call.begin(), per_call.end());
+  stats.mean_us = sum / static_cast<double>(per_call.size());
+  return stats;
+}
+
+/// Writes one JSON object per line, easy to diff and to load with any tooling.
+inline void write_jsonl(std::ostream& os, const Stats& stats)
+{
+  os << std::fixed << std::setprecision(3) << "{\"name\":\"" << stats.name
+     << "\",\"samples\":" << stats.samples << ",\"median_us\":" << stats.median_us
+     << ",\"mad_us\":" << stats.mad_us << ",\"min_us\":" << stats.min_us
+     << ",\"mean_us\":" << stats.mean_us << "}\n";
+}
+
+} // namespace bench
+} // namespace yolov8_onnxruntime
+
+#endif // YOLOV8_ONNXRUNTIME_TOOLS_BENCH_H
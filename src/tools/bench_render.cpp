@@ -0,0 +1,107 @@
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <yolov8_onnxruntime/types.h>
+#include <yolov8_onnxruntime/utils/render.h>
+#include <yolov8_onnxruntime/utils/viz.h>
+
+#include "bench.h"
+
+namespace yo = yolov8_onnxruntime;
+
+namespace
+{
+
+std::vector<yo::YoloResults> make_results(size_t count, const cv::Size& frame, std::mt19937& gen)
+{
+  std::uniform_real_distribution<float> extent(40.0f, 360.0f);
+  std::uniform_real_distribution<float> score(0.25f, 1.0f);
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+  std::uniform_int_distribution<int> cls(0, 79);
+
+  std::vector<yo::YoloResults> results(count);
+  for (yo::YoloResults& result : results)
+  {
+    float w = extent(gen);
+    float h = extent(gen);
+    std::uniform_real_distribution<float> x(0.0f, frame.width - w);
+    std::uniform_real_distribution<float> y(0.0f, frame.height - h);
+    result.class_idx = cls(gen);
+    result.conf = score(gen);
+    result.bbox = cv::Rect_<float>(x(gen), y(gen), w, h);
+
+    cv::Rect box = cv::Rect(result.bbox) & cv::Rect(cv::Point(), frame);
+    result.mask = cv::Mat::zeros(box.size(), CV_8UC1);
+    cv::ellipse(result.mask,
+                cv::Point(box.width / 2, box.height / 2),
+                cv::Size(box.width / 2, box.height / 2),
+                0.0,
+                0.0,
+                360.0,
+                cv::Scalar(1),
+                -1);
+
+    result.keypoints.resize(51);
+    for (size_t k = 0; k < result.keypoints.size(); k += 3)
+    {
+      result.keypoints[k] = result.bbox.x + w * unit(gen);
+      result.keypoints[k + 1] = result.bbox.y + h * unit(gen);
+      result.keypoints[k + 2] = score(gen);
+    }
+  }
+  return results;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  std::mt19937 gen(42);
+  const cv::Size frame_size(1920, 1080);
+  std::vector<size_t> counts = {10, 50, 100};
+  if (argc > 1)
+    counts = {static_cast<size_t>(std::stoul(argv[1]))};
+
+  std::unordered_map<int, std::string> names;
+  for (int i = 0; i < 80; ++i)
+    names[i] = "class" + std::to_string(i);
+  std::vector<cv::Scalar> colors = yo::generateRandomColors(static_cast<int>(names.size()), 3);
+
+  cv::Mat frame(frame_size, CV_8UC3);
+  cv::randu(frame, cv::Scalar::all(0), cv::Scalar::all(255));
+  cv::Mat canvas;
+
+  for (size_t count : counts)
+  {
+    std::vector<yo::YoloResults> results = make_results(count, frame_size, gen);
+    std::string n = std::to_string(count);
+
+    // both cases include the frame copy an annotated stream has to make anyway
+    yo::bench::write_jsonl(std::cout,
+                           yo::bench::measure("1080p_" + n + "/plot_results",
+                                              [&]()
+                                              {
+                                                frame.copyTo(canvas);
+                                                yo::plot_results(
+                                                    canvas, results, colors, names, frame_size);
+                                              }));
+    yo::Renderer renderer(colors, names);
+    yo::bench::write_jsonl(std::cout,
+                           yo::bench::measure("1080p_" + n + "/renderer",
+                                              [&]()
+                                              {
+                                                frame.copyTo(canvas);
+                                                renderer.render(canvas, results);
+                                              }));
+    yo::bench::write_jsonl(std::cout,
+                           yo::bench::measure("1080p_" + n + "/copy_only",
+                                              [&]() { frame.copyTo(canvas); }));
+  }
+  return 0;
+}
@@ -0,0 +1,220 @@
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <yolov8_onnxruntime/types.h>
+#include <yolov8_onnxruntime/utils/json.h>
+#include <yolov8_onnxruntime/utils/serialization.h>
+
+#include "bench.h"
+
+namespace yo = yolov8_onnxruntime;
+
+namespace
+{
+
+std::vector<yo::YoloResults>
+make_results(size_t count, bool with_keypoints, bool with_masks, std::mt19937& gen)
+{
+  std::uniform_real_distribution<float> coord(0.0f, 1800.0f);
+  std::uniform_real_distribution<float> extent(16.0f, 240.0f);
+  std::uniform_real_distribution<float> score(0.25f, 1.0f);
+  std::uniform_int_distribution<int> cls(0, 79);
+
+  std::vector<yo::YoloResults> results(count);
+  for (yo::YoloResults& result : results)
+  {
+    result.class_idx = cls(gen);
+    result.conf = score(gen);
+    result.bbox = cv::Rect_<float>(coord(gen), coord(gen), extent(gen), extent(gen));
+    if (with_keypoints)
+    {
+      result.keypoints.resize(51);
+      for (size_t k = 0; k < result.keypoints.size(); k += 3)
+      {
+        result.keypoints[k] = result.bbox.x + extent(gen);
+        result.keypoints[k + 1] = result.bbox.y + extent(gen);
+        result.keypoints[k + 2] = score(gen);
+      }
+    }
+    if (with_masks)
+    {
+      cv::Size size(static_cast<int>(result.bbox.width), static_cast<int>(result.bbox.height));
+      result.mask = cv::Mat::zeros(size, CV_8UC1);
+      cv::ellipse(result.mask,
+                  cv::Point(size.width / 2, size.height / 2),
+                  cv::Size(size.width / 3, size.height / 3),
+                  0.0,
+                  0.0,
+                  360.0,
+                  cv::Scalar(255),
+                  -1);
+    }
+  }
+  return results;
+}
+
+// inverse of yo::write_json, what a JSON consumer has to do to get results back
+std::vector<yo::YoloResults> parse_json(const std::string& text)
+{
+  yo::JsonValue doc = yo::JsonValue::parse(text);
+  std::vector<yo::YoloResults> results;
+  results.reserve(doc.asArray().size());
+  for (const yo::JsonValue& item : doc.asArray())
+  {
+    yo::YoloResults result;
+    result.class_idx = static_cast<int>(item.numberOr("class", -1));
+    result.conf = static_cast<float>(item.numberOr("conf", 0.0));
+    const std::vector<yo::JsonValue>& box = item.find("bbox")->asArray();
+    result.bbox = cv::Rect_<float>(static_cast<float>(box[0].asNumber()),
+                                   static_cast<float>(box[1].asNumber()),
+                                   static_cast<float>(box[2].asNumber()),
+                                   static_cast<float>(box[3].asNumber()));
+    if (const yo::JsonValue* kpts = item.find("keypoints"))
+    {
+      for (const yo::JsonValue& value : kpts->asArray())
+        result.keypoints.push_back(static_cast<float>(value.asNumber()));
+    }
+    if (const yo::JsonValue* mask = item.find("mask"))
+    {
+      const yo::JsonValue* size = mask->find("size");
+      const yo::JsonValue* runs = mask->find("counts");
+      if (size == nullptr || runs == nullptr || size->asArray().size() != 2)
+        throw std::runtime_error("Error: mask without size or counts");
+      std::vector<uint32_t> counts;
+      for (const yo::JsonValue& value : runs->asArray())
+        counts.push_back(static_cast<uint32_t>(value.asNumber()));
+      result.mask = yo::rle_to_mask(counts.data(),
+                                    counts.size(),
+                                    cv::Size(static_cast<int>(size->asArray()[1].asNumber()),
+                                             static_cast<int>(size->asArray()[0].asNumber())));
+    }
+    results.push_back(std::move(result));
+  }
+  return results;
+}
+
+// decoded masks are 0/255, the generated ones are too, so equal means bit-identical
+bool same_mask(const cv::Mat& a, const cv::Mat& b)
+{
+  if (a.size() != b.size() || a.type() != b.type())
+    return false;
+  return a.empty() || cv::norm(a, b, cv::NORM_INF) == 0;
+}
+
+// every mask has to come back from the RLE codec and from both decoders exactly as encoded
+void check_round_trip(const std::string& label,
+                      const std::vector<yo::YoloResults>& results,
+                      const std::vector<yo::YoloResults>& from_json,
+                      const std::vector<yo::YoloResults>& from_binary)
+{
+  if (from_json.size() != results.size() || from_binary.size() != results.size())
+    throw std::runtime_error("Error: " + label + " decoded a different number of results");
+  std::vector<uint32_t> counts;
+  for (size_t i = 0; i < results.size(); ++i)
+  {
+    const cv::Mat& mask = results[i].mask;
+    counts.clear();
+    yo::mask_to_rle(mask, counts);
+    const cv::Mat decoded =
+        mask.empty() ? cv::Mat() : yo::rle_to_mask(counts.data(), counts.size(), mask.size());
+    if (!same_mask(decoded, mask) || !same_mask(from_json[i].mask, mask) ||
+        !same_mask(from_binary[i].mask, mask))
+    {
+      throw std::runtime_error("Error: " + label + " mask " + std::to_string(i) +
+                               " does not survive the round trip");
+    }
+  }
+}
+
+void run_case(const std::string& label, const std::vector<yo::YoloResults>& results)
+{
+  std::ostringstream json_stream;
+  yo::write_json(json_stream, results);
+  const std::string json = json_stream.str();
+
+  yo::BinaryResultWriter writer;
+  std::vector<char> binary;
+  writer.encode(results, binary);
+
+  check_round_trip(label,
+                   results,
+                   parse_json(json),
+                   yo::BinaryResultView(binary.data(), binary.size()).toResults());
+
+  std::cout << "{\"case\":\"" << label << "\",\"json_bytes\":" << json.size()
+            << ",\"binary_bytes\":" << binary.size() << "}\n";
+
+  volatile size_t sink = 0;
+  yo::bench::write_jsonl(std::cout,
+                         yo::bench::measure(label + "/json_encode",
+                                            [&]()
+                                            {
+                                              std::ostringstream os;
+                                              yo::write_json(os, results);
+                                              sink = sink + static_cast<size_t>(os.tellp());
+                                            }));
+  yo::bench::write_jsonl(std::cout,
+                         yo::bench::measure(label + "/json_decode",
+                                            [&]() { sink = sink + parse_json(json).size(); }));
+  yo::bench::write_jsonl(std::cout,
+                         yo::bench::measure(label + "/binary_encode",
+                                            [&]()
+                                            {
+                                              writer.encode(results, binary);
+                                              sink = sink + binary.size();
+                                            }));
+  // zero-copy read: validate the frame and touch every score in place
+  yo::bench::write_jsonl(std::cout,
+                         yo::bench::measure(label + "/binary_view",
+                                            [&]()
+                                            {
+                                              yo::BinaryResultView view(binary.data(),
+                                                                        binary.size());
+                                              float total = 0.0f;
+                                              for (uint32_t i = 0; i < view.count(); ++i)
+                                                total += view.scores()[i];
+                                              sink = sink + static_cast<size_t>(total);
+                                            }));
+  yo::bench::write_jsonl(std::cout,
+                         yo::bench::measure(label + "/binary_decode",
+                                            [&]()
+                                            {
+                                              yo::BinaryResultView view(binary.data(),
+                                                                        binary.size());
+                                              sink = sink + view.toResults().size();
+                                            }));
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  std::mt19937 gen(42);
+  std::vector<size_t> counts = {10, 100, 300};
+  if (argc > 1)
+    counts = {static_cast<size_t>(std::stoul(argv[1]))};
+
+  try
+  {
+    for (size_t count : counts)
+    {
+      std::string n = std::to_string(count);
+      run_case("detect_" + n, make_results(count, false, false, gen));
+      run_case("pose_" + n, make_results(count, true, false, gen));
+      run_case("segment_" + n, make_results(count, false, true, gen));
+    }
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,223 @@
+// Microbenchmarks of the pre- and postprocessing building blocks predict_once() actually runs, on
+// their own, over the source sizes, candidate counts and instance counts deployments see. Prints
+// one JSON line per case, an optional argument only runs the cases whose name contains it.
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <yolov8_onnxruntime/nn/autobackend.h>
+#include <yolov8_onnxruntime/utils/augment.h>
+#include <yolov8_onnxruntime/utils/letterbox.h>
+#include <yolov8_onnxruntime/utils/ops.h>
+#include <yolov8_onnxruntime/utils/yuv.h>
+
+#include "bench.h"
+
+namespace yo = yolov8_onnxruntime;
+
+namespace
+{
+
+const cv::Size MODEL_SIZE(640, 640);
+const cv::Size CLASSIFY_SIZE(224, 224);
+const int NUM_PREDS = 8400;
+const int MASK_FEATURES = 32;
+const int NUM_KPT_VALUES = 17 * 3;
+const cv::Size MASK_SIZE(160, 160);
+
+struct Source
+{
+  std::string name;
+  cv::Size size;
+};
+const std::vector<Source> SOURCES = {
+    {"720p", {1280, 720}}, {"1080p", {1920, 1080}}, {"4k", {3840, 2160}}};
+const std::vector<int> CANDIDATES = {10, 100, 5000};
+const std::vector<int> INSTANCES = {1, 30, 100};
+
+/// A head as the model returns it: channel-major [4 + nc + num_extra, preds], where exactly count
+/// predictions score above 0.5, boxes spread over the model input.
+cv::Mat make_head(int nc, int num_extra, int count, std::mt19937& gen)
+{
+  std::uniform_real_distribution<float> center(40.0f, 600.0f);
+  std::uniform_real_distribution<float> extent(8.0f, 200.0f);
+  std::uniform_real_distribution<float> low(0.0f, 0.2f);
+  std::uniform_real_distribution<float> high(0.55f, 1.0f);
+  std::normal_distribution<float> extra(0.0f, 1.0f);
+  std::uniform_int_distribution<int> cls(0, nc - 1);
+
+  cv::Mat head(4 + nc + num_extra, NUM_PREDS, CV_32F);
+  for (int p = 0; p < NUM_PREDS; ++p)
+  {
+    head.at<float>(0, p) = center(gen);
+    head.at<float>(1, p) = center(gen);
+    head.at<float>(2, p) = extent(gen);
+    head.at<float>(3, p) = extent(gen);
+    for (int c = 0; c < nc; ++c)
+      head.at<float>(4 + c, p) = low(gen);
+    if (p < count)
+      head.at<float>(4 + cls(gen), p) = high(gen);
+    for (int e = 0; e < num_extra; ++e)
+      head.at<float>(4 + nc + e, p) = extra(gen);
+  }
+  return head;
+}
+
+std::vector<cv::Rect_<float>> make_boxes(int count, std::mt19937& gen)
+{
+  std::uniform_real_distribution<float> corner(0.0f, 560.0f);
+  std::uniform_real_distribution<float> extent(8.0f, 80.0f);
+  std::vector<cv::Rect_<float>> boxes;
+  for (int i = 0; i < count; ++i)
+    boxes.emplace_back(corner(gen), corner(gen), extent(gen), extent(gen));
+  return boxes;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  const std::string filter = argc > 1 ? argv[1] : "";
+  auto run = [&filter](const std::string& name, auto&& fn)
+  {
+    if (filter.empty() || name.find(filter) != std::string::npos)
+      yo::bench::write_jsonl(std::cout, yo::bench::measure(name, fn));
+  };
+  std::mt19937 gen(42);
+
+  // preprocess of an 8-bit frame: the fused letterbox + CHW fill straight into the input tensor,
+  // the transform a workspace builds when the frame size changes, and the classify path
+  for (const Source& source : SOURCES)
+  {
+    cv::Mat image(source.size, CV_8UC3);
+    cv::randu(image, cv::Scalar::all(0), cv::Scalar::all(255));
+    yo::LetterboxTransform transform(source.size, MODEL_SIZE);
+    std::vector<float> blob(static_cast<size_t>(MODEL_SIZE.area()) * image.channels());
+    run("letterbox_chw/" + source.name, [&]() { transform.applyChw(image, blob.data()); });
+    run("letterbox_chw_rgb/" + source.name,
+        [&]() { transform.applyChw(image, blob.data(), true); });
+    run("letterbox_transform_setup/" + source.name,
+        [&]() { yo::LetterboxTransform setup(source.size, MODEL_SIZE); });
+
+    cv::Mat cropped;
+    std::vector<float> classify_blob(static_cast<size_t>(CLASSIFY_SIZE.area()) *
+                                     image.channels());
+    run("centercrop_chw/" + source.name,
+        [&]()
+        {
+          yo::centercrop(image, cropped, CLASSIFY_SIZE);
+          yo::fill_chw(cropped, classify_blob.data());
+        });
+
+    // an NV12 capture frame: BGR conversion before the fused letterbox, against converting in it
+    cv::Mat nv12(source.size.height * 3 / 2, source.size.width, CV_8UC1);
+    cv::randu(nv12, cv::Scalar::all(0), cv::Scalar::all(255));
+    yo::YuvImage frame = yo::YuvImage::nv12(nv12.data,
+                                            source.size.width,
+                                            nv12.ptr(source.size.height),
+                                            source.size.width,
+                                            source.size);
+    cv::Mat bgr;
+    run("nv12_bgr_letterbox_chw/" + source.name,
+        [&]()
+        {
+          cv::cvtColor(nv12, bgr, cv::COLOR_YUV2BGR_NV12);
+          transform.applyChw(bgr, blob.data());
+        });
+    run("nv12_letterbox_chw/" + source.name, [&]() { transform.applyChw(frame, blob.data()); });
+  }
+
+  // candidate decoding of the head as select_decoder() picks it for each task's usual class count
+  // (80 and 1 are unrolled, 20 takes the generic loop), then the boxes back to the source frame
+  // and NMS over them, as in postprocess
+  struct Head
+  {
+    std::string name;
+    int nc;
+    int num_extra;
+  };
+  const std::vector<Head> HEADS = {{"detect80", 80, 0},
+                                   {"segment80", 80, MASK_FEATURES},
+                                   {"pose1", 1, NUM_KPT_VALUES},
+                                   {"detect20", 20, 0}};
+  const yo::LetterboxTransform transform_1080p(SOURCES[1].size, MODEL_SIZE);
+  for (const Head& spec : HEADS)
+  {
+    const yo::DecodeCandidatesFn decode = yo::select_decoder(spec.nc);
+    for (int count : CANDIDATES)
+    {
+      const cv::Mat head = make_head(spec.nc, spec.num_extra, count, gen);
+      const std::string n = std::to_string(count);
+      yo::DetectionCandidates candidates;
+      run("decode_candidates/" + spec.name + "/" + n,
+          [&]()
+          {
+            decode(head.ptr<float>(), spec.nc, spec.num_extra, NUM_PREDS, 0.5f, candidates);
+          });
+      if (spec.name != "detect80")
+        continue;
+
+      std::vector<cv::Rect> boxes;
+      run("to_source_boxes/" + n,
+          [&]()
+          {
+            boxes.clear();
+            for (const cv::Rect_<float>& bbox : candidates.boxes)
+              boxes.push_back(transform_1080p.toSource(bbox));
+          });
+      std::vector<int> order;
+      std::vector<int> keep;
+      run("nms_boxes/" + n,
+          [&]() { yo::nms_boxes(boxes, candidates.confidences, 0.5f, 0.45f, order, keep); });
+    }
+  }
+  for (int instances : INSTANCES)
+  {
+    std::uniform_real_distribution<float> coord(0.0f, 640.0f);
+    std::vector<std::vector<float>> keypoints(instances, std::vector<float>(NUM_KPT_VALUES));
+    for (std::vector<float>& kpts : keypoints)
+      for (float& value : kpts)
+        value = coord(gen);
+    std::vector<float> scratch;
+    run("to_source_coords/" + std::to_string(instances),
+        [&]()
+        {
+          for (const std::vector<float>& kpts : keypoints)
+          {
+            scratch = kpts;
+            transform_1080p.toSourceCoords(scratch);
+          }
+        });
+  }
+
+  // mask decoding: one proto matmul, sigmoid and the resizes to the source per instance
+  cv::Mat proto(MASK_FEATURES, MASK_SIZE.area(), CV_32F);
+  cv::randn(proto, 0.0, 1.0);
+  for (const Source& source : SOURCES)
+  {
+    const yo::LetterboxTransform transform(source.size, MODEL_SIZE);
+    for (int instances : INSTANCES)
+    {
+      cv::Mat coeffs(instances, MASK_FEATURES, CV_32F);
+      cv::randn(coeffs, 0.0, 1.0);
+      std::vector<cv::Rect> bounds;
+      for (const cv::Rect_<float>& box : make_boxes(instances, gen))
+        bounds.push_back(transform.toSource(box));
+      cv::Mat mask_out;
+      run("get_mask2/" + source.name + "/" + std::to_string(instances),
+          [&]()
+          {
+            for (int i = 0; i < instances; ++i)
+            {
+              yo::AutoBackendOnnx::_get_mask2(
+                  coeffs.row(i), proto, transform, bounds[i], mask_out, 0.5f, MASK_SIZE);
+            }
+          });
+    }
+  }
+  return 0;
+}
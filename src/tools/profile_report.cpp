@@ -0,0 +1,112 @@
+// Per-operator breakdown of where inference time goes.
+//
+// Either profiles --runs predictions of a model on an image (the first, cold run is left out) or
+// reports an existing onnxruntime trace given with --trace. Model runs also report the host side,
+// the part of a prediction spent outside the session (preprocess, postprocess, tensor copies).
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include <opencv2/imgcodecs.hpp>
+
+#include <yolov8_onnxruntime/nn/autobackend.h>
+#include <yolov8_onnxruntime/utils/profiling.h>
+
+namespace yo = yolov8_onnxruntime;
+
+int main(int argc, char** argv)
+{
+  std::string model_path;
+  std::string image_path;
+  std::string trace_path;
+  std::string provider = yo::OnnxProviders::CPU;
+  int runs = 20;
+  int skip = 1;
+  size_t top = 20;
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    auto next = [&]() -> std::string
+    {
+      if (i + 1 >= argc)
+        throw std::runtime_error("Error: missing value for " + arg);
+      return argv[++i];
+    };
+    if (arg == "--model")
+      model_path = next();
+    else if (arg == "--image")
+      image_path = next();
+    else if (arg == "--trace")
+      trace_path = next();
+    else if (arg == "--provider")
+      provider = next();
+    else if (arg == "--runs")
+      runs = std::max(1, std::stoi(next()));
+    else if (arg == "--skip")
+      skip = std::stoi(next());
+    else if (arg == "--top")
+      top = std::stoul(next());
+    else
+    {
+      std::cerr << "usage: " << argv[0]
+                << " (--model model.onnx --image image.jpg [--provider cpu|cuda|openvino]"
+                << " [--runs 20] | --trace profile.json [--skip 1]) [--top 20]" << std::endl;
+      return 2;
+    }
+  }
+
+  if (!trace_path.empty())
+  {
+    yo::print_profile_report(std::cout, yo::parse_ort_profile(trace_path, skip), top);
+    return 0;
+  }
+  if (model_path.empty() || image_path.empty())
+  {
+    std::cerr << "Error: --model and --image (or --trace) are required" << std::endl;
+    return 2;
+  }
+
+  yo::OnnxProviders_t onnx_provider = yo::OnnxProviders_t::CPU;
+  if (provider == yo::OnnxProviders::CUDA)
+    onnx_provider = yo::OnnxProviders_t::CUDA;
+  else if (provider == yo::OnnxProviders::OPENVINO)
+    onnx_provider = yo::OnnxProviders_t::OPENVINO;
+
+  // the cold first run is recorded too and skipped by the report
+  yo::SessionConfig config;
+  config.profiling.enabled = true;
+  yo::AutoBackendOnnx model(model_path.c_str(), "profile_report", onnx_provider, config);
+
+  const cv::Mat image = cv::imread(image_path);
+  if (image.empty())
+  {
+    std::cerr << "Error: cannot read " << image_path << std::endl;
+    return 1;
+  }
+
+  yo::InferenceWorkspace workspace;
+  yo::PredictOptions options;
+  std::vector<double> predict_us;
+  for (int run = 0; run < runs + 1; ++run)
+  {
+    auto start = std::chrono::steady_clock::now();
+    model.predict(image, options, workspace);
+    double us =
+        std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start)
+            .count();
+    if (run > 0)
+      predict_us.push_back(us);
+  }
+
+  std::cout << "trace: " << model.endProfiling() << std::endl;
+  yo::ProfileReport report = model.profileReport(1);
+  double predict_ms =
+      std::accumulate(predict_us.begin(), predict_us.end(), 0.0) / predict_us.size() / 1000.0;
+  std::cout << std::fixed << std::setprecision(3) << "predict: " << predict_ms
+            << "ms per image, host side " << predict_ms - report.runMeanMs() << "ms" << std::endl;
+  yo::print_profile_report(std::cout, report, top);
+  return 0;
+}
@@ -0,0 +1,360 @@
+// Golden-output accuracy and per-stage performance regression check.
+//
+// Runs every case of a suite manifest, compares the results with the case's golden file and the
+// median stage timings with the case's budgets, prints one JSON line per case and exits with 1 if
+// any case regressed. Changes to letterbox, fill_chw, NMS or mask decoding have to pass it on the
+// deployment hardware before they ship.
+//
+// Suite manifest, paths are relative to the manifest:
+// {
+//   "runs": 20,              timed predictions per case, after 3 warmup calls
+//   "budget_slack": 0.10,    a stage fails above budget * (1 + budget_slack)
+//   "tolerance": {"box_px": 2.0, "conf": 0.02, "keypoint_px": 2.0, "mask_iou": 0.90},
+//   "cases": [
+//     {"name": "detect", "model": "models/yolov8n.onnx", "image": "images/bus.jpg",
+//      "golden": "golden/detect.json", "conf": 0.25, "iou": 0.45, "mask_threshold": 0.5,
+//      "budget_ms": {"preprocess": 2.5, "inference": 30.0, "postprocess": 0.8}}
+//   ]
+// }
+//
+// --update rewrites the golden files from the current build (review their diff before committing
+// them) and reports the measured timings without checking them.
+//
+// Models and images are not part of the repository. A case whose model or image is missing is
+// reported as skipped, and the exit status is 77 (what ctest reports as skipped) when no case ran.
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <yolov8_onnxruntime/nn/autobackend.h>
+#include <yolov8_onnxruntime/utils/json.h>
+#include <yolov8_onnxruntime/utils/serialization.h>
+
+#include "bench.h"
+
+namespace fs = std::filesystem;
+namespace yo = yolov8_onnxruntime;
+
+namespace
+{
+
+struct Tolerance
+{
+  double box_px = 2.0;
+  double conf = 0.02;
+  double keypoint_px = 2.0;
+  double mask_iou = 0.90;
+};
+
+const std::vector<std::string> STAGES = {"preprocess", "inference", "postprocess"};
+
+std::string read_file(const fs::path& path)
+{
+  std::ifstream file(path, std::ios::binary);
+  if (!file)
+    throw std::runtime_error("Error: cannot read " + path.string());
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+  return buffer.str();
+}
+
+cv::Rect_<float> json_rect(const yo::JsonValue& array)
+{
+  const std::vector<yo::JsonValue>& v = array.asArray();
+  if (v.size() != 4)
+    throw std::runtime_error("Error: golden bbox must have 4 values");
+  return {static_cast<float>(v[0].asNumber()),
+          static_cast<float>(v[1].asNumber()),
+          static_cast<float>(v[2].asNumber()),
+          static_cast<float>(v[3].asNumber())};
+}
+
+float box_iou(const cv::Rect_<float>& a, const cv::Rect_<float>& b)
+{
+  float inter = (a & b).area();
+  float uni = a.area() + b.area() - inter;
+  return uni > 0.0f ? inter / uni : 0.0f;
+}
+
+/// IoU of two bbox-relative masks placed at their boxes' top-left corners.
+double mask_iou(const cv::Mat& a, const cv::Point& a_at, const cv::Mat& b, const cv::Point& b_at)
+{
+  cv::Rect overlap = cv::Rect(a_at, a.size()) & cv::Rect(b_at, b.size());
+  double inter = 0.0;
+  if (overlap.area() > 0)
+  {
+    cv::Mat both;
+    cv::bitwise_and(a(overlap - a_at) != 0, b(overlap - b_at) != 0, both);
+    inter = cv::countNonZero(both);
+  }
+  double uni = cv::countNonZero(a) + cv::countNonZero(b) - inter;
+  return uni > 0.0 ? inter / uni : 1.0;
+}
+
+/**
+ * @brief Matches every golden object to the unmatched result of the same class with the highest
+ * box IoU and reports what is out of tolerance, missing or unexpected.
+ */
+std::vector<std::string> compare(const yo::JsonValue& golden,
+                                 const std::vector<yo::YoloResults>& results,
+                                 const Tolerance& tol)
+{
+  std::vector<std::string> mismatches;
+  std::vector<bool> matched(results.size(), false);
+  const std::vector<yo::JsonValue>& expected = golden.asArray();
+  for (size_t g = 0; g < expected.size(); ++g)
+  {
+    const yo::JsonValue& object = expected[g];
+    int class_idx = static_cast<int>(object.numberOr("class", -1));
+    const yo::JsonValue* bbox_value = object.find("bbox");
+    cv::Rect_<float> bbox = bbox_value ? json_rect(*bbox_value) : cv::Rect_<float>();
+    std::string id = "object " + std::to_string(g) + " (class " + std::to_string(class_idx) + ")";
+
+    int best = -1;
+    float best_iou = -1.0f;
+    for (size_t r = 0; r < results.size(); ++r)
+    {
+      if (matched[r] || results[r].class_idx != class_idx)
+        continue;
+      float iou = box_iou(bbox, results[r].bbox);
+      if (iou > best_iou)
+      {
+        best = static_cast<int>(r);
+        best_iou = iou;
+      }
+    }
+    // classification results have no box, everything else has to overlap
+    if (best < 0 || (bbox.area() > 0.0f && best_iou <= 0.0f))
+    {
+      mismatches.push_back(id + " missing");
+      continue;
+    }
+    matched[best] = true;
+    const yo::YoloResults& result = results[best];
+
+    double conf_diff = std::abs(result.conf - object.numberOr("conf", 0.0));
+    if (conf_diff > tol.conf)
+      mismatches.push_back(id + " conf off by " + std::to_string(conf_diff));
+
+    double box_diff = std::max({std::abs(result.bbox.x - bbox.x),
+                                std::abs(result.bbox.y - bbox.y),
+                                std::abs(result.bbox.width - bbox.width),
+                                std::abs(result.bbox.height - bbox.height)});
+    if (box_diff > tol.box_px)
+      mismatches.push_back(id + " bbox off by " + std::to_string(box_diff) + "px");
+
+    if (const yo::JsonValue* keypoints = object.find("keypoints"))
+    {
+      const std::vector<yo::JsonValue>& values = keypoints->asArray();
+      if (values.size() != result.keypoints.size())
+      {
+        mismatches.push_back(id + " has " + std::to_string(result.keypoints.size()) +
+                             " keypoint values instead of " + std::to_string(values.size()));
+      }
+      else
+      {
+        // [x, y, visibility] triplets, visibility is a score like conf
+        double xy_diff = 0.0;
+        double visibility_diff = 0.0;
+        for (size_t k = 0; k < values.size(); ++k)
+        {
+          double diff = std::abs(result.keypoints[k] - values[k].asNumber());
+          double& worst = k % 3 == 2 ? visibility_diff : xy_diff;
+          worst = std::max(worst, diff);
+        }
+        if (xy_diff > tol.keypoint_px)
+          mismatches.push_back(id + " keypoints off by " + std::to_string(xy_diff) + "px");
+        if (visibility_diff > tol.conf)
+          mismatches.push_back(id + " keypoint visibility off by " +
+                               std::to_string(visibility_diff));
+      }
+    }
+
+    if (const yo::JsonValue* mask = object.find("mask"))
+    {
+      const yo::JsonValue* size = mask->find("size");
+      const yo::JsonValue* runs = mask->find("counts");
+      if (size == nullptr || runs == nullptr || size->asArray().size() != 2)
+      {
+        mismatches.push_back(id + " golden mask has no size or counts");
+        continue;
+      }
+      std::vector<uint32_t> counts;
+      for (const yo::JsonValue& count : runs->asArray())
+        counts.push_back(static_cast<uint32_t>(count.asNumber()));
+      cv::Mat golden_mask =
+          yo::rle_to_mask(counts.data(),
+                          counts.size(),
+                          cv::Size(static_cast<int>(size->asArray()[1].asNumber()),
+                                   static_cast<int>(size->asArray()[0].asNumber())));
+      double iou = result.mask.empty()
+                       ? 0.0
+                       : mask_iou(golden_mask,
+                                  cv::Point(cvRound(bbox.x), cvRound(bbox.y)),
+                                  result.mask,
+                                  cv::Point(cvRound(result.bbox.x), cvRound(result.bbox.y)));
+      if (iou < tol.mask_iou)
+        mismatches.push_back(id + " mask IoU " + std::to_string(iou));
+    }
+  }
+  for (size_t r = 0; r < results.size(); ++r)
+  {
+    if (!matched[r])
+      mismatches.push_back("unexpected object of class " + std::to_string(results[r].class_idx));
+  }
+  return mismatches;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  std::string manifest_path;
+  bool update = false;
+  std::string only;
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    if (arg == "--update")
+      update = true;
+    else if (arg == "--case" && i + 1 < argc)
+      only = argv[++i];
+    else if (manifest_path.empty() && arg[0] != '-')
+      manifest_path = arg;
+    else
+    {
+      std::cerr << "usage: " << argv[0] << " suite.json [--case NAME] [--update]" << std::endl;
+      return 2;
+    }
+  }
+  if (manifest_path.empty())
+  {
+    std::cerr << "usage: " << argv[0] << " suite.json [--case NAME] [--update]" << std::endl;
+    return 2;
+  }
+
+  const fs::path root = fs::path(manifest_path).parent_path();
+  auto resolve = [&root](const std::string& path)
+  { return fs::path(path).is_absolute() ? fs::path(path) : root / path; };
+
+  yo::JsonValue manifest = yo::JsonValue::parse(read_file(manifest_path));
+  const size_t runs = static_cast<size_t>(std::max(1.0, manifest.numberOr("runs", 20)));
+  const double slack = manifest.numberOr("budget_slack", 0.10);
+  Tolerance tol;
+  if (const yo::JsonValue* t = manifest.find("tolerance"))
+  {
+    tol.box_px = t->numberOr("box_px", tol.box_px);
+    tol.conf = t->numberOr("conf", tol.conf);
+    tol.keypoint_px = t->numberOr("keypoint_px", tol.keypoint_px);
+    tol.mask_iou = t->numberOr("mask_iou", tol.mask_iou);
+  }
+  const yo::JsonValue* cases = manifest.find("cases");
+  if (!cases || !cases->isArray())
+    throw std::runtime_error("Error: " + manifest_path + " has no cases array");
+
+  bool failed = false;
+  size_t ran = 0;
+  for (const yo::JsonValue& test_case : cases->asArray())
+  {
+    const std::string name = test_case.stringOr("name", "");
+    if (!only.empty() && name != only)
+      continue;
+
+    const fs::path model_path = resolve(test_case.stringOr("model", ""));
+    const fs::path image_path = resolve(test_case.stringOr("image", ""));
+    if (!fs::is_regular_file(model_path) || !fs::is_regular_file(image_path))
+    {
+      const fs::path& missing = fs::is_regular_file(model_path) ? image_path : model_path;
+      std::cout << "{\"case\":\"" << yo::json_escape(name)
+                << "\",\"status\":\"skipped\",\"missing\":\"" << yo::json_escape(missing.string())
+                << "\"}" << std::endl;
+      continue;
+    }
+    ++ran;
+    yo::AutoBackendOnnx model(model_path.string().c_str(), "regression", yo::OnnxProviders_t::CPU);
+    const cv::Mat image = cv::imread(image_path.string());
+    if (image.empty())
+      throw std::runtime_error("Error: cannot read " + image_path.string());
+
+    yo::PredictOptions options;
+    options.conf = static_cast<float>(test_case.numberOr("conf", options.conf));
+    options.iou = static_cast<float>(test_case.numberOr("iou", options.iou));
+    options.mask_threshold =
+        static_cast<float>(test_case.numberOr("mask_threshold", options.mask_threshold));
+    options.conversionCode = cv::COLOR_BGR2RGB;
+    yo::InferenceWorkspace workspace;
+
+    // 1. accuracy on the first call, which also has to be right
+    std::vector<yo::YoloResults> results = model.predict(image, options, workspace);
+    const fs::path golden_path = resolve(test_case.stringOr("golden", name + ".json"));
+    std::vector<std::string> mismatches;
+    if (update)
+    {
+      if (!golden_path.parent_path().empty())
+        fs::create_directories(golden_path.parent_path());
+      std::ofstream golden(golden_path);
+      yo::write_json(golden, results);
+      golden << '\n';
+    }
+    else if (!fs::is_regular_file(golden_path))
+    {
+      mismatches.push_back("no golden file " + golden_path.string() + ", create it with --update");
+    }
+    else
+    {
+      mismatches = compare(yo::JsonValue::parse(read_file(golden_path)), results, tol);
+    }
+
+    // 2. stage timings
+    yo::PredictTimings timings;
+    options.timings = &timings;
+    std::vector<std::vector<double>> stage_ms(STAGES.size());
+    for (size_t run = 0; run < runs + 3; ++run)
+    {
+      model.predict(image, options, workspace);
+      if (run < 3)
+        continue;
+      stage_ms[0].push_back(timings.preprocess_ms);
+      stage_ms[1].push_back(timings.inference_ms);
+      stage_ms[2].push_back(timings.postprocess_ms);
+    }
+
+    bool case_failed = !mismatches.empty();
+    std::ostringstream line;
+    line << "{\"case\":\"" << yo::json_escape(name) << "\",\"objects\":" << results.size()
+         << ",\"mismatches\":[";
+    for (size_t i = 0; i < mismatches.size(); ++i)
+      line << (i ? "," : "") << '"' << yo::json_escape(mismatches[i]) << '"';
+    line << ']';
+    const yo::JsonValue* budgets = test_case.find("budget_ms");
+    for (size_t s = 0; s < STAGES.size(); ++s)
+    {
+      double median = yo::bench::median(stage_ms[s]);
+      line << ",\"" << STAGES[s] << "_ms\":" << median;
+      double budget = budgets ? budgets->numberOr(STAGES[s], 0.0) : 0.0;
+      if (budget > 0.0)
+      {
+        line << ",\"" << STAGES[s] << "_budget_ms\":" << budget;
+        if (!update && median > budget * (1.0 + slack))
+        {
+          case_failed = true;
+          line << ",\"" << STAGES[s] << "_regressed\":true";
+        }
+      }
+    }
+    line << ",\"status\":\"" << (update ? "updated" : case_failed ? "fail" : "pass") << "\"}";
+    std::cout << line.str() << std::endl;
+    failed |= case_failed;
+  }
+  if (ran == 0)
+    return 77;
+  return failed ? 1 : 0;
+}
@@ -3,6 +3,8 @@
 #include <opencv2/core/types.hpp>
 #include <opencv2/imgproc.hpp>
 
+#include <vector>
+
 namespace yolov8_onnxruntime
 {
 /**
@@ -18,6 +20,20 @@ void letterbox(const cv::Mat& image,
                bool scaleFill,
                bool scaleUp,
                int stride)
+{
+  cv::Mat scratch;
+  letterbox(image, outImage, scratch, newShape, color, auto_, scaleFill, scaleUp, stride);
+}
+
+void letterbox(const cv::Mat& image,
+               cv::Mat& outImage,
+               cv::Mat& scratch,
+               const cv::Size& newShape,
+               cv::Scalar_<double> color,
+               bool auto_,
+               bool scaleFill,
+               bool scaleUp,
+               int stride)
 {
   cv::Size shape = image.size();
   float r = std::min(static_cast<float>(newShape.height) / static_cast<float>(shape.height),
@@ -50,14 +66,12 @@ void letterbox(const cv::Mat& image,
   dw /= 2.0f;
   dh /= 2.0f;
 
-  // cv::Mat outImage;
+  // an unresized image is bordered straight from the source
+  const cv::Mat* unpadded = &image;
   if (shape.width != newUnpad[0] || shape.height != newUnpad[1])
   {
-    cv::resize(image, outImage, cv::Size(newUnpad[0], newUnpad[1]));
-  }
-  else
-  {
-    outImage = image.clone();
+    cv::resize(image, scratch, cv::Size(newUnpad[0], newUnpad[1]));
+    unpadded = &scratch;
   }
 
   int top = static_cast<int>(std::round(dh - 0.1f));
@@ -71,10 +85,22 @@ void letterbox(const cv::Mat& image,
         DEFAULT_LETTERBOX_PAD_VALUE, DEFAULT_LETTERBOX_PAD_VALUE, DEFAULT_LETTERBOX_PAD_VALUE);
   }
 
-  cv::copyMakeBorder(outImage, outImage, top, bottom, left, right, cv::BORDER_CONSTANT, color);
+  cv::copyMakeBorder(*unpadded, outImage, top, bottom, left, right, cv::BORDER_CONSTANT, color);
 }
 
 cv::Mat centercrop(const cv::Mat& img, const cv::Size& targetSize)
+{
+  int m = std::min(img.rows, img.cols);
+  cv::Mat cropped = img(cv::Rect((img.cols - m) / 2, (img.rows - m) / 2, m, m));
+  if (targetSize == cropped.size())
+    return cropped; // No resizing needed if it's already the correct size
+
+  cv::Mat resized;
+  centercrop(img, resized, targetSize);
+  return resized;
+}
+
+void centercrop(const cv::Mat& img, cv::Mat& out, const cv::Size& targetSize)
 {
   int h = img.rows;
   int w = img.cols;
@@ -86,17 +112,50 @@ cv::Mat centercrop(const cv::Mat& img, const cv::Size& targetSize)
   cv::Rect centerRegion(left, top, m, m); // Define the square region in the center
   cv::Mat cropped = img(centerRegion);    // Crop the center region
 
-  cv::Mat resized;
   if (targetSize != cropped.size())
   {
-    cv::resize(cropped, resized, targetSize); // Resize to the desired dimensions
+    cv::resize(cropped, out, targetSize); // Resize to the desired dimensions
   }
   else
   {
-    resized = cropped; // No resizing needed if it's already the correct size
+    cropped.copyTo(out);
   }
+}
 
-  return resized;
+void fill_chw(const cv::Mat& image, float* blob, double scale)
+{
+  // 8-bit images are the common case, deinterleave them directly without a float temporary
+  if (image.depth() == CV_8U)
+  {
+    const int channels = image.channels();
+    const size_t plane = image.total();
+    const float factor = static_cast<float>(scale);
+    for (int y = 0; y < image.rows; ++y)
+    {
+      const uchar* row = image.ptr<uchar>(y);
+      float* out = blob + static_cast<size_t>(y) * image.cols;
+      for (int c = 0; c < channels; ++c)
+      {
+        float* out_c = out + c * plane;
+        for (int x = 0; x < image.cols; ++x)
+          out_c[x] = row[x * channels + c] * factor;
+      }
+    }
+    return;
+  }
+
+  cv::Mat floatImage;
+  image.convertTo(floatImage, CV_32F, scale);
+  cv::Size floatImageSize{floatImage.cols, floatImage.rows};
+
+  // hwc -> chw
+  std::vector<cv::Mat> chw(floatImage.channels());
+  for (int i = 0; i < floatImage.channels(); ++i)
+  {
+    chw[i] =
+        cv::Mat(floatImageSize, CV_32FC1, blob + i * floatImageSize.width * floatImageSize.height);
+  }
+  cv::split(floatImage, chw);
 }
 
 cv::Mat scale_image(const cv::Mat& resized_mask,
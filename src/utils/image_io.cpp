@@ -0,0 +1,114 @@
+#include "yolov8_onnxruntime/utils/image_io.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+#include <opencv2/imgcodecs.hpp>
+
+namespace yolov8_onnxruntime
+{
+
+bool read_jpeg_size(const std::vector<uchar>& buffer, cv::Size& size)
+{
+  const size_t n = buffer.size();
+  // SOI marker
+  if (n < 4 || buffer[0] != 0xFF || buffer[1] != 0xD8)
+    return false;
+
+  size_t pos = 2;
+  while (pos + 4 <= n)
+  {
+    if (buffer[pos] != 0xFF)
+      return false;
+    uchar marker = buffer[pos + 1];
+    // fill bytes
+    if (marker == 0xFF)
+    {
+      ++pos;
+      continue;
+    }
+    pos += 2;
+    // standalone markers (TEM, RSTn) carry no length field
+    if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7))
+      continue;
+    // EOI/SOS before any SOFn: nothing more to look at
+    if (marker == 0xD9 || marker == 0xDA)
+      return false;
+
+    size_t segment_length = (static_cast<size_t>(buffer[pos]) << 8) | buffer[pos + 1];
+    if (segment_length < 2 || pos + segment_length > n)
+      return false;
+
+    // SOF0..SOF15 except DHT (C4), JPG (C8) and DAC (CC)
+    bool is_sof =
+        marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC;
+    if (is_sof)
+    {
+      if (segment_length < 7)
+        return false;
+      int height = (buffer[pos + 3] << 8) | buffer[pos + 4];
+      int width = (buffer[pos + 5] << 8) | buffer[pos + 6];
+      size = cv::Size(width, height);
+      return width > 0 && height > 0;
+    }
+    pos += segment_length;
+  }
+  return false;
+}
+
+int reduced_decode_factor(const cv::Size& raw_size, const cv::Size& target_size)
+{
+  if (raw_size.width <= 0 || raw_size.height <= 0)
+    return 1;
+
+  // same ratio letterbox would use to fit the image into target_size
+  float r = std::min(static_cast<float>(target_size.height) / static_cast<float>(raw_size.height),
+                     static_cast<float>(target_size.width) / static_cast<float>(raw_size.width));
+  for (int factor : {8, 4, 2})
+  {
+    if (r * static_cast<float>(factor) <= 1.0f)
+      return factor;
+  }
+  return 1;
+}
+
+cv::Mat imread_reduced(const std::string& path, const cv::Size& target_size, cv::Size& raw_size)
+{
+  std::ifstream file(path, std::ios::binary);
+  if (!file)
+    return {};
+  std::vector<uchar> buffer((std::istreambuf_iterator<char>(file)),
+                            std::istreambuf_iterator<char>());
+
+  int factor = 1;
+  cv::Size jpeg_size;
+  if (read_jpeg_size(buffer, jpeg_size))
+    factor = reduced_decode_factor(jpeg_size, target_size);
+
+  int flags = cv::IMREAD_UNCHANGED;
+  switch (factor)
+  {
+  case 2:
+    flags = cv::IMREAD_REDUCED_COLOR_2 | cv::IMREAD_IGNORE_ORIENTATION;
+    break;
+  case 4:
+    flags = cv::IMREAD_REDUCED_COLOR_4 | cv::IMREAD_IGNORE_ORIENTATION;
+    break;
+  case 8:
+    flags = cv::IMREAD_REDUCED_COLOR_8 | cv::IMREAD_IGNORE_ORIENTATION;
+    break;
+  default:
+    break;
+  }
+
+  cv::Mat image = cv::imdecode(buffer, flags);
+  if (image.empty())
+    return image;
+
+  // the header size is the frame results have to be reported in
+  raw_size = factor > 1 ? jpeg_size : image.size();
+  return image;
+}
+
+} // namespace yolov8_onnxruntime
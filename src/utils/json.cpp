@@ -0,0 +1,298 @@
+#include "yolov8_onnxruntime/utils/json.h"
+
+#include <cstdlib>
+#include <stdexcept>
+
+namespace yolov8_onnxruntime
+{
+
+class JsonParser
+{
+public:
+  explicit JsonParser(const std::string& text) : text_(text) {}
+
+  JsonValue parseDocument()
+  {
+    JsonValue value = parseValue();
+    skipWhitespace();
+    if (pos_ != text_.size())
+      fail("trailing characters");
+    return value;
+  }
+
+private:
+  [[noreturn]] void fail(const std::string& what) const
+  {
+    throw std::runtime_error("Error: invalid JSON at offset " + std::to_string(pos_) + ": " +
+                             what);
+  }
+
+  void skipWhitespace()
+  {
+    while (pos_ < text_.size() &&
+           (text_[pos_] == ' ' || text_[pos_] == '\n' || text_[pos_] == '\r' ||
+            text_[pos_] == '\t'))
+      ++pos_;
+  }
+
+  void expect(char ch)
+  {
+    skipWhitespace();
+    if (pos_ >= text_.size() || text_[pos_] != ch)
+      fail(std::string("expected '") + ch + "'");
+    ++pos_;
+  }
+
+  bool consumeLiteral(const char* literal)
+  {
+    size_t len = std::char_traits<char>::length(literal);
+    if (text_.compare(pos_, len, literal) != 0)
+      return false;
+    pos_ += len;
+    return true;
+  }
+
+  JsonValue parseValue()
+  {
+    skipWhitespace();
+    if (pos_ >= text_.size())
+      fail("unexpected end of input");
+
+    JsonValue value;
+    char ch = text_[pos_];
+    if (ch == '{')
+    {
+      value.type_ = JsonValue::Type::OBJECT;
+      ++pos_;
+      skipWhitespace();
+      if (pos_ < text_.size() && text_[pos_] == '}')
+      {
+        ++pos_;
+        return value;
+      }
+      while (true)
+      {
+        skipWhitespace();
+        if (pos_ >= text_.size() || text_[pos_] != '"')
+          fail("expected object key");
+        value.keys_.push_back(parseString());
+        expect(':');
+        value.values_.push_back(parseValue());
+        skipWhitespace();
+        if (pos_ < text_.size() && text_[pos_] == ',')
+        {
+          ++pos_;
+          continue;
+        }
+        expect('}');
+        return value;
+      }
+    }
+    if (ch == '[')
+    {
+      value.type_ = JsonValue::Type::ARRAY;
+      ++pos_;
+      skipWhitespace();
+      if (pos_ < text_.size() && text_[pos_] == ']')
+      {
+        ++pos_;
+        return value;
+      }
+      while (true)
+      {
+        value.values_.push_back(parseValue());
+        skipWhitespace();
+        if (pos_ < text_.size() && text_[pos_] == ',')
+        {
+          ++pos_;
+          continue;
+        }
+        expect(']');
+        return value;
+      }
+    }
+    if (ch == '"')
+    {
+      value.type_ = JsonValue::Type::STRING;
+      value.string_ = parseString();
+      return value;
+    }
+    if (consumeLiteral("true"))
+    {
+      value.type_ = JsonValue::Type::BOOLEAN;
+      value.bool_ = true;
+      return value;
+    }
+    if (consumeLiteral("false"))
+    {
+      value.type_ = JsonValue::Type::BOOLEAN;
+      return value;
+    }
+    if (consumeLiteral("null"))
+      return value;
+
+    const char* begin = text_.c_str() + pos_;
+    char* end = nullptr;
+    value.number_ = std::strtod(begin, &end);
+    if (end == begin)
+      fail("unexpected character");
+    value.type_ = JsonValue::Type::NUMBER;
+    pos_ += static_cast<size_t>(end - begin);
+    return value;
+  }
+
+  static void appendUtf8(std::string& out, unsigned long code)
+  {
+    if (code < 0x80)
+    {
+      out += static_cast<char>(code);
+    }
+    else if (code < 0x800)
+    {
+      out += static_cast<char>(0xC0 | (code >> 6));
+      out += static_cast<char>(0x80 | (code & 0x3F));
+    }
+    else if (code < 0x10000)
+    {
+      out += static_cast<char>(0xE0 | (code >> 12));
+      out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+      out += static_cast<char>(0x80 | (code & 0x3F));
+    }
+    else
+    {
+      out += static_cast<char>(0xF0 | (code >> 18));
+      out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+      out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+      out += static_cast<char>(0x80 | (code & 0x3F));
+    }
+  }
+
+  unsigned long parseHex4()
+  {
+    if (pos_ + 4 > text_.size())
+      fail("truncated \\u escape");
+    unsigned long code = std::strtoul(text_.substr(pos_, 4).c_str(), nullptr, 16);
+    pos_ += 4;
+    return code;
+  }
+
+  std::string parseString()
+  {
+    ++pos_; // opening quote
+    std::string out;
+    while (pos_ < text_.size())
+    {
+      char ch = text_[pos_++];
+      if (ch == '"')
+        return out;
+      if (ch != '\\')
+      {
+        out += ch;
+        continue;
+      }
+      if (pos_ >= text_.size())
+        break;
+      char escaped = text_[pos_++];
+      switch (escaped)
+      {
+      case 'n':
+        out += '\n';
+        break;
+      case 'r':
+        out += '\r';
+        break;
+      case 't':
+        out += '\t';
+        break;
+      case 'b':
+        out += '\b';
+        break;
+      case 'f':
+        out += '\f';
+        break;
+      case 'u':
+      {
+        unsigned long code = parseHex4();
+        // surrogate pair
+        if (code >= 0xD800 && code <= 0xDBFF && text_.compare(pos_, 2, "\\u") == 0)
+        {
+          pos_ += 2;
+          unsigned long low = parseHex4();
+          code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+        }
+        appendUtf8(out, code);
+        break;
+      }
+      default:
+        out += escaped;
+      }
+    }
+    fail("unterminated string");
+  }
+
+  const std::string& text_;
+  size_t pos_ = 0;
+};
+
+JsonValue JsonValue::parse(const std::string& text) { return JsonParser(text).parseDocument(); }
+
+bool JsonValue::asBool() const
+{
+  if (type_ != Type::BOOLEAN)
+    throw std::runtime_error("Error: JSON value is not a boolean");
+  return bool_;
+}
+
+double JsonValue::asNumber() const
+{
+  if (type_ != Type::NUMBER)
+    throw std::runtime_error("Error: JSON value is not a number");
+  return number_;
+}
+
+const std::string& JsonValue::asString() const
+{
+  if (type_ != Type::STRING)
+    throw std::runtime_error("Error: JSON value is not a string");
+  return string_;
+}
+
+const std::vector<JsonValue>& JsonValue::asArray() const
+{
+  if (type_ != Type::ARRAY && type_ != Type::OBJECT)
+    throw std::runtime_error("Error: JSON value is not an array");
+  return values_;
+}
+
+const std::vector<std::string>& JsonValue::keys() const
+{
+  if (type_ != Type::OBJECT)
+    throw std::runtime_error("Error: JSON value is not an object");
+  return keys_;
+}
+
+const JsonValue* JsonValue::find(const std::string& key) const
+{
+  if (type_ != Type::OBJECT)
+    return nullptr;
+  for (size_t i = 0; i < keys_.size(); ++i)
+  {
+    if (keys_[i] == key)
+      return &values_[i];
+  }
+  return nullptr;
+}
+
+double JsonValue::numberOr(const std::string& key, double fallback) const
+{
+  const JsonValue* value = find(key);
+  return value != nullptr && value->isNumber() ? value->number_ : fallback;
+}
+
+std::string JsonValue::stringOr(const std::string& key, const std::string& fallback) const
+{
+  const JsonValue* value = find(key);
+  return value != nullptr && value->isString() ? value->string_ : fallback;
+}
+
+} // namespace yolov8_onnxruntime
@@ -0,0 +1,315 @@
+#include "yolov8_onnxruntime/utils/letterbox.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "yolov8_onnxruntime/utils/ops.h"
+
+namespace yolov8_onnxruntime
+{
+
+namespace
+{
+
+// the gray letterbox() pads with
+const double PAD_VALUE = 114.0;
+
+// Source taps of every destination index, with cv::resize's INTER_LINEAR pixel-center alignment
+// and border clamping.
+void linear_taps(int source_len,
+                 int dest_len,
+                 std::vector<int>& first,
+                 std::vector<int>& second,
+                 std::vector<float>& weight)
+{
+  first.resize(dest_len);
+  second.resize(dest_len);
+  weight.resize(dest_len);
+  const double inv_scale = static_cast<double>(source_len) / dest_len;
+  for (int d = 0; d < dest_len; ++d)
+  {
+    double pos = (d + 0.5) * inv_scale - 0.5;
+    int s = static_cast<int>(std::floor(pos));
+    double frac = pos - s;
+    if (s < 0)
+    {
+      s = 0;
+      frac = 0.0;
+    }
+    if (s >= source_len - 1)
+    {
+      s = source_len - 1;
+      frac = 0.0;
+    }
+    first[d] = s;
+    second[d] = std::min(s + 1, source_len - 1);
+    weight[d] = static_cast<float>(frac);
+  }
+}
+
+// Pads one output row of a plane: the whole row above or below the content, else both sides.
+void pad_row(float* row, int width, const cv::Rect& content, bool padding_row, float pad)
+{
+  if (padding_row)
+  {
+    std::fill(row, row + width, pad);
+    return;
+  }
+  std::fill(row, row + content.x, pad);
+  std::fill(row + content.x + content.width, row + width, pad);
+}
+
+// One content row of a YUV frame: bilinear luma from rows l0/l1, chroma of the nearest tap from
+// the chroma row(s) c0 (and c1 for I420's separate V plane).
+template <YuvFormat_t F>
+void yuv_row(const uchar* l0,
+             const uchar* l1,
+             float wy,
+             const uchar* c0,
+             const uchar* c1,
+             const int* x0,
+             const int* x1,
+             const float* wx,
+             int width,
+             const YuvToRgb& convert,
+             float* first,
+             float* second,
+             float* third)
+{
+  constexpr int step = F == YuvFormat_t::YUYV ? 2 : 1;
+  for (int x = 0; x < width; ++x)
+  {
+    const float a = wx[x];
+    const int i0 = x0[x] * step;
+    const int i1 = x1[x] * step;
+    const float top = l0[i0] + a * (l0[i1] - l0[i0]);
+    const float bottom = l1[i0] + a * (l1[i1] - l1[i0]);
+    const float luma = top + wy * (bottom - top);
+
+    const int cx = (a < 0.5f ? x0[x] : x1[x]) >> 1;
+    float u;
+    float v;
+    if constexpr (F == YuvFormat_t::NV12)
+    {
+      u = c0[2 * cx];
+      v = c0[2 * cx + 1];
+    }
+    else if constexpr (F == YuvFormat_t::NV21)
+    {
+      v = c0[2 * cx];
+      u = c0[2 * cx + 1];
+    }
+    else if constexpr (F == YuvFormat_t::I420)
+    {
+      u = c0[cx];
+      v = c1[cx];
+    }
+    else
+    {
+      u = c0[4 * cx + 1];
+      v = c0[4 * cx + 3];
+    }
+    convert(luma, u, v, first[x], second[x], third[x]);
+  }
+}
+
+} // namespace
+
+LetterboxTransform::LetterboxTransform(const cv::Size& source,
+                                       const cv::Size& target,
+                                       bool scaleUp) :
+    source_(source),
+    target_(target)
+{
+  if (source.empty() || target.empty())
+    return;
+
+  // the placement of letterbox() without auto_ and scaleFill
+  float r = std::min(static_cast<float>(target.height) / static_cast<float>(source.height),
+                     static_cast<float>(target.width) / static_cast<float>(source.width));
+  if (!scaleUp)
+    r = std::min(r, 1.0f);
+  const int width = static_cast<int>(std::round(static_cast<float>(source.width) * r));
+  const int height = static_cast<int>(std::round(static_cast<float>(source.height) * r));
+  const float dw = static_cast<float>(target.width - width) / 2.0f;
+  const float dh = static_cast<float>(target.height - height) / 2.0f;
+  content_ = cv::Rect(static_cast<int>(std::round(dw - 0.1f)),
+                      static_cast<int>(std::round(dh - 0.1f)),
+                      width,
+                      height);
+  gain_ = r;
+  scale_ = cv::Point2f(static_cast<float>(width) / static_cast<float>(source.width),
+                       static_cast<float>(height) / static_cast<float>(source.height));
+
+  linear_taps(source.width, width, x0_, x1_, xweight_);
+  linear_taps(source.height, height, y0_, y1_, yweight_);
+}
+
+cv::Rect_<float> LetterboxTransform::toSource(const cv::Rect_<float>& box) const
+{
+  cv::Rect_<float> mapped((box.x - static_cast<float>(content_.x)) / scale_.x,
+                          (box.y - static_cast<float>(content_.y)) / scale_.y,
+                          box.width / scale_.x,
+                          box.height / scale_.y);
+  clip_boxes(mapped, source_);
+  return mapped;
+}
+
+cv::Rect_<float> LetterboxTransform::toTarget(const cv::Rect_<float>& box) const
+{
+  return cv::Rect_<float>(box.x * scale_.x + static_cast<float>(content_.x),
+                          box.y * scale_.y + static_cast<float>(content_.y),
+                          box.width * scale_.x,
+                          box.height * scale_.y);
+}
+
+void LetterboxTransform::toSourceCoords(std::vector<float>& coords) const
+{
+  for (size_t i = 0; i + 1 < coords.size(); i += 3)
+  {
+    coords[i] = (coords[i] - static_cast<float>(content_.x)) / scale_.x;
+    coords[i + 1] = (coords[i + 1] - static_cast<float>(content_.y)) / scale_.y;
+  }
+  clip_coords(coords, source_);
+}
+
+void LetterboxTransform::apply(const cv::Mat& image, cv::Mat& out, const cv::Scalar& color) const
+{
+  CV_Assert(image.size() == source_);
+  const cv::Scalar fill = color == cv::Scalar() ? cv::Scalar::all(PAD_VALUE) : color;
+  const int right = content_.x + content_.width;
+  const int bottom = content_.y + content_.height;
+
+  out.create(target_, image.type());
+  out.rowRange(0, content_.y).setTo(fill);
+  out.rowRange(bottom, target_.height).setTo(fill);
+  cv::Mat rows = out.rowRange(content_.y, bottom);
+  rows.colRange(0, content_.x).setTo(fill);
+  rows.colRange(right, target_.width).setTo(fill);
+
+  // resizing into the view writes the content in place, create() keeps the view's memory
+  cv::Mat region = out(content_);
+  if (content_.size() == source_)
+    image.copyTo(region);
+  else
+    cv::resize(image, region, content_.size());
+}
+
+void LetterboxTransform::applyChw(const cv::Mat& image,
+                                  float* blob,
+                                  bool swapRB,
+                                  double scale) const
+{
+  CV_Assert(image.size() == source_ && image.depth() == CV_8U && image.channels() <= 4);
+  const int channels = image.channels();
+  // output plane of every input channel
+  int planes[4] = {0, 1, 2, 3};
+  if (swapRB && channels >= 3)
+    std::swap(planes[0], planes[2]);
+  const size_t plane = static_cast<size_t>(target_.area());
+  const float factor = static_cast<float>(scale);
+  const float pad = static_cast<float>(PAD_VALUE * scale);
+
+  cv::parallel_for_(
+      cv::Range(0, target_.height),
+      [&](const cv::Range& range)
+      {
+        for (int y = range.start; y < range.end; ++y)
+        {
+          const int cy = y - content_.y;
+          const bool padding_row = cy < 0 || cy >= content_.height;
+          const uchar* top = padding_row ? nullptr : image.ptr<uchar>(y0_[cy]);
+          const uchar* bottom = padding_row ? nullptr : image.ptr<uchar>(y1_[cy]);
+          const float wy = padding_row ? 0.0f : yweight_[cy];
+          for (int c = 0; c < channels; ++c)
+          {
+            float* out = blob + planes[c] * plane + static_cast<size_t>(y) * target_.width;
+            pad_row(out, target_.width, content_, padding_row, pad);
+            if (padding_row)
+              continue;
+            float* dst = out + content_.x;
+            for (int x = 0; x < content_.width; ++x)
+            {
+              const int i0 = x0_[x] * channels + c;
+              const int i1 = x1_[x] * channels + c;
+              const float wx = xweight_[x];
+              const float t = top[i0] + wx * (top[i1] - top[i0]);
+              const float b = bottom[i0] + wx * (bottom[i1] - bottom[i0]);
+              dst[x] = (t + wy * (b - t)) * factor;
+            }
+          }
+        }
+      });
+}
+
+void LetterboxTransform::applyChw(const YuvImage& image,
+                                  float* blob,
+                                  bool rgb,
+                                  double scale) const
+{
+  CV_Assert(image.valid() && image.size == source_);
+  const size_t plane = static_cast<size_t>(target_.area());
+  const float pad = static_cast<float>(PAD_VALUE * scale);
+  const YuvToRgb convert(image.full_range, static_cast<float>(scale));
+  // 4:2:0 formats share one chroma row between two luma rows, YUYV carries chroma in every row
+  const int chroma_shift = image.format == YuvFormat_t::YUYV ? 0 : 1;
+  const int chroma_plane = image.format == YuvFormat_t::YUYV ? 0 : 1;
+  // the format is resolved once, the row loop runs the matching specialization
+  decltype(&yuv_row<YuvFormat_t::NV12>) row_fn = yuv_row<YuvFormat_t::NV12>;
+  if (image.format == YuvFormat_t::NV21)
+    row_fn = yuv_row<YuvFormat_t::NV21>;
+  else if (image.format == YuvFormat_t::I420)
+    row_fn = yuv_row<YuvFormat_t::I420>;
+  else if (image.format == YuvFormat_t::YUYV)
+    row_fn = yuv_row<YuvFormat_t::YUYV>;
+
+  cv::parallel_for_(
+      cv::Range(0, target_.height),
+      [&](const cv::Range& range)
+      {
+        for (int y = range.start; y < range.end; ++y)
+        {
+          const size_t offset = static_cast<size_t>(y) * target_.width;
+          float* red = blob + (rgb ? 0 : 2) * plane + offset;
+          float* green = blob + plane + offset;
+          float* blue = blob + (rgb ? 2 : 0) * plane + offset;
+          const int cy = y - content_.y;
+          const bool padding_row = cy < 0 || cy >= content_.height;
+          pad_row(red, target_.width, content_, padding_row, pad);
+          pad_row(green, target_.width, content_, padding_row, pad);
+          pad_row(blue, target_.width, content_, padding_row, pad);
+          if (padding_row)
+            continue;
+
+          const uchar* l0 = image.planes[0] + static_cast<size_t>(y0_[cy]) * image.strides[0];
+          const uchar* l1 = image.planes[0] + static_cast<size_t>(y1_[cy]) * image.strides[0];
+          const int chroma_row = (yweight_[cy] < 0.5f ? y0_[cy] : y1_[cy]) >> chroma_shift;
+          const uchar* c0 = image.planes[chroma_plane] +
+                            static_cast<size_t>(chroma_row) * image.strides[chroma_plane];
+          const uchar* c1 =
+              image.format == YuvFormat_t::I420
+                  ? image.planes[2] + static_cast<size_t>(chroma_row) * image.strides[2]
+                  : nullptr;
+          const int x = content_.x;
+          row_fn(l0,
+                 l1,
+                 yweight_[cy],
+                 c0,
+                 c1,
+                 x0_.data(),
+                 x1_.data(),
+                 xweight_.data(),
+                 content_.width,
+                 convert,
+                 red + x,
+                 green + x,
+                 blue + x);
+        }
+      });
+}
+
+} // namespace yolov8_onnxruntime
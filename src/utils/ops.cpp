@@ -1,3 +1,5 @@
+#include "yolov8_onnxruntime/utils/ops.h"
+
 #include <opencv2/opencv.hpp>
 //#include <opencv2/imgcodecs.hpp>
 //#include <opencv2/imgproc.hpp>
@@ -5,6 +7,9 @@
 #include <opencv2/core.hpp>
 #include <opencv2/core/mat.hpp>
 #include <opencv2/core/types.hpp>
+#include <opencv2/core/utility.hpp>
+#include <algorithm>
+#include <numeric>
 #include <vector>
 
 namespace yolov8_onnxruntime
@@ -42,12 +47,11 @@ void clip_boxes(std::vector<cv::Rect_<float>>& boxes, const cv::Size& shape)
 }
 
 // source: ultralytics/utils/ops.py scale_boxes lines 99+ (ultralytics==8.0.160)
-cv::Rect_<float> scale_boxes(
-    const cv::Size& img1_shape,
-    cv::Rect_<float>& box,
-    const cv::Size& img0_shape,
-    std::pair<float, cv::Point2f> ratio_pad = std::make_pair(-1.0f, cv::Point2f(-1.0f, -1.0f)),
-    bool padding = true)
+cv::Rect_<float> scale_boxes(const cv::Size& img1_shape,
+                             cv::Rect_<float>& box,
+                             const cv::Size& img0_shape,
+                             std::pair<float, cv::Point2f> ratio_pad,
+                             bool padding)
 {
 
   float gain, pad_x, pad_y;
@@ -118,35 +122,28 @@ scale_coords(const cv::Size& img1_shape, std::vector<float>& coords, const cv::S
 {
   //    cv::Mat scaledCoords = coords.clone();
   std::vector<float> scaledCoords = coords;
+  scale_coords_inplace(img1_shape, scaledCoords, img0_shape);
+  return scaledCoords;
+}
 
+void scale_coords_inplace(const cv::Size& img1_shape,
+                          std::vector<float>& coords,
+                          const cv::Size& img0_shape)
+{
   // Calculate gain and padding
   double gain = std::min(static_cast<double>(img1_shape.width) / img0_shape.width,
                          static_cast<double>(img1_shape.height) / img0_shape.height);
   cv::Point2d pad((img1_shape.width - img0_shape.width * gain) / 2,
                   (img1_shape.height - img0_shape.height * gain) / 2);
 
-  // Apply padding
-  //    scaledCoords.col(0) = (scaledCoords.col(0) - pad.x);
-  //    scaledCoords.col(1) = (scaledCoords.col(1) - pad.y);
-  // Assuming coords are of shape [1, 17, 3]
-  for (int i = 0; i < scaledCoords.size(); i += 3)
-  {
-    scaledCoords[i] -= pad.x;     // x padding
-    scaledCoords[i + 1] -= pad.y; // y padding
-  }
-
-  // Scale coordinates
-  //    scaledCoords.col(0) /= gain;
-  //    scaledCoords.col(1) /= gain;
-  // Assuming coords are of shape [1, 17, 3]
-  for (int i = 0; i < scaledCoords.size(); i += 3)
+  // Apply padding and scale, coords are [x, y, conf] triplets
+  for (size_t i = 0; i < coords.size(); i += 3)
   {
-    scaledCoords[i] /= gain;
-    scaledCoords[i + 1] /= gain;
+    coords[i] = static_cast<float>((coords[i] - pad.x) / gain);
+    coords[i + 1] = static_cast<float>((coords[i + 1] - pad.y) / gain);
   }
 
-  clip_coords(scaledCoords, img0_shape);
-  return coords;
+  clip_coords(coords, img0_shape);
 }
 
 cv::Mat crop_mask(const cv::Mat& mask, const cv::Rect& box)
@@ -247,9 +244,95 @@ non_max_suppression(const cv::Mat& output0,
     nms_class_ids.push_back(class_ids[idx]);
     nms_confidences.push_back(confidences[idx]);
     nms_boxes.push_back(boxes[idx]);
-    nms_rest.push_back(rest[idx]);
+    if (rest_features > 0)
+      nms_rest.push_back(rest[idx]);
   }
   return std::make_tuple(nms_boxes, nms_confidences, nms_class_ids, nms_rest);
 }
 
+DecodeCandidatesFn select_decoder(int num_classes)
+{
+  // single class (pose, custom detectors), two class and COCO heads. Every other class count runs
+  // the same loop with a runtime bound, which still vectorizes over predictions but cannot unroll
+  // over classes
+  switch (num_classes)
+  {
+  case 1:
+    return &decode_candidates<1>;
+  case 2:
+    return &decode_candidates<2>;
+  case 80:
+    return &decode_candidates<80>;
+  default:
+    return &decode_candidates<0>;
+  }
+}
+
+void nms_boxes(const std::vector<cv::Rect>& boxes,
+               const std::vector<float>& scores,
+               float score_threshold,
+               float iou_threshold,
+               std::vector<int>& order,
+               std::vector<int>& indices)
+{
+  order.clear();
+  indices.clear();
+  for (int i = 0; i < static_cast<int>(scores.size()); ++i)
+  {
+    if (scores[i] > score_threshold)
+      order.push_back(i);
+  }
+  // std::sort with an index tie-break gives the stable order without stable_sort's buffer
+  std::sort(order.begin(),
+            order.end(),
+            [&scores](int a, int b)
+            { return scores[a] > scores[b] || (scores[a] == scores[b] && a < b); });
+
+  for (int idx : order)
+  {
+    const cv::Rect& box = boxes[idx];
+    bool keep = true;
+    for (int kept : indices)
+    {
+      const cv::Rect& other = boxes[kept];
+      float inter = static_cast<float>((box & other).area());
+      float uni = static_cast<float>(box.area() + other.area()) - inter;
+      if (uni > 0.0f && inter / uni > iou_threshold)
+      {
+        keep = false;
+        break;
+      }
+    }
+    if (keep)
+      indices.push_back(idx);
+  }
+}
+
+void parallel_for_largest_first(int count,
+                                const std::function<float(int)>& area,
+                                const std::function<void(int)>& decode)
+{
+  if (count < 2)
+  {
+    for (int i = 0; i < count; ++i)
+      decode(i);
+    return;
+  }
+  std::vector<int> order(count);
+  std::iota(order.begin(), order.end(), 0);
+  std::vector<float> areas(count);
+  for (int i = 0; i < count; ++i)
+    areas[i] = area(i);
+  std::stable_sort(
+      order.begin(), order.end(), [&areas](int a, int b) { return areas[a] > areas[b]; });
+  cv::parallel_for_(
+      cv::Range(0, count),
+      [&](const cv::Range& range)
+      {
+        for (int j = range.start; j < range.end; ++j)
+          decode(order[j]);
+      },
+      count);
+}
+
 } // namespace yolov8_onnxruntime
\ No newline at end of file
@@ -0,0 +1,183 @@
+#include "yolov8_onnxruntime/utils/profiling.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+#include "yolov8_onnxruntime/utils/json.h"
+
+namespace yolov8_onnxruntime
+{
+
+namespace
+{
+
+const std::string KERNEL_TIME_SUFFIX = "_kernel_time";
+
+class EntryTable
+{
+public:
+  ProfileEntry& at(const std::string& name)
+  {
+    auto found = index_.find(name);
+    if (found != index_.end())
+      return entries_[found->second];
+    index_.emplace(name, entries_.size());
+    entries_.emplace_back();
+    entries_.back().name = name;
+    return entries_.back();
+  }
+
+  std::vector<ProfileEntry> ranked(double node_total_us)
+  {
+    for (ProfileEntry& entry : entries_)
+      entry.share = node_total_us > 0.0 ? entry.total_us / node_total_us : 0.0;
+    std::sort(entries_.begin(),
+              entries_.end(),
+              [](const ProfileEntry& a, const ProfileEntry& b) { return a.total_us > b.total_us; });
+    return std::move(entries_);
+  }
+
+private:
+  std::unordered_map<std::string, size_t> index_;
+  std::vector<ProfileEntry> entries_;
+};
+
+void add_provider(ProfileEntry& entry, const std::string& provider)
+{
+  if (entry.provider.empty())
+    entry.provider = provider;
+  else if (("," + entry.provider + ",").find("," + provider + ",") == std::string::npos)
+    entry.provider += "," + provider;
+}
+
+} // namespace
+
+ProfileReport parse_ort_profile(const std::string& path, int skip_runs)
+{
+  std::ifstream file(path, std::ios::binary);
+  if (!file)
+    throw std::runtime_error("Error: cannot read profile " + path);
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+  return parse_ort_profile_text(buffer.str(), skip_runs);
+}
+
+ProfileReport parse_ort_profile_text(const std::string& text, int skip_runs)
+{
+  JsonValue trace = JsonValue::parse(text);
+  if (!trace.isArray())
+    throw std::runtime_error("Error: onnxruntime profile is not an array of events");
+
+  // 1. session runs, in start order
+  std::vector<std::pair<double, double>> runs;
+  for (const JsonValue& event : trace.asArray())
+  {
+    if (event.stringOr("cat", "") == "Session" && event.stringOr("name", "") == "model_run")
+    {
+      double ts = event.numberOr("ts", 0.0);
+      runs.emplace_back(ts, ts + event.numberOr("dur", 0.0));
+    }
+  }
+  std::sort(runs.begin(), runs.end());
+
+  ProfileReport report;
+  report.skipped_runs = std::min(std::max(skip_runs, 0), static_cast<int>(runs.size()));
+  runs.erase(runs.begin(), runs.begin() + report.skipped_runs);
+  report.runs = static_cast<int>(runs.size());
+  for (const std::pair<double, double>& run : runs)
+    report.run_total_us += run.second - run.first;
+
+  auto counted = [&runs](double ts)
+  {
+    // last run starting at or before ts
+    auto it = std::upper_bound(
+        runs.begin(), runs.end(), std::make_pair(ts, std::numeric_limits<double>::max()));
+    return it != runs.begin() && ts <= std::prev(it)->second;
+  };
+
+  // 2. node kernel times of the counted runs
+  EntryTable nodes;
+  EntryTable op_types;
+  EntryTable providers;
+  for (const JsonValue& event : trace.asArray())
+  {
+    const std::string name = event.stringOr("name", "");
+    if (event.stringOr("cat", "") != "Node" || name.size() <= KERNEL_TIME_SUFFIX.size() ||
+        name.compare(name.size() - KERNEL_TIME_SUFFIX.size(),
+                     KERNEL_TIME_SUFFIX.size(),
+                     KERNEL_TIME_SUFFIX) != 0 ||
+        !counted(event.numberOr("ts", 0.0)))
+      continue;
+
+    double dur = event.numberOr("dur", 0.0);
+    const JsonValue* args = event.find("args");
+    std::string op_type = args ? args->stringOr("op_name", "?") : "?";
+    std::string provider = args ? args->stringOr("provider", "?") : "?";
+
+    ProfileEntry& node = nodes.at(name.substr(0, name.size() - KERNEL_TIME_SUFFIX.size()));
+    node.op_type = op_type;
+    node.provider = provider;
+    ProfileEntry& op = op_types.at(op_type);
+    add_provider(op, provider);
+    ProfileEntry& ep = providers.at(provider);
+    for (ProfileEntry* entry : {&node, &op, &ep})
+    {
+      entry->calls += 1;
+      entry->total_us += dur;
+    }
+    report.node_total_us += dur;
+  }
+
+  report.nodes = nodes.ranked(report.node_total_us);
+  report.op_types = op_types.ranked(report.node_total_us);
+  report.providers = providers.ranked(report.node_total_us);
+  return report;
+}
+
+void print_profile_report(std::ostream& os, const ProfileReport& report, size_t top)
+{
+  const double runs = std::max(report.runs, 1);
+  auto per_run_ms = [runs](double us) { return us / runs / 1000.0; };
+  std::ios_base::fmtflags flags = os.flags();
+  os << std::fixed << std::setprecision(3);
+
+  os << "runs: " << report.runs << " (" << report.skipped_runs << " skipped), session run "
+     << report.runMeanMs() << "ms, node kernels " << per_run_ms(report.node_total_us) << "ms";
+  if (report.run_total_us > 0.0)
+  {
+    // what is neither kernel time nor host code: input/output copies, scheduling, fences
+    os << ", session overhead " << per_run_ms(report.run_total_us - report.node_total_us)
+       << "ms";
+  }
+  os << std::endl;
+
+  auto table = [&](const char* title, const std::vector<ProfileEntry>& entries, size_t rows)
+  {
+    os << title << " (ms per run, share, calls per run)" << std::endl;
+    for (size_t i = 0; i < std::min(rows, entries.size()); ++i)
+    {
+      const ProfileEntry& entry = entries[i];
+      os << "  " << std::setw(3) << i + 1 << "  " << std::setw(9) << per_run_ms(entry.total_us)
+         << "  " << std::setprecision(1) << std::setw(5) << entry.share * 100.0 << "%  "
+         << std::setw(5) << entry.calls / runs << std::setprecision(3) << "  " << entry.name;
+      if (!entry.op_type.empty())
+        os << " [" << entry.op_type << "]";
+      if (!entry.provider.empty())
+        os << " " << entry.provider;
+      os << std::endl;
+    }
+  };
+  table("providers", report.providers, report.providers.size());
+  table("op types", report.op_types, report.op_types.size());
+  table("nodes", report.nodes, top);
+  os.flags(flags);
+}
+
+} // namespace yolov8_onnxruntime
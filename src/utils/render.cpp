@@ -0,0 +1,222 @@
+#include "yolov8_onnxruntime/utils/render.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+#include <opencv2/core.hpp>
+#include <opencv2/core/utility.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "yolov8_onnxruntime/utils/viz.h"
+
+namespace yolov8_onnxruntime
+{
+
+Renderer::Renderer(const std::vector<cv::Scalar>& colors,
+                   const std::unordered_map<int, std::string>& names,
+                   const RenderOptions& options) :
+    colors_(colors),
+    names_(names),
+    options_(options)
+{
+  if (colors_.empty())
+    throw std::invalid_argument("Error: Renderer needs at least one class color");
+  if (colors_.size() >= 0xFFFF)
+    throw std::invalid_argument("Error: Renderer supports at most 65534 class colors");
+
+  // blend_lut_[(label * 3 + c) * 256 + v] = v * (1 - alpha) + color[c] * alpha
+  const double alpha = options_.mask_alpha;
+  blend_lut_.resize((colors_.size() + 1) * 3 * 256);
+  for (int v = 0; v < 256; ++v)
+    for (int c = 0; c < 3; ++c)
+      blend_lut_[c * 256 + v] = static_cast<uchar>(v);
+  for (size_t label = 1; label <= colors_.size(); ++label)
+  {
+    for (int c = 0; c < 3; ++c)
+    {
+      uchar* table = blend_lut_.data() + (label * 3 + c) * 256;
+      for (int v = 0; v < 256; ++v)
+        table[v] = cv::saturate_cast<uchar>(v * (1.0 - alpha) + colors_[label - 1][c] * alpha);
+    }
+  }
+}
+
+const cv::Scalar& Renderer::colorOf(int class_idx) const
+{
+  return colors_[static_cast<size_t>(std::max(class_idx, 0)) % colors_.size()];
+}
+
+void Renderer::render(cv::Mat& image, const std::vector<YoloResults>& results)
+{
+  if (image.type() != CV_8UC3)
+    throw std::invalid_argument("Error: Renderer expects an 8-bit 3 channel image");
+
+  compositeMasks(image, results);
+  for (const YoloResults& result : results)
+  {
+    drawBox(image, result);
+    if (!result.keypoints.empty())
+      drawKeypoints(image, result);
+  }
+}
+
+void Renderer::compositeMasks(cv::Mat& image, const std::vector<YoloResults>& results)
+{
+  const cv::Rect frame(0, 0, image.cols, image.rows);
+  // masks are stored cropped to their clipped integer box, see AutoBackendOnnx::_get_mask2
+  std::vector<size_t> masked;
+  cv::Rect region;
+  for (size_t i = 0; i < results.size(); ++i)
+  {
+    const cv::Mat& mask = results[i].mask;
+    if (mask.empty() || mask.type() != CV_8UC1)
+      continue;
+    cv::Rect extent = cv::Rect(cv::Rect(results[i].bbox).tl(), mask.size()) & frame;
+    if (extent.area() == 0)
+      continue;
+    masked.push_back(i);
+    region = region.area() ? (region | extent) : extent;
+  }
+  if (masked.empty())
+    return;
+
+  if (labels_.size() != image.size())
+    labels_.create(image.size(), CV_16UC1);
+
+  const int band_rows = std::max(options_.band_rows, 1);
+  const int bands = (region.height + band_rows - 1) / band_rows;
+  cv::parallel_for_(
+      cv::Range(0, bands),
+      [&](const cv::Range& range)
+      {
+        for (int band = range.start; band < range.end; ++band)
+        {
+          const int y0 = region.y + band * band_rows;
+          const int y1 = std::min(y0 + band_rows, region.y + region.height);
+
+          // 1. label map of this band: later results overwrite earlier ones, like plot_results
+          labels_(cv::Range(y0, y1), cv::Range(region.x, region.x + region.width)).setTo(0);
+          for (size_t i : masked)
+          {
+            const YoloResults& result = results[i];
+            const cv::Point origin = cv::Rect(result.bbox).tl();
+            cv::Rect extent = cv::Rect(origin, result.mask.size()) & frame;
+            const int ys = std::max(extent.y, y0);
+            const int ye = std::min(extent.y + extent.height, y1);
+            const ushort label =
+                static_cast<ushort>(std::max(result.class_idx, 0) % colors_.size() + 1);
+            for (int y = ys; y < ye; ++y)
+            {
+              const uchar* m = result.mask.ptr<uchar>(y - origin.y) + (extent.x - origin.x);
+              ushort* l = labels_.ptr<ushort>(y) + extent.x;
+              for (int x = 0; x < extent.width; ++x)
+              {
+                if (m[x])
+                  l[x] = label;
+              }
+            }
+          }
+
+          // 2. blend the labeled pixels of this band through the class tables
+          const uchar* lut = blend_lut_.data();
+          for (int y = y0; y < y1; ++y)
+          {
+            const ushort* l = labels_.ptr<ushort>(y) + region.x;
+            uchar* px = image.ptr<uchar>(y) + region.x * 3;
+            for (int x = 0; x < region.width; ++x, px += 3)
+            {
+              if (!l[x])
+                continue;
+              const uchar* table = lut + static_cast<size_t>(l[x]) * 3 * 256;
+              px[0] = table[px[0]];
+              px[1] = table[256 + px[1]];
+              px[2] = table[512 + px[2]];
+            }
+          }
+        }
+      },
+      bands);
+}
+
+void Renderer::drawBox(cv::Mat& image, const YoloResults& result) const
+{
+  const cv::Scalar& color = colorOf(result.class_idx);
+  cv::rectangle(image, result.bbox, color, options_.box_thickness);
+  if (!options_.draw_labels)
+    return;
+
+  std::string class_name;
+  auto it = names_.find(result.class_idx);
+  if (it != names_.end())
+    class_name = it->second;
+  else
+    class_name = std::to_string(result.class_idx);
+
+  std::stringstream labelStream;
+  labelStream << class_name << " " << std::fixed << std::setprecision(2) << result.conf;
+  std::string label = labelStream.str();
+
+  const float left = result.bbox.x;
+  const float top = result.bbox.y;
+  cv::Size text_size =
+      cv::getTextSize(label, cv::FONT_HERSHEY_SIMPLEX, options_.font_scale, 2, nullptr);
+  cv::Rect rect_to_fill(
+      left - 1, top - text_size.height - 5, text_size.width + 2, text_size.height + 5);
+  cv::rectangle(image, rect_to_fill, color, -1);
+  cv::putText(image,
+              label,
+              cv::Point(left - 1.5, top - 2.5),
+              cv::FONT_HERSHEY_SIMPLEX,
+              options_.font_scale,
+              cv::Scalar(255.0, 255.0, 255.0),
+              2);
+}
+
+void Renderer::drawKeypoints(cv::Mat& image, const YoloResults& result) const
+{
+  const std::vector<float>& keypoint = result.keypoints;
+  const bool isPose = keypoint.size() == 51;
+  const int num_kpts = static_cast<int>(keypoint.size() / 3);
+  auto visible = [&](int k)
+  {
+    float x = keypoint[k * 3];
+    float y = keypoint[k * 3 + 1];
+    return keypoint[k * 3 + 2] >= options_.kpt_conf && x > 0 && y > 0 && x < image.cols &&
+           y < image.rows;
+  };
+
+  // limbs first so the joints stay on top
+  if (isPose)
+  {
+    for (size_t i = 0; i < skeleton.size(); ++i)
+    {
+      int idx1 = skeleton[i][0] - 1;
+      int idx2 = skeleton[i][1] - 1;
+      if (!visible(idx1) || !visible(idx2))
+        continue;
+      cv::line(image,
+               cv::Point(keypoint[idx1 * 3], keypoint[idx1 * 3 + 1]),
+               cv::Point(keypoint[idx2 * 3], keypoint[idx2 * 3 + 1]),
+               posePalette[limbColorIndices[i]],
+               2,
+               cv::LINE_AA);
+    }
+  }
+  for (int k = 0; k < num_kpts; ++k)
+  {
+    if (!visible(k))
+      continue;
+    cv::Scalar color_k = isPose ? posePalette[kptColorIndices[k]] : cv::Scalar(0, 0, 255);
+    cv::circle(image,
+               cv::Point(keypoint[k * 3], keypoint[k * 3 + 1]),
+               options_.kpt_radius,
+               color_k,
+               -1,
+               cv::LINE_AA);
+  }
+}
+
+} // namespace yolov8_onnxruntime
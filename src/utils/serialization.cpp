@@ -0,0 +1,415 @@
+#include "yolov8_onnxruntime/utils/serialization.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace yolov8_onnxruntime
+{
+
+namespace
+{
+
+// Calls emit(run) for every run of mask in mask_to_rle's order, without buffering them.
+template <typename Emit>
+void for_each_run(const cv::Mat& mask, Emit&& emit)
+{
+  CV_Assert(mask.type() == CV_8UC1);
+  if (mask.empty())
+    return;
+  // a run is stored as uint32, so is the whole mask when it is one run
+  if (mask.total() > std::numeric_limits<uint32_t>::max())
+    throw std::invalid_argument("Error: mask too large for 32-bit run lengths");
+
+  bool foreground = false;
+  uint32_t run = 0;
+  for (int r = 0; r < mask.rows; ++r)
+  {
+    const uchar* row = mask.ptr<uchar>(r);
+    for (int c = 0; c < mask.cols; ++c)
+    {
+      bool value = row[c] != 0;
+      if (value != foreground)
+      {
+        emit(run);
+        run = 0;
+        foreground = value;
+      }
+      ++run;
+    }
+  }
+  emit(run);
+}
+
+} // namespace
+
+std::vector<uint32_t> mask_to_rle(const cv::Mat& mask)
+{
+  std::vector<uint32_t> counts;
+  mask_to_rle(mask, counts);
+  return counts;
+}
+
+void mask_to_rle(const cv::Mat& mask, std::vector<uint32_t>& counts)
+{
+  for_each_run(mask, [&counts](uint32_t run) { counts.push_back(run); });
+}
+
+cv::Mat rle_to_mask(const uint32_t* counts, size_t counts_num, const cv::Size& size)
+{
+  cv::Mat mask = cv::Mat::zeros(size, CV_8UC1);
+  CV_Assert(mask.isContinuous());
+  uchar* data = mask.data;
+  const size_t total = mask.total();
+  size_t pos = 0;
+  for (size_t i = 0; i < counts_num && pos < total; ++i)
+  {
+    size_t run = std::min<size_t>(counts[i], total - pos);
+    // odd runs are foreground
+    if (i % 2 == 1)
+      std::fill(data + pos, data + pos + run, static_cast<uchar>(255));
+    pos += run;
+  }
+  return mask;
+}
+
+std::string json_escape(const std::string& input)
+{
+  std::string output;
+  output.reserve(input.size() + 2);
+  for (char ch : input)
+  {
+    switch (ch)
+    {
+    case '"':
+      output += "\\\"";
+      break;
+    case '\\':
+      output += "\\\\";
+      break;
+    case '\n':
+      output += "\\n";
+      break;
+    case '\r':
+      output += "\\r";
+      break;
+    case '\t':
+      output += "\\t";
+      break;
+    default:
+      if (static_cast<unsigned char>(ch) < 0x20)
+      {
+        char buf[7];
+        std::snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned char>(ch));
+        output += buf;
+      }
+      else
+      {
+        output += ch;
+      }
+    }
+  }
+  return output;
+}
+
+void write_json(std::ostream& os,
+                const YoloResults& result,
+                const std::unordered_map<int, std::string>* names,
+                bool with_mask)
+{
+  // floats round trip exactly, the stream's default 6 digits cut box coordinates of large images
+  const std::streamsize precision = os.precision(std::numeric_limits<float>::max_digits10);
+  os << "{\"class\":" << result.class_idx;
+  if (names != nullptr)
+  {
+    auto it = names->find(result.class_idx);
+    if (it != names->end())
+      os << ",\"name\":\"" << json_escape(it->second) << '"';
+  }
+  os << ",\"conf\":" << result.conf;
+  os << ",\"bbox\":[" << result.bbox.x << ',' << result.bbox.y << ',' << result.bbox.width << ','
+     << result.bbox.height << ']';
+
+  if (!result.keypoints.empty())
+  {
+    os << ",\"keypoints\":[";
+    for (size_t i = 0; i < result.keypoints.size(); ++i)
+    {
+      if (i > 0)
+        os << ',';
+      os << result.keypoints[i];
+    }
+    os << ']';
+  }
+
+  if (with_mask && !result.mask.empty())
+  {
+    os << ",\"mask\":{\"size\":[" << result.mask.rows << ',' << result.mask.cols
+       << "],\"counts\":[";
+    // runs go straight to the stream, no per-mask buffer
+    bool first = true;
+    for_each_run(result.mask,
+                 [&](uint32_t run)
+                 {
+                   if (!first)
+                     os << ',';
+                   os << run;
+                   first = false;
+                 });
+    os << "]}";
+  }
+  os << '}';
+  os.precision(precision);
+}
+
+void write_json(std::ostream& os,
+                const std::vector<YoloResults>& results,
+                const std::unordered_map<int, std::string>* names,
+                bool with_mask)
+{
+  os << '[';
+  for (size_t i = 0; i < results.size(); ++i)
+  {
+    if (i > 0)
+      os << ',';
+    write_json(os, results[i], names, with_mask);
+  }
+  os << ']';
+}
+
+namespace
+{
+
+bool host_is_little_endian()
+{
+  const uint16_t probe = 1;
+  uint8_t first_byte = 0;
+  std::memcpy(&first_byte, &probe, 1);
+  return first_byte == 1;
+}
+
+void check_little_endian()
+{
+  // the format is defined as little-endian and read in place, so big-endian hosts are rejected
+  if (!host_is_little_endian())
+    throw std::runtime_error("Error: binary result format requires a little-endian host");
+}
+
+template <typename T>
+void append(std::vector<char>& buffer, const T* values, size_t num)
+{
+  const char* bytes = reinterpret_cast<const char*>(values);
+  buffer.insert(buffer.end(), bytes, bytes + num * sizeof(T));
+}
+
+template <typename T>
+void append(std::vector<char>& buffer, const T& value)
+{
+  append(buffer, &value, 1);
+}
+
+} // namespace
+
+BinaryResultWriter::BinaryResultWriter(std::ostream& os, bool with_masks) :
+    os_(&os),
+    with_masks_(with_masks)
+{
+  check_little_endian();
+}
+
+BinaryResultWriter::BinaryResultWriter(bool with_masks) : os_(nullptr), with_masks_(with_masks)
+{
+  check_little_endian();
+}
+
+void BinaryResultWriter::write(const std::vector<YoloResults>& results)
+{
+  if (os_ == nullptr)
+    throw std::logic_error("Error: BinaryResultWriter has no output stream");
+  size_t frame_bytes = encode(results, buffer_);
+  os_->write(buffer_.data(), static_cast<std::streamsize>(frame_bytes));
+}
+
+size_t BinaryResultWriter::encode(const std::vector<YoloResults>& results,
+                                  std::vector<char>& buffer)
+{
+  // every count and size of the format is a uint32
+  constexpr size_t max_field = std::numeric_limits<uint32_t>::max();
+  if (results.size() > max_field)
+    throw std::invalid_argument("Error: too many results for one binary frame");
+  const uint32_t count = static_cast<uint32_t>(results.size());
+  const uint32_t keypoint_values =
+      results.empty() ? 0 : static_cast<uint32_t>(results.front().keypoints.size());
+  bool has_masks = false;
+  for (const YoloResults& result : results)
+  {
+    if (result.keypoints.size() != keypoint_values)
+      throw std::invalid_argument("Error: all results of a frame need the same keypoint count");
+    has_masks |= with_masks_ && !result.mask.empty();
+  }
+
+  // run-length encode all masks first, the header needs the total count
+  mask_offsets_.clear();
+  mask_counts_.clear();
+  if (has_masks)
+  {
+    for (const YoloResults& result : results)
+    {
+      mask_offsets_.push_back(static_cast<uint32_t>(mask_counts_.size()));
+      // appended in place, the scratch vector is reused across frames
+      mask_to_rle(result.mask, mask_counts_);
+      if (mask_counts_.size() > max_field)
+        throw std::invalid_argument("Error: too many mask runs for one binary frame");
+    }
+    mask_offsets_.push_back(static_cast<uint32_t>(mask_counts_.size()));
+  }
+
+  BinaryFrameHeader header{};
+  header.magic = BinaryResultFormat::MAGIC;
+  header.version = BinaryResultFormat::VERSION;
+  header.flags = static_cast<uint16_t>(
+      (keypoint_values > 0 ? BinaryResultFormat::FLAG_KEYPOINTS : 0) |
+      (has_masks ? BinaryResultFormat::FLAG_MASKS : 0));
+  header.count = count;
+  header.keypoint_values = keypoint_values;
+  header.mask_counts_num = static_cast<uint32_t>(mask_counts_.size());
+
+  uint64_t payload = static_cast<uint64_t>(count) * (4 + 1 + 1 + keypoint_values) * 4;
+  if (has_masks)
+    payload += (static_cast<uint64_t>(count) * 3 + 1 + mask_counts_.size()) * 4;
+  if (payload > max_field)
+    throw std::invalid_argument("Error: binary frame larger than 4 GiB");
+  header.payload_bytes = static_cast<uint32_t>(payload);
+
+  buffer.clear();
+  buffer.reserve(sizeof(BinaryFrameHeader) + payload);
+  append(buffer, header);
+  for (const YoloResults& result : results)
+  {
+    const float box[4] = {result.bbox.x, result.bbox.y, result.bbox.width, result.bbox.height};
+    append(buffer, box, 4);
+  }
+  for (const YoloResults& result : results)
+    append(buffer, result.conf);
+  for (const YoloResults& result : results)
+    append(buffer, static_cast<int32_t>(result.class_idx));
+  if (keypoint_values > 0)
+  {
+    for (const YoloResults& result : results)
+      append(buffer, result.keypoints.data(), keypoint_values);
+  }
+  if (has_masks)
+  {
+    for (const YoloResults& result : results)
+    {
+      const uint32_t dims[2] = {static_cast<uint32_t>(result.mask.rows),
+                                static_cast<uint32_t>(result.mask.cols)};
+      append(buffer, dims, 2);
+    }
+    append(buffer, mask_offsets_.data(), mask_offsets_.size());
+    append(buffer, mask_counts_.data(), mask_counts_.size());
+  }
+  return buffer.size();
+}
+
+BinaryResultView::BinaryResultView(const void* data, size_t size)
+{
+  check_little_endian();
+  if (reinterpret_cast<uintptr_t>(data) % alignof(uint32_t) != 0)
+    throw std::runtime_error("Error: binary result frame is not 4-byte aligned");
+  if (size < sizeof(BinaryFrameHeader))
+    throw std::runtime_error("Error: binary result frame is truncated");
+
+  header_ = static_cast<const BinaryFrameHeader*>(data);
+  if (header_->magic != BinaryResultFormat::MAGIC)
+    throw std::runtime_error("Error: not a binary result frame");
+  if (header_->version != BinaryResultFormat::VERSION)
+    throw std::runtime_error("Error: unsupported binary result version " +
+                             std::to_string(header_->version));
+  if (size < frameBytes())
+    throw std::runtime_error("Error: binary result frame is truncated");
+
+  const uint64_t count = header_->count;
+  const bool has_keypoints = header_->flags & BinaryResultFormat::FLAG_KEYPOINTS;
+  const bool has_masks = header_->flags & BinaryResultFormat::FLAG_MASKS;
+  uint64_t expected = count * (4 + 1 + 1) * 4;
+  if (has_keypoints)
+    expected += count * header_->keypoint_values * 4;
+  if (has_masks)
+    expected += (count * 3 + 1 + header_->mask_counts_num) * 4;
+  if (expected != header_->payload_bytes)
+    throw std::runtime_error("Error: binary result frame sizes are inconsistent");
+
+  const char* cursor = static_cast<const char*>(data) + sizeof(BinaryFrameHeader);
+  boxes_ = reinterpret_cast<const float*>(cursor);
+  cursor += count * 4 * sizeof(float);
+  scores_ = reinterpret_cast<const float*>(cursor);
+  cursor += count * sizeof(float);
+  classes_ = reinterpret_cast<const int32_t*>(cursor);
+  cursor += count * sizeof(int32_t);
+  if (has_keypoints)
+  {
+    keypoints_ = reinterpret_cast<const float*>(cursor);
+    cursor += count * header_->keypoint_values * sizeof(float);
+  }
+  if (has_masks)
+  {
+    mask_dims_ = reinterpret_cast<const uint32_t*>(cursor);
+    cursor += count * 2 * sizeof(uint32_t);
+    mask_offsets_ = reinterpret_cast<const uint32_t*>(cursor);
+    cursor += (count + 1) * sizeof(uint32_t);
+    mask_counts_ = reinterpret_cast<const uint32_t*>(cursor);
+
+    for (uint64_t i = 0; i < count; ++i)
+    {
+      if (mask_offsets_[i] > mask_offsets_[i + 1] ||
+          mask_offsets_[i + 1] > header_->mask_counts_num)
+        throw std::runtime_error("Error: binary result mask offsets are out of range");
+    }
+  }
+}
+
+cv::Size BinaryResultView::maskSize(size_t i) const
+{
+  if (mask_dims_ == nullptr)
+    return {};
+  return {static_cast<int>(mask_dims_[2 * i + 1]), static_cast<int>(mask_dims_[2 * i])};
+}
+
+const uint32_t* BinaryResultView::maskCounts(size_t i, size_t& counts_num) const
+{
+  if (mask_dims_ == nullptr)
+  {
+    counts_num = 0;
+    return nullptr;
+  }
+  counts_num = mask_offsets_[i + 1] - mask_offsets_[i];
+  return mask_counts_ + mask_offsets_[i];
+}
+
+std::vector<YoloResults> BinaryResultView::toResults() const
+{
+  std::vector<YoloResults> results(count());
+  for (size_t i = 0; i < results.size(); ++i)
+  {
+    YoloResults& result = results[i];
+    result.class_idx = classes_[i];
+    result.conf = scores_[i];
+    result.bbox = bbox(i);
+    if (keypoints_ != nullptr)
+    {
+      const float* kpt = keypoints_ + i * keypointValues();
+      result.keypoints.assign(kpt, kpt + keypointValues());
+    }
+    size_t counts_num = 0;
+    const uint32_t* counts = maskCounts(i, counts_num);
+    cv::Size mask_size = maskSize(i);
+    if (counts_num > 0 && mask_size.area() > 0)
+      result.mask = rle_to_mask(counts, counts_num, mask_size);
+  }
+  return results;
+}
+
+} // namespace yolov8_onnxruntime
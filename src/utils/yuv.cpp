@@ -0,0 +1,164 @@
+#include "yolov8_onnxruntime/utils/yuv.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+namespace yolov8_onnxruntime
+{
+
+namespace
+{
+
+// cv::cvtColor has no full range conversion, this is the fused preprocess's without resampling
+void convert_full_range(const YuvImage& image, cv::Mat& out, bool rgb)
+{
+  out.create(image.size, CV_8UC3);
+  const YuvToRgb convert(true, 1.0f);
+  // 4:2:0 formats share one chroma row between two luma rows, YUYV carries chroma in every row
+  const int chroma_shift = image.format == YuvFormat_t::YUYV ? 0 : 1;
+  const int chroma_plane = image.format == YuvFormat_t::YUYV ? 0 : 1;
+  cv::parallel_for_(
+      cv::Range(0, image.size.height),
+      [&](const cv::Range& range)
+      {
+        for (int y = range.start; y < range.end; ++y)
+        {
+          const uchar* luma = image.planes[0] + static_cast<size_t>(y) * image.strides[0];
+          const int cy = y >> chroma_shift;
+          const uchar* c0 =
+              image.planes[chroma_plane] + static_cast<size_t>(cy) * image.strides[chroma_plane];
+          const uchar* c1 = image.format == YuvFormat_t::I420
+                                ? image.planes[2] + static_cast<size_t>(cy) * image.strides[2]
+                                : nullptr;
+          uchar* dst = out.ptr<uchar>(y);
+          for (int x = 0; x < image.size.width; ++x, dst += 3)
+          {
+            const int cx = x >> 1;
+            float l = luma[x];
+            float u;
+            float v;
+            switch (image.format)
+            {
+            case YuvFormat_t::NV12:
+              u = c0[2 * cx];
+              v = c0[2 * cx + 1];
+              break;
+            case YuvFormat_t::NV21:
+              v = c0[2 * cx];
+              u = c0[2 * cx + 1];
+              break;
+            case YuvFormat_t::I420:
+              u = c0[cx];
+              v = c1[cx];
+              break;
+            default:
+              l = luma[2 * x];
+              u = c0[4 * cx + 1];
+              v = c0[4 * cx + 3];
+              break;
+            }
+            float r;
+            float g;
+            float b;
+            convert(l, u, v, r, g, b);
+            dst[rgb ? 0 : 2] = cv::saturate_cast<uchar>(r);
+            dst[1] = cv::saturate_cast<uchar>(g);
+            dst[rgb ? 2 : 0] = cv::saturate_cast<uchar>(b);
+          }
+        }
+      });
+}
+
+} // namespace
+
+bool YuvImage::valid() const
+{
+  if (size.empty() || !planes[0] || strides[0] <= 0)
+    return false;
+  switch (format)
+  {
+  case YuvFormat_t::NV12:
+  case YuvFormat_t::NV21:
+    return planes[1] && strides[0] >= size.width && strides[1] >= size.width &&
+           size.width % 2 == 0 && size.height % 2 == 0;
+  case YuvFormat_t::I420:
+    return planes[1] && planes[2] && strides[0] >= size.width && strides[1] >= size.width / 2 &&
+           strides[2] >= size.width / 2 && size.width % 2 == 0 && size.height % 2 == 0;
+  case YuvFormat_t::YUYV:
+    return strides[0] >= 2 * size.width && size.width % 2 == 0;
+  }
+  return false;
+}
+
+void convert_yuv(const YuvImage& image, cv::Mat& out, bool rgb)
+{
+  if (!image.valid())
+    throw std::invalid_argument("Error: invalid YUV image");
+  if (image.full_range)
+  {
+    convert_full_range(image, out, rgb);
+    return;
+  }
+
+  // cv::cvtColor takes limited range BT.601, as the fused preprocess does by default
+  const int width = image.size.width;
+  const int height = image.size.height;
+  switch (image.format)
+  {
+  case YuvFormat_t::NV12:
+  case YuvFormat_t::NV21:
+  {
+    cv::Mat y(image.size, CV_8UC1, const_cast<uchar*>(image.planes[0]), image.strides[0]);
+    cv::Mat uv(
+        height / 2, width / 2, CV_8UC2, const_cast<uchar*>(image.planes[1]), image.strides[1]);
+    int code = image.format == YuvFormat_t::NV12
+                   ? (rgb ? cv::COLOR_YUV2RGB_NV12 : cv::COLOR_YUV2BGR_NV12)
+                   : (rgb ? cv::COLOR_YUV2RGB_NV21 : cv::COLOR_YUV2BGR_NV21);
+    cv::cvtColorTwoPlane(y, uv, out, code);
+    return;
+  }
+  case YuvFormat_t::I420:
+  {
+    // cvtColor wants the three planes stacked without padding, copy them together otherwise
+    const size_t luma = static_cast<size_t>(width) * height;
+    const size_t chroma = luma / 4;
+    const bool packed = image.strides[0] == width && image.strides[1] == width / 2 &&
+                        image.strides[2] == width / 2 &&
+                        image.planes[1] == image.planes[0] + luma &&
+                        image.planes[2] == image.planes[1] + chroma;
+    cv::Mat stacked;
+    if (packed)
+    {
+      stacked = cv::Mat(height * 3 / 2, width, CV_8UC1, const_cast<uchar*>(image.planes[0]));
+    }
+    else
+    {
+      stacked.create(height * 3 / 2, width, CV_8UC1);
+      uchar* dst = stacked.data;
+      for (int r = 0; r < height; ++r, dst += width)
+        std::memcpy(dst, image.planes[0] + static_cast<size_t>(r) * image.strides[0], width);
+      for (int p = 1; p < 3; ++p)
+      {
+        for (int r = 0; r < height / 2; ++r, dst += width / 2)
+        {
+          std::memcpy(
+              dst, image.planes[p] + static_cast<size_t>(r) * image.strides[p], width / 2);
+        }
+      }
+    }
+    cv::cvtColor(stacked, out, rgb ? cv::COLOR_YUV2RGB_I420 : cv::COLOR_YUV2BGR_I420);
+    return;
+  }
+  case YuvFormat_t::YUYV:
+  {
+    cv::Mat packed(image.size, CV_8UC2, const_cast<uchar*>(image.planes[0]), image.strides[0]);
+    cv::cvtColor(packed, out, rgb ? cv::COLOR_YUV2RGB_YUY2 : cv::COLOR_YUV2BGR_YUY2);
+    return;
+  }
+  }
+}
+
+} // namespace yolov8_onnxruntime
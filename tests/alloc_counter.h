@@ -0,0 +1,87 @@
+#ifndef YOLOV8_ONNXRUNTIME_TESTS_ALLOC_COUNTER_H
+#define YOLOV8_ONNXRUNTIME_TESTS_ALLOC_COUNTER_H
+// Counts the heap allocations of the whole process by interposing malloc and friends, which also
+// catches cv::fastMalloc and the allocations of onnxruntime's worker threads. Used by
+// test_allocations and alloc_probe.
+//
+// The header defines the allocation functions themselves, so exactly one translation unit of an
+// executable includes it. Interposing needs glibc's __libc_* entry points: YO_COUNTS_ALLOCATIONS
+// is 1 where they exist, elsewhere it is 0 and the includer reports itself skipped.
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+
+#if defined(__GLIBC__)
+#define YO_COUNTS_ALLOCATIONS 1
+
+extern "C"
+{
+  void* __libc_malloc(size_t size);
+  void* __libc_calloc(size_t count, size_t size);
+  void* __libc_realloc(void* ptr, size_t size);
+  void* __libc_memalign(size_t alignment, size_t size);
+}
+
+namespace yolov8_onnxruntime
+{
+namespace test
+{
+
+inline std::atomic<size_t> allocations{0};
+
+/// Allocations made since construction.
+struct AllocationScope
+{
+  size_t start = allocations.load();
+  size_t count() const { return allocations.load() - start; }
+};
+
+} // namespace test
+} // namespace yolov8_onnxruntime
+
+extern "C"
+{
+
+  void* malloc(size_t size)
+  {
+    yolov8_onnxruntime::test::allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+  }
+
+  void* calloc(size_t count, size_t size)
+  {
+    yolov8_onnxruntime::test::allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+  }
+
+  void* realloc(void* ptr, size_t size)
+  {
+    yolov8_onnxruntime::test::allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+  }
+
+  int posix_memalign(void** ptr, size_t alignment, size_t size)
+  {
+    yolov8_onnxruntime::test::allocations.fetch_add(1, std::memory_order_relaxed);
+    *ptr = __libc_memalign(alignment, size);
+    return *ptr ? 0 : 12; // ENOMEM
+  }
+
+  void* aligned_alloc(size_t alignment, size_t size)
+  {
+    yolov8_onnxruntime::test::allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_memalign(alignment, size);
+  }
+
+  void* memalign(size_t alignment, size_t size)
+  {
+    yolov8_onnxruntime::test::allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_memalign(alignment, size);
+  }
+}
+
+#else
+#define YO_COUNTS_ALLOCATIONS 0
+#endif
+
+#endif // YOLOV8_ONNXRUNTIME_TESTS_ALLOC_COUNTER_H
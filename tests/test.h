@@ -0,0 +1,118 @@
+#ifndef YOLOV8_ONNXRUNTIME_TESTS_TEST_H
+#define YOLOV8_ONNXRUNTIME_TESTS_TEST_H
+#include <cmath>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace yolov8_onnxruntime
+{
+namespace test
+{
+
+/// Exit status of a test missing an external asset (a model, an image), ctest reports it skipped.
+constexpr int SKIPPED = 77;
+
+struct Case
+{
+  std::string name;
+  std::function<void()> fn;
+};
+
+inline std::vector<Case>& cases()
+{
+  static std::vector<Case> all;
+  return all;
+}
+
+inline int& failures()
+{
+  static int count = 0;
+  return count;
+}
+
+struct Registration
+{
+  Registration(const char* name, std::function<void()> fn)
+  {
+    cases().push_back({name, std::move(fn)});
+  }
+};
+
+inline void fail(const char* file, int line, const std::string& what)
+{
+  std::cerr << file << ":" << line << ": " << what << std::endl;
+  ++failures();
+}
+
+/// Runs every TEST_CASE of the executable, returns its exit status.
+inline int run_all()
+{
+  for (const Case& test_case : cases())
+  {
+    const int before = failures();
+    try
+    {
+      test_case.fn();
+    }
+    catch (const std::exception& e)
+    {
+      fail(test_case.name.c_str(), 0, std::string("unexpected exception: ") + e.what());
+    }
+    std::cout << (failures() == before ? "[pass] " : "[FAIL] ") << test_case.name << std::endl;
+  }
+  return failures() == 0 ? 0 : 1;
+}
+
+} // namespace test
+} // namespace yolov8_onnxruntime
+
+#define TEST_CASE(name)                                                                           \
+  static void name();                                                                             \
+  static const yolov8_onnxruntime::test::Registration name##_registration(#name, name);           \
+  static void name()
+
+#define CHECK(condition)                                                                          \
+  do                                                                                              \
+  {                                                                                               \
+    if (!(condition))                                                                             \
+      yolov8_onnxruntime::test::fail(__FILE__, __LINE__, "CHECK(" #condition ") failed");         \
+  } while (false)
+
+#define CHECK_NEAR(actual, expected, tolerance)                                                   \
+  do                                                                                              \
+  {                                                                                               \
+    const double actual_value = (actual);                                                         \
+    const double expected_value = (expected);                                                     \
+    if (!(std::abs(actual_value - expected_value) <= (tolerance)))                                \
+    {                                                                                             \
+      yolov8_onnxruntime::test::fail(__FILE__,                                                    \
+                                     __LINE__,                                                    \
+                                     #actual " is " + std::to_string(actual_value) +              \
+                                         ", expected " + std::to_string(expected_value));         \
+    }                                                                                             \
+  } while (false)
+
+#define CHECK_THROWS(expression, exception)                                                       \
+  do                                                                                              \
+  {                                                                                               \
+    bool thrown = false;                                                                          \
+    try                                                                                           \
+    {                                                                                             \
+      expression;                                                                                 \
+    }                                                                                             \
+    catch (const exception&)                                                                      \
+    {                                                                                             \
+      thrown = true;                                                                              \
+    }                                                                                             \
+    if (!thrown)                                                                                  \
+    {                                                                                             \
+      yolov8_onnxruntime::test::fail(                                                             \
+          __FILE__, __LINE__, #expression " did not throw " #exception);                          \
+    }                                                                                             \
+  } while (false)
+
+#endif // YOLOV8_ONNXRUNTIME_TESTS_TEST_H
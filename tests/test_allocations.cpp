@@ -0,0 +1,125 @@
+// Counts heap allocations of the preprocess and postprocess stages on a workspace that already
+// saw its frame, which have to stay at zero (see InferenceWorkspace). The session run is not part
+// of it, alloc_probe measures whole predictions on a real model.
+//
+// Allocations are counted with alloc_counter.h, which needs glibc; elsewhere the test reports
+// itself skipped.
+#include <random>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <opencv2/core/utility.hpp>
+
+#include <yolov8_onnxruntime/nn/workspace.h>
+#include <yolov8_onnxruntime/utils/ops.h>
+#include <yolov8_onnxruntime/utils/serialization.h>
+
+#include "alloc_counter.h"
+#include "test.h"
+
+namespace yo = yolov8_onnxruntime;
+
+#if YO_COUNTS_ALLOCATIONS
+
+using yo::test::AllocationScope;
+
+namespace
+{
+
+constexpr int NUM_CLASSES = 80;
+constexpr int NUM_PREDS = 8400;
+
+// a channel-major [4 + NUM_CLASSES, NUM_PREDS] head with count confident, scattered predictions
+std::vector<float> make_head(int count)
+{
+  std::mt19937 gen(3);
+  std::uniform_real_distribution<float> center(32.0f, 608.0f);
+  std::uniform_real_distribution<float> extent(8.0f, 96.0f);
+  std::uniform_real_distribution<float> low(0.0f, 0.1f);
+  std::uniform_real_distribution<float> high(0.4f, 0.95f);
+  std::uniform_int_distribution<int> cls(0, NUM_CLASSES - 1);
+  std::vector<float> head(static_cast<size_t>(4 + NUM_CLASSES) * NUM_PREDS);
+  for (int p = 0; p < NUM_PREDS; ++p)
+  {
+    head[p] = center(gen);
+    head[NUM_PREDS + p] = center(gen);
+    head[2 * NUM_PREDS + p] = extent(gen);
+    head[3 * NUM_PREDS + p] = extent(gen);
+    for (int c = 0; c < NUM_CLASSES; ++c)
+      head[static_cast<size_t>(4 + c) * NUM_PREDS + p] = low(gen);
+    if (p % (NUM_PREDS / count) == 0)
+      head[static_cast<size_t>(4 + cls(gen)) * NUM_PREDS + p] = high(gen);
+  }
+  return head;
+}
+
+} // namespace
+
+TEST_CASE(steady_state_preprocess_and_postprocess_do_not_allocate)
+{
+  cv::Mat frame(1080, 1920, CV_8UC3);
+  cv::randu(frame, cv::Scalar::all(0), cv::Scalar::all(256));
+  const cv::Size input_size(640, 640);
+  const std::vector<float> head = make_head(120);
+  const yo::DecodeCandidatesFn decode = yo::select_decoder(NUM_CLASSES);
+  yo::InferenceWorkspace workspace;
+
+  // the stages of AutoBackendOnnx::predict around the session run, for a detection model
+  auto predict_stages = [&]()
+  {
+    workspace.reset();
+    const yo::LetterboxTransform& transform =
+        workspace.letterboxTransform(frame.size(), input_size);
+    workspace.input.resize(static_cast<size_t>(input_size.area()) * 3);
+    transform.applyChw(frame, workspace.input.data(), true);
+
+    decode(head.data(), NUM_CLASSES, 0, NUM_PREDS, 0.25f, workspace.candidates);
+    for (const cv::Rect_<float>& box : workspace.candidates.boxes)
+      workspace.boxes.push_back(transform.toSource(box));
+    yo::nms_boxes(workspace.boxes,
+                  workspace.candidates.confidences,
+                  0.25f,
+                  0.45f,
+                  workspace.nms_order,
+                  workspace.nms_keep);
+  };
+
+  // OpenCV's thread pool allocates a job per parallel_for_ call, that is the scheduler's cost
+  // and not the pipeline's, so the stripes run on this thread here
+  cv::setNumThreads(1);
+  predict_stages(); // sizes every buffer
+  AllocationScope scope;
+  for (int i = 0; i < 5; ++i)
+    predict_stages();
+  const size_t count = scope.count();
+  CHECK(count == 0);
+  CHECK(!workspace.nms_keep.empty());
+}
+
+TEST_CASE(binary_encoding_reuses_its_buffers)
+{
+  std::vector<yo::YoloResults> results(50);
+  for (size_t i = 0; i < results.size(); ++i)
+  {
+    results[i].bbox = cv::Rect_<float>(static_cast<float>(i), 0.0f, 40.0f, 30.0f);
+    results[i].mask = cv::Mat::zeros(30, 40, CV_8UC1);
+    results[i].mask(cv::Rect(static_cast<int>(i % 20), 5, 12, 12)).setTo(255);
+  }
+  yo::BinaryResultWriter writer;
+  std::vector<char> frame;
+  writer.encode(results, frame);
+
+  AllocationScope scope;
+  for (int i = 0; i < 5; ++i)
+    writer.encode(results, frame);
+  const size_t count = scope.count();
+  CHECK(count == 0);
+}
+
+int main() { return yo::test::run_all(); }
+
+#else
+
+int main() { return yo::test::SKIPPED; }
+
+#endif
@@ -0,0 +1,130 @@
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <opencv2/core/utility.hpp>
+
+#include <yolov8_onnxruntime/nn/detection_sink.h>
+
+#include "test.h"
+
+namespace yo = yolov8_onnxruntime;
+
+static_assert(std::is_move_constructible_v<yo::StreamedDetection> &&
+                  std::is_move_assignable_v<yo::StreamedDetection>,
+              "detections are handed around in vectors");
+static_assert(!std::is_copy_constructible_v<yo::StreamedDetection> &&
+                  !std::is_copy_assignable_v<yo::StreamedDetection>,
+              "a copy would decode its mask again");
+
+namespace
+{
+
+// stands in for the decoders predict_stream() builds over the session outputs: fills the mask
+// with value and counts its calls
+struct FakeDecoder
+{
+  int* calls;
+  uchar value;
+
+  void operator()(cv::Mat& mask) const
+  {
+    ++*calls;
+    mask = cv::Mat(4, 6, CV_8UC1, cv::Scalar(value));
+  }
+};
+
+yo::StreamedDetection make_detection(float width, int* calls, uchar value)
+{
+  yo::YoloResults result{0, 0.9f, cv::Rect_<float>(0.0f, 0.0f, width, 10.0f)};
+  return yo::StreamedDetection(result, FakeDecoder{calls, value});
+}
+
+} // namespace
+
+TEST_CASE(masks_are_decoded_on_first_access_only)
+{
+  int calls = 0;
+  yo::StreamedDetection detection = make_detection(20.0f, &calls, 255);
+  CHECK(detection.hasMask());
+  CHECK(detection.result().mask.empty());
+  CHECK(calls == 0);
+
+  const cv::Mat& mask = detection.mask();
+  CHECK(calls == 1);
+  CHECK(mask.size() == cv::Size(6, 4) && mask.at<uchar>(0, 0) == 255);
+  detection.mask();
+  CHECK(calls == 1);
+  CHECK(!detection.result().mask.empty());
+
+  yo::YoloResults taken = detection.take();
+  CHECK(taken.mask.size() == cv::Size(6, 4));
+  CHECK(calls == 1);
+}
+
+TEST_CASE(detections_without_a_decoder_have_no_mask)
+{
+  yo::StreamedDetection detection(yo::YoloResults{1, 0.5f, cv::Rect_<float>(0, 0, 4, 4)}, {});
+  CHECK(!detection.hasMask());
+  CHECK(detection.mask().empty());
+}
+
+TEST_CASE(moved_detections_do_not_decode_again)
+{
+  int calls = 0;
+  yo::StreamedDetection detection = make_detection(20.0f, &calls, 7);
+  detection.mask();
+  std::vector<yo::StreamedDetection> kept;
+  kept.push_back(std::move(detection));
+  CHECK(kept[0].mask().at<uchar>(0, 0) == 7);
+  CHECK(calls == 1);
+
+  // nothing decoded before the move: the decoder moves along and runs once
+  int later_calls = 0;
+  yo::StreamedDetection pending = make_detection(20.0f, &later_calls, 9);
+  kept.push_back(std::move(pending));
+  CHECK(later_calls == 0);
+  CHECK(kept[1].mask().at<uchar>(0, 0) == 9);
+  kept[1].mask();
+  CHECK(later_calls == 1);
+}
+
+TEST_CASE(decode_masks_decodes_each_listed_detection_once_largest_first)
+{
+  const std::vector<float> widths = {10.0f, 40.0f, 20.0f, 40.0f, 30.0f};
+  std::vector<int> calls(widths.size(), 0);
+  std::mutex order_mutex;
+  std::vector<size_t> order;
+  std::vector<yo::StreamedDetection> detections;
+  for (size_t i = 0; i < widths.size(); ++i)
+  {
+    yo::YoloResults result{0, 0.9f, cv::Rect_<float>(0.0f, 0.0f, widths[i], 10.0f)};
+    int* counter = &calls[i];
+    detections.emplace_back(result,
+                            [counter, i, &order, &order_mutex](cv::Mat& mask)
+                            {
+                              ++*counter;
+                              std::lock_guard<std::mutex> lock(order_mutex);
+                              order.push_back(i);
+                              mask = cv::Mat::zeros(2, 2, CV_8UC1);
+                            });
+  }
+  // one was already looked at by the sink, the last one is left out
+  detections[2].mask();
+  order.clear();
+
+  // on one thread the stripes run in schedule order
+  const int threads = cv::getNumThreads();
+  cv::setNumThreads(1);
+  yo::StreamedDetection::decodeMasks(
+      {&detections[0], &detections[1], &detections[2], &detections[3]});
+  cv::setNumThreads(threads);
+
+  CHECK((calls == std::vector<int>{1, 1, 1, 1, 0}));
+  CHECK((order == std::vector<size_t>{1, 3, 0}));
+  CHECK(detections[4].result().mask.empty());
+}
+
+int main() { return yo::test::run_all(); }
@@ -0,0 +1,68 @@
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <yolov8_onnxruntime/utils/json.h>
+
+#include "test.h"
+
+namespace yo = yolov8_onnxruntime;
+
+TEST_CASE(parses_nested_documents)
+{
+  yo::JsonValue doc = yo::JsonValue::parse(
+      R"({"name": "bus", "size": [1080, 810], "score": -2.5e-1, "ok": true, "none": null,
+          "nested": {"empty": [], "object": {}}})");
+  CHECK(doc.isObject());
+  CHECK(doc.stringOr("name", "") == "bus");
+  CHECK(doc.find("size") != nullptr && doc.find("size")->asArray().size() == 2);
+  CHECK_NEAR(doc.find("size")->asArray()[1].asNumber(), 810.0, 0.0);
+  CHECK_NEAR(doc.numberOr("score", 0.0), -0.25, 0.0);
+  CHECK(doc.find("ok")->asBool());
+  CHECK(doc.find("none")->isNull());
+  CHECK(doc.find("nested")->find("empty")->asArray().empty());
+  CHECK(doc.find("nested")->find("object")->isObject());
+}
+
+TEST_CASE(keeps_keys_in_document_order)
+{
+  yo::JsonValue doc = yo::JsonValue::parse(R"({"b": 1, "a": 2, "c": 3})");
+  CHECK((doc.keys() == std::vector<std::string>{"b", "a", "c"}));
+  CHECK_NEAR(doc.asArray()[1].asNumber(), 2.0, 0.0);
+}
+
+TEST_CASE(decodes_string_escapes)
+{
+  yo::JsonValue doc = yo::JsonValue::parse(R"(["a\"b\\c\n", "\u0041\u00e9", "\ud83d\ude00"])");
+  CHECK(doc.asArray()[0].asString() == "a\"b\\c\n");
+  CHECK(doc.asArray()[1].asString() == "A\xc3\xa9");
+  CHECK(doc.asArray()[2].asString() == "\xf0\x9f\x98\x80");
+}
+
+TEST_CASE(falls_back_on_missing_or_mistyped_members)
+{
+  yo::JsonValue doc = yo::JsonValue::parse(R"({"conf": "high", "iou": 0.5})");
+  CHECK(doc.find("missing") == nullptr);
+  CHECK_NEAR(doc.numberOr("conf", 0.25), 0.25, 0.0);
+  CHECK_NEAR(doc.numberOr("iou", 0.0), 0.5, 0.0);
+  CHECK(doc.stringOr("iou", "none") == "none");
+  // find() on a non-object is a miss, not an error
+  CHECK(doc.find("iou")->find("anything") == nullptr);
+}
+
+TEST_CASE(rejects_malformed_input_and_type_mismatches)
+{
+  CHECK_THROWS(yo::JsonValue::parse(""), std::runtime_error);
+  CHECK_THROWS(yo::JsonValue::parse("[1, 2"), std::runtime_error);
+  CHECK_THROWS(yo::JsonValue::parse(R"({"a": })"), std::runtime_error);
+  CHECK_THROWS(yo::JsonValue::parse(R"({a: 1})"), std::runtime_error);
+  CHECK_THROWS(yo::JsonValue::parse(R"("unterminated)"), std::runtime_error);
+  CHECK_THROWS(yo::JsonValue::parse("1 2"), std::runtime_error);
+
+  yo::JsonValue number = yo::JsonValue::parse("3");
+  CHECK_THROWS(number.asArray(), std::runtime_error);
+  CHECK_THROWS(number.asString(), std::runtime_error);
+  CHECK_THROWS(number.keys(), std::runtime_error);
+}
+
+int main() { return yo::test::run_all(); }
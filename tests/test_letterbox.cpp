@@ -0,0 +1,158 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <yolov8_onnxruntime/utils/augment.h>
+#include <yolov8_onnxruntime/utils/letterbox.h>
+
+#include "test.h"
+
+namespace yo = yolov8_onnxruntime;
+
+namespace
+{
+
+cv::Mat random_image(const cv::Size& size, int type)
+{
+  cv::Mat image(size, type);
+  cv::randu(image, cv::Scalar::all(0), cv::Scalar::all(256));
+  return image;
+}
+
+// largest difference between two CHW blobs of the same size
+double max_difference(const std::vector<float>& a, const std::vector<float>& b)
+{
+  double worst = 0.0;
+  for (size_t i = 0; i < a.size(); ++i)
+    worst = std::max(worst, static_cast<double>(std::abs(a[i] - b[i])));
+  return worst;
+}
+
+} // namespace
+
+TEST_CASE(places_the_content_like_letterbox)
+{
+  yo::LetterboxTransform transform(cv::Size(1280, 720), cv::Size(640, 640));
+  CHECK(transform.content() == cv::Rect(0, 140, 640, 360));
+  CHECK_NEAR(transform.gain(), 0.5, 1e-6);
+  CHECK(transform.matches(cv::Size(1280, 720), cv::Size(640, 640)));
+  CHECK(!transform.matches(cv::Size(720, 1280), cv::Size(640, 640)));
+
+  yo::LetterboxTransform small(cv::Size(320, 240), cv::Size(640, 640), false);
+  CHECK(small.content() == cv::Rect(160, 200, 320, 240));
+}
+
+TEST_CASE(maps_boxes_and_keypoints_both_ways)
+{
+  yo::LetterboxTransform transform(cv::Size(1280, 720), cv::Size(640, 640));
+  cv::Rect_<float> source(200.0f, 100.0f, 300.0f, 150.0f);
+  cv::Rect_<float> target = transform.toTarget(source);
+  CHECK_NEAR(target.x, 100.0, 1e-4);
+  CHECK_NEAR(target.y, 190.0, 1e-4);
+  cv::Rect_<float> back = transform.toSource(target);
+  CHECK_NEAR(back.x, source.x, 1e-3);
+  CHECK_NEAR(back.y, source.y, 1e-3);
+  CHECK_NEAR(back.width, source.width, 1e-3);
+  CHECK_NEAR(back.height, source.height, 1e-3);
+
+  // [x, y, visibility] triplets, visibility is untouched and positions are clipped
+  std::vector<float> keypoints = {100.0f, 190.0f, 0.9f, 700.0f, 100.0f, 0.1f};
+  transform.toSourceCoords(keypoints);
+  CHECK_NEAR(keypoints[0], 200.0, 1e-3);
+  CHECK_NEAR(keypoints[1], 100.0, 1e-3);
+  CHECK_NEAR(keypoints[2], 0.9, 1e-6);
+  CHECK_NEAR(keypoints[3], 1279.0, 1e-3);
+  CHECK_NEAR(keypoints[4], 0.0, 1e-3);
+  CHECK_NEAR(keypoints[5], 0.1, 1e-6);
+}
+
+TEST_CASE(apply_pads_with_letterbox_gray)
+{
+  yo::LetterboxTransform transform(cv::Size(200, 100), cv::Size(128, 128));
+  cv::Mat out;
+  transform.apply(random_image(cv::Size(200, 100), CV_8UC3), out);
+  CHECK(out.size() == cv::Size(128, 128) && out.type() == CV_8UC3);
+  const cv::Rect content = transform.content();
+  CHECK(out.at<cv::Vec3b>(0, 0) == cv::Vec3b(114, 114, 114));
+  CHECK(out.at<cv::Vec3b>(content.y - 1, 64) == cv::Vec3b(114, 114, 114));
+  CHECK(out.at<cv::Vec3b>(content.y + content.height, 64) == cv::Vec3b(114, 114, 114));
+}
+
+TEST_CASE(apply_chw_matches_apply_and_fill_chw)
+{
+  // odd sizes, down- and upscaling, one and three channels
+  const std::vector<cv::Size> sources = {{517, 333}, {97, 161}, {1920, 1080}};
+  for (int type : {CV_8UC3, CV_8UC1})
+  {
+    for (const cv::Size& source : sources)
+    {
+      const cv::Size target(320, 320);
+      cv::Mat image = random_image(source, type);
+      yo::LetterboxTransform transform(source, target);
+
+      cv::Mat letterboxed;
+      transform.apply(image, letterboxed);
+      std::vector<float> expected(letterboxed.total() * letterboxed.channels());
+      yo::fill_chw(letterboxed, expected.data());
+
+      std::vector<float> fused(expected.size());
+      transform.applyChw(image, fused.data());
+      // cv::resize interpolates 8-bit images in fixed point and rounds, the fused path keeps
+      // the float interpolation: they may differ by about one gray level
+      CHECK_NEAR(max_difference(fused, expected), 0.0, 2.0 / 255.0);
+    }
+  }
+}
+
+TEST_CASE(apply_chw_is_exact_without_resizing)
+{
+  cv::Mat image = random_image(cv::Size(64, 48), CV_8UC3);
+  yo::LetterboxTransform transform(image.size(), cv::Size(64, 64));
+  cv::Mat letterboxed;
+  transform.apply(image, letterboxed);
+  std::vector<float> expected(letterboxed.total() * 3);
+  yo::fill_chw(letterboxed, expected.data());
+  std::vector<float> fused(expected.size());
+  transform.applyChw(image, fused.data());
+  CHECK_NEAR(max_difference(fused, expected), 0.0, 1e-6);
+}
+
+TEST_CASE(apply_chw_swaps_red_and_blue_like_cvt_color)
+{
+  cv::Mat image = random_image(cv::Size(301, 157), CV_8UC3);
+  yo::LetterboxTransform transform(image.size(), cv::Size(160, 160));
+  cv::Mat rgb;
+  cv::cvtColor(image, rgb, cv::COLOR_BGR2RGB);
+  std::vector<float> expected(static_cast<size_t>(160 * 160 * 3));
+  transform.applyChw(rgb, expected.data());
+  std::vector<float> swapped(expected.size());
+  transform.applyChw(image, swapped.data(), true);
+  CHECK_NEAR(max_difference(swapped, expected), 0.0, 0.0);
+}
+
+TEST_CASE(convert_yuv_honours_full_range_like_the_fused_path)
+{
+  const cv::Size size(64, 48);
+  cv::Mat nv12 = random_image(cv::Size(size.width, size.height * 3 / 2), CV_8UC1);
+  yo::YuvImage frame = yo::YuvImage::nv12(
+      nv12.data, size.width, nv12.ptr(size.height), size.width, size);
+  // the same size takes no resampling, both sample chroma of the same pixel pair
+  yo::LetterboxTransform transform(size, size);
+  for (bool full_range : {false, true})
+  {
+    frame.full_range = full_range;
+    std::vector<float> fused(static_cast<size_t>(size.area()) * 3);
+    transform.applyChw(frame, fused.data());
+    cv::Mat rgb;
+    yo::convert_yuv(frame, rgb, true);
+    std::vector<float> converted(fused.size());
+    yo::fill_chw(rgb, converted.data());
+    // cvtColor works in fixed point, the 8-bit image rounds: a couple of levels apart at most
+    CHECK_NEAR(max_difference(converted, fused), 0.0, 3.0 / 255.0);
+  }
+}
+
+int main() { return yo::test::run_all(); }
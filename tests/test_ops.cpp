@@ -0,0 +1,144 @@
+#include <utility>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include <yolov8_onnxruntime/utils/ops.h>
+
+#include "test.h"
+
+namespace yo = yolov8_onnxruntime;
+
+namespace
+{
+
+std::vector<int> nms(const std::vector<cv::Rect>& boxes,
+                     const std::vector<float>& scores,
+                     float score_threshold,
+                     float iou_threshold)
+{
+  std::vector<int> order;
+  std::vector<int> indices;
+  yo::nms_boxes(boxes, scores, score_threshold, iou_threshold, order, indices);
+  return indices;
+}
+
+} // namespace
+
+TEST_CASE(nms_keeps_the_best_of_overlapping_boxes)
+{
+  std::vector<cv::Rect> boxes = {
+      {0, 0, 10, 10}, {1, 1, 10, 10}, {50, 50, 10, 10}, {0, 0, 10, 10}};
+  std::vector<float> scores = {0.9f, 0.8f, 0.7f, 0.2f};
+  // box 1 overlaps box 0 with IoU 81 / 119, box 3 is below the score threshold
+  CHECK((nms(boxes, scores, 0.25f, 0.45f) == std::vector<int>{0, 2}));
+  // nothing overlaps enough at a high IoU threshold, results come highest score first
+  CHECK((nms(boxes, {0.7f, 0.8f, 0.9f, 0.2f}, 0.25f, 0.9f) == std::vector<int>{2, 1, 0}));
+}
+
+TEST_CASE(nms_keeps_boxes_exactly_at_the_iou_threshold)
+{
+  // IoU of the two boxes is 100 / 200
+  std::vector<cv::Rect> boxes = {{0, 0, 10, 10}, {0, 0, 10, 20}};
+  std::vector<float> scores = {0.9f, 0.8f};
+  CHECK((nms(boxes, scores, 0.0f, 0.5f) == std::vector<int>{0, 1}));
+  CHECK((nms(boxes, scores, 0.0f, 0.49f) == std::vector<int>{0}));
+}
+
+TEST_CASE(nms_breaks_score_ties_by_index)
+{
+  std::vector<cv::Rect> boxes = {{0, 0, 10, 10}, {0, 0, 10, 10}, {40, 0, 10, 10}};
+  std::vector<float> scores = {0.5f, 0.5f, 0.5f};
+  CHECK((nms(boxes, scores, 0.25f, 0.45f) == std::vector<int>{0, 2}));
+}
+
+TEST_CASE(nms_reuses_its_scratch_vectors)
+{
+  std::vector<cv::Rect> boxes = {{0, 0, 10, 10}, {50, 50, 10, 10}};
+  std::vector<float> scores = {0.9f, 0.8f};
+  std::vector<int> order;
+  std::vector<int> indices;
+  yo::nms_boxes(boxes, scores, 0.25f, 0.45f, order, indices);
+  yo::nms_boxes(boxes, scores, 0.85f, 0.45f, order, indices);
+  CHECK((indices == std::vector<int>{0}));
+  // a score threshold above every score keeps nothing
+  yo::nms_boxes(boxes, scores, 0.95f, 0.45f, order, indices);
+  CHECK(indices.empty());
+}
+
+TEST_CASE(scale_boxes_undoes_the_letterbox)
+{
+  // 1280x720 letterboxed into 640x640: gain 0.5, 140 rows of padding above
+  cv::Rect_<float> box(100.0f, 240.0f, 50.0f, 20.0f);
+  cv::Rect_<float> scaled = yo::scale_boxes(cv::Size(640, 640), box, cv::Size(1280, 720));
+  CHECK_NEAR(scaled.x, 200.0, 1e-4);
+  CHECK_NEAR(scaled.y, 200.0, 1e-4);
+  CHECK_NEAR(scaled.width, 100.0, 1e-4);
+  CHECK_NEAR(scaled.height, 40.0, 1e-4);
+}
+
+TEST_CASE(scale_boxes_takes_an_explicit_ratio_and_padding)
+{
+  cv::Rect_<float> box(30.0f, 40.0f, 10.0f, 10.0f);
+  const std::pair<float, cv::Point2f> ratio_pad(2.0f, cv::Point2f(10.0f, 20.0f));
+  cv::Rect_<float> padded =
+      yo::scale_boxes(cv::Size(640, 640), box, cv::Size(640, 640), ratio_pad);
+  CHECK_NEAR(padded.x, 10.0, 1e-4);
+  CHECK_NEAR(padded.y, 10.0, 1e-4);
+  CHECK_NEAR(padded.width, 5.0, 1e-4);
+  CHECK_NEAR(padded.height, 5.0, 1e-4);
+
+  cv::Rect_<float> unpadded =
+      yo::scale_boxes(cv::Size(640, 640), box, cv::Size(640, 640), ratio_pad, false);
+  CHECK_NEAR(unpadded.x, 15.0, 1e-4);
+  CHECK_NEAR(unpadded.y, 20.0, 1e-4);
+}
+
+TEST_CASE(scale_boxes_clips_to_the_source)
+{
+  cv::Rect_<float> box(600.0f, 600.0f, 100.0f, 100.0f);
+  cv::Rect_<float> scaled = yo::scale_boxes(cv::Size(640, 640), box, cv::Size(1280, 720));
+  CHECK_NEAR(scaled.x, 1200.0, 1e-4);
+  CHECK_NEAR(scaled.width, 80.0, 1e-4);
+  CHECK_NEAR(scaled.y, 720.0, 1e-4);
+  CHECK_NEAR(scaled.height, 0.0, 1e-4);
+}
+
+TEST_CASE(scale_coords_returns_the_scaled_keypoints)
+{
+  // same letterbox as above: gain 0.5, 140 rows of padding above
+  std::vector<float> coords = {100.0f, 240.0f, 0.9f, 700.0f, 100.0f, 0.2f};
+  const std::vector<float> original = coords;
+  std::vector<float> scaled = yo::scale_coords(cv::Size(640, 640), coords, cv::Size(1280, 720));
+  CHECK(coords == original);
+  CHECK(scaled.size() == coords.size());
+  CHECK_NEAR(scaled[0], 200.0, 1e-3);
+  CHECK_NEAR(scaled[1], 200.0, 1e-3);
+  CHECK_NEAR(scaled[2], 0.9, 1e-6);
+  // clipped to the last pixel
+  CHECK_NEAR(scaled[3], 1279.0, 1e-3);
+  CHECK_NEAR(scaled[4], 0.0, 1e-3);
+
+  yo::scale_coords_inplace(cv::Size(640, 640), coords, cv::Size(1280, 720));
+  CHECK(coords == scaled);
+}
+
+TEST_CASE(non_max_suppression_handles_heads_without_extra_features)
+{
+  // [preds, 4 + 2 classes] rows of a plain detect head: no mask coefficients or keypoints
+  cv::Mat head = (cv::Mat_<float>(3, 6) << 60, 60, 20, 20, 0.9f, 0.1f,
+                  61, 61, 20, 20, 0.1f, 0.8f,
+                  205, 205, 10, 10, 0.05f, 0.6f);
+  auto [boxes, confidences, class_ids, rest] = yo::non_max_suppression(head, 2, 6, 0.25, 0.45f);
+  CHECK((class_ids == std::vector<int>{0, 1}));
+  CHECK(boxes.size() == 2 && confidences.size() == 2);
+  CHECK(rest.empty());
+
+  // with two extra features every kept prediction carries its own
+  cv::Mat extended = (cv::Mat_<float>(1, 8) << 60, 60, 20, 20, 0.9f, 0.1f, 3, 4);
+  auto [extended_boxes, extended_confidences, extended_ids, extras] =
+      yo::non_max_suppression(extended, 2, 8, 0.25, 0.45f);
+  CHECK(extras.size() == 1 && (extras[0] == std::vector<float>{3, 4}));
+}
+
+int main() { return yo::test::run_all(); }
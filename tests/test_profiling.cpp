@@ -0,0 +1,86 @@
+// tests/data/ort_profile.json is a trimmed onnxruntime trace: a cold first run with one slow Conv,
+// two warm runs of three nodes on two providers, fence events and a node event outside any run.
+// ctest runs the tests in tests/, a build without it has to pass the fixture's path.
+#include <stdexcept>
+#include <string>
+
+#include <yolov8_onnxruntime/utils/profiling.h>
+
+#include "test.h"
+
+namespace yo = yolov8_onnxruntime;
+
+namespace
+{
+
+std::string fixture_path = "data/ort_profile.json";
+
+} // namespace
+
+TEST_CASE(skipped_runs_and_their_nodes_are_left_out)
+{
+  yo::ProfileReport report = yo::parse_ort_profile(fixture_path, 1);
+  CHECK(report.runs == 2);
+  CHECK(report.skipped_runs == 1);
+  CHECK_NEAR(report.run_total_us, 2100.0, 1e-9);
+  CHECK_NEAR(report.runMeanMs(), 1.05, 1e-9);
+  // fence events and the node after the last run are not counted
+  CHECK_NEAR(report.node_total_us, 1700.0, 1e-9);
+
+  yo::ProfileReport all = yo::parse_ort_profile(fixture_path, 0);
+  CHECK(all.runs == 3 && all.skipped_runs == 0);
+  CHECK_NEAR(all.node_total_us, 4700.0, 1e-9);
+  // more runs skipped than recorded leaves none
+  yo::ProfileReport none = yo::parse_ort_profile(fixture_path, 5);
+  CHECK(none.runs == 0 && none.skipped_runs == 3 && none.nodes.empty());
+}
+
+TEST_CASE(nodes_op_types_and_providers_are_ranked_by_time)
+{
+  yo::ProfileReport report = yo::parse_ort_profile(fixture_path, 1);
+  CHECK(report.nodes.size() == 3);
+  if (report.nodes.size() == 3)
+  {
+    CHECK(report.nodes[0].name == "/model.0/conv/Conv");
+    CHECK(report.nodes[0].op_type == "Conv");
+    CHECK(report.nodes[0].provider == "CPUExecutionProvider");
+    CHECK(report.nodes[0].calls == 2);
+    CHECK_NEAR(report.nodes[0].total_us, 900.0, 1e-9);
+    CHECK_NEAR(report.nodes[0].share, 900.0 / 1700.0, 1e-9);
+    CHECK(report.nodes[1].name == "/model.1/conv/Conv");
+    CHECK(report.nodes[2].name == "/model.0/act/Relu");
+  }
+
+  CHECK(report.op_types.size() == 2);
+  if (report.op_types.size() == 2)
+  {
+    CHECK(report.op_types[0].name == "Conv");
+    CHECK(report.op_types[0].provider == "CPUExecutionProvider,CUDAExecutionProvider");
+    CHECK(report.op_types[0].calls == 4);
+    CHECK_NEAR(report.op_types[0].total_us, 1500.0, 1e-9);
+    CHECK(report.op_types[1].name == "Relu");
+  }
+
+  CHECK(report.providers.size() == 2);
+  if (report.providers.size() == 2)
+  {
+    CHECK(report.providers[0].name == "CPUExecutionProvider");
+    CHECK_NEAR(report.providers[0].total_us, 1100.0, 1e-9);
+    CHECK(report.providers[1].name == "CUDAExecutionProvider");
+    CHECK_NEAR(report.providers[1].total_us, 600.0, 1e-9);
+  }
+}
+
+TEST_CASE(unreadable_files_and_non_traces_throw)
+{
+  CHECK_THROWS(yo::parse_ort_profile("data/missing_profile.json"), std::runtime_error);
+  CHECK_THROWS(yo::parse_ort_profile_text("{\"cat\": \"Session\"}"), std::runtime_error);
+  CHECK(yo::parse_ort_profile_text("[]").runs == 0);
+}
+
+int main(int argc, char** argv)
+{
+  if (argc > 1)
+    fixture_path = argv[1];
+  return yo::test::run_all();
+}
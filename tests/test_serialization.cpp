@@ -0,0 +1,141 @@
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <yolov8_onnxruntime/utils/json.h>
+#include <yolov8_onnxruntime/utils/serialization.h>
+
+#include "test.h"
+
+namespace yo = yolov8_onnxruntime;
+
+namespace
+{
+
+bool same_mask(const cv::Mat& a, const cv::Mat& b)
+{
+  if (a.size() != b.size() || a.type() != b.type())
+    return false;
+  return a.empty() || cv::norm(a, b, cv::NORM_INF) == 0;
+}
+
+cv::Mat rle_round_trip(const cv::Mat& mask)
+{
+  std::vector<uint32_t> counts = yo::mask_to_rle(mask);
+  return yo::rle_to_mask(counts.data(), counts.size(), mask.size());
+}
+
+} // namespace
+
+TEST_CASE(rle_encodes_row_major_runs_starting_with_background)
+{
+  cv::Mat mask = (cv::Mat_<uchar>(2, 3) << 0, 255, 1, 0, 0, 255);
+  CHECK((yo::mask_to_rle(mask) == std::vector<uint32_t>{1, 2, 2, 1}));
+
+  cv::Mat full(2, 2, CV_8UC1, cv::Scalar(255));
+  CHECK((yo::mask_to_rle(full) == std::vector<uint32_t>{0, 4}));
+  CHECK((yo::mask_to_rle(cv::Mat::zeros(2, 2, CV_8UC1)) == std::vector<uint32_t>{4}));
+  CHECK(yo::mask_to_rle(cv::Mat()).empty());
+}
+
+TEST_CASE(rle_appending_overload_keeps_earlier_runs)
+{
+  std::vector<uint32_t> counts = {7};
+  yo::mask_to_rle((cv::Mat_<uchar>(1, 3) << 255, 255, 0), counts);
+  CHECK((counts == std::vector<uint32_t>{7, 0, 2, 1}));
+}
+
+TEST_CASE(rle_round_trips_masks)
+{
+  cv::RNG rng(7);
+  for (const cv::Size& size : std::vector<cv::Size>{{1, 1}, {3, 1}, {1, 5}, {37, 19}, {160, 90}})
+  {
+    cv::Mat noise(size, CV_8UC1);
+    rng.fill(noise, cv::RNG::UNIFORM, 0, 2);
+    cv::Mat mask = noise * 255;
+    CHECK(same_mask(rle_round_trip(mask), mask));
+
+    cv::Mat blob = cv::Mat::zeros(size, CV_8UC1);
+    cv::ellipse(blob,
+                cv::Point(size.width / 2, size.height / 2),
+                cv::Size(size.width / 3 + 1, size.height / 3 + 1),
+                0.0,
+                0.0,
+                360.0,
+                cv::Scalar(255),
+                -1);
+    CHECK(same_mask(rle_round_trip(blob), blob));
+  }
+  // decoded masks are 0/255 whatever non-zero value was encoded
+  cv::Mat ones(4, 4, CV_8UC1, cv::Scalar(1));
+  CHECK(same_mask(rle_round_trip(ones), ones * 255));
+}
+
+TEST_CASE(binary_frames_round_trip_results)
+{
+  std::vector<yo::YoloResults> results(2);
+  results[0] = {3, 0.75f, cv::Rect_<float>(1.5f, 2.5f, 30.0f, 20.0f)};
+  results[0].keypoints = {10.0f, 11.0f, 0.5f};
+  results[0].mask = cv::Mat::zeros(20, 30, CV_8UC1);
+  cv::rectangle(results[0].mask, cv::Rect(5, 5, 10, 8), cv::Scalar(255), -1);
+  results[1] = {0, 0.25f, cv::Rect_<float>(100.0f, 50.0f, 8.0f, 4.0f)};
+  results[1].keypoints = {104.0f, 52.0f, 0.9f};
+
+  yo::BinaryResultWriter writer;
+  std::vector<char> frame;
+  const size_t bytes = writer.encode(results, frame);
+  yo::BinaryResultView view(frame.data(), frame.size());
+  CHECK(view.frameBytes() == bytes);
+  CHECK(view.count() == 2 && view.hasKeypoints() && view.hasMasks());
+
+  std::vector<yo::YoloResults> decoded = view.toResults();
+  CHECK(decoded.size() == results.size());
+  for (size_t i = 0; i < decoded.size() && i < results.size(); ++i)
+  {
+    CHECK(decoded[i].class_idx == results[i].class_idx);
+    CHECK(decoded[i].conf == results[i].conf);
+    CHECK(decoded[i].bbox == results[i].bbox);
+    CHECK(decoded[i].keypoints == results[i].keypoints);
+    CHECK(same_mask(decoded[i].mask, results[i].mask));
+  }
+}
+
+TEST_CASE(binary_frames_reject_bad_input)
+{
+  std::vector<yo::YoloResults> results(2);
+  results[0].keypoints = {1.0f, 2.0f, 3.0f};
+  yo::BinaryResultWriter writer;
+  std::vector<char> frame;
+  CHECK_THROWS(writer.encode(results, frame), std::invalid_argument);
+
+  results[1].keypoints = results[0].keypoints;
+  writer.encode(results, frame);
+  CHECK_THROWS(yo::BinaryResultView(frame.data(), frame.size() - 4), std::runtime_error);
+  frame[0] = 'X';
+  CHECK_THROWS(yo::BinaryResultView(frame.data(), frame.size()), std::runtime_error);
+}
+
+TEST_CASE(json_masks_decode_back)
+{
+  yo::YoloResults result{1, 0.5f, cv::Rect_<float>(0.0f, 0.0f, 6.0f, 4.0f)};
+  result.mask = cv::Mat::zeros(4, 6, CV_8UC1);
+  result.mask.row(2).setTo(255);
+  std::ostringstream os;
+  yo::write_json(os, result);
+
+  yo::JsonValue doc = yo::JsonValue::parse(os.str());
+  const yo::JsonValue* mask = doc.find("mask");
+  CHECK(mask != nullptr && mask->find("size") != nullptr && mask->find("counts") != nullptr);
+  if (mask == nullptr || mask->find("counts") == nullptr)
+    return;
+  std::vector<uint32_t> counts;
+  for (const yo::JsonValue& value : mask->find("counts")->asArray())
+    counts.push_back(static_cast<uint32_t>(value.asNumber()));
+  CHECK(same_mask(yo::rle_to_mask(counts.data(), counts.size(), result.mask.size()),
+                  result.mask));
+}
+
+int main() { return yo::test::run_all(); }